@@ -23,6 +23,7 @@ namespace ton {
 namespace adnl {
 
 void AdnlExtConnection::send_uninit(td::BufferSlice data) {
+  flush_send_buffer();
   buffered_fd_.output_buffer().append(std::move(data));
   loop();
 }
@@ -35,9 +36,19 @@ void AdnlExtConnection::send(td::BufferSlice data) {
     return;
   }
 
-  td::BufferSlice d{data.size() + 4 + 32 + 32};
-  auto S = d.as_slice();
+  // the packet is written straight to the output buffer and encrypted there later, together with the packets
+  // sent after it. The unconfirmed part of the output buffer can't be moved, so it is flushed if the packet doesn't fit
+  size_t packet_size = data_size + 4;
+  auto &output = buffered_fd_.output_buffer();
+  auto S = output.prepare_append_inplace();
+  if (S.size() < out_pending_ + packet_size) {
+    flush_send_buffer();
+    S = output.prepare_append_at_least(packet_size);
+  }
+  S.remove_prefix(out_pending_);
+  out_pending_ += packet_size;
 
+  auto begin_time = td::Clocks::monotonic();
   S.copy_from(td::Slice(reinterpret_cast<const td::uint8 *>(&data_size), 4));
   S.remove_prefix(4);
   auto Sc = S;
@@ -47,13 +58,30 @@ void AdnlExtConnection::send(td::BufferSlice data) {
   S.remove_prefix(data.size());
 
   td::sha256(Sc.truncate(32 + data.size()), S);
+  stats_.crypto_time += td::Clocks::monotonic() - begin_time;
+
+  if (out_pending_ >= MAX_SEND_BATCH_SIZE) {
+    loop();
+  } else if (!flush_scheduled_) {
+    // let the packets, which are already queued to the actor, join the batch
+    flush_scheduled_ = true;
+    td::actor::send_closure_later(self_, &AdnlExtConnection::on_net);
+  }
+}
 
-  td::BufferSlice e{d.size()};
-
-  out_ctr_.encrypt(d.as_slice(), e.as_slice());
-
-  buffered_fd_.output_buffer().append(std::move(e));
-  loop();
+void AdnlExtConnection::flush_send_buffer() {
+  if (out_pending_ == 0) {
+    return;
+  }
+  auto begin_time = td::Clocks::monotonic();
+  auto &output = buffered_fd_.output_buffer();
+  auto S = output.prepare_append_inplace().truncate(out_pending_);
+  CHECK(S.size() == out_pending_);
+  out_ctr_.encrypt(S, S);
+  output.confirm_append(out_pending_);
+  stats_.crypto_time += td::Clocks::monotonic() - begin_time;
+  stats_.bytes_sent += out_pending_;
+  out_pending_ = 0;
 }
 
 td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_loop) {
@@ -90,13 +118,30 @@ td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_l
     auto data = input.cut_head(len_).move_as_buffer_slice();
     update_timer();
 
-    td::BufferSlice dec_data{data.size()};
-    in_ctr_.encrypt(data.as_slice(), dec_data.as_slice());
+    // the packet is decrypted in place, and its checksum is computed while the decrypted chunk is still in cache
+    auto begin_time = td::Clocks::monotonic();
+    auto S = data.as_slice();
+    auto checksum_size = S.size() - 32;
+    in_sha_.init();
+    for (size_t pos = 0; pos < S.size(); pos += CRYPTO_CHUNK_SIZE) {
+      auto chunk = S.substr(pos, td::min(static_cast<size_t>(CRYPTO_CHUNK_SIZE), S.size() - pos));
+      in_ctr_.encrypt(chunk, chunk);
+      if (pos < checksum_size) {
+        in_sha_.feed(chunk.truncate(checksum_size - pos));
+      }
+    }
+    td::UInt256 checksum;
+    in_sha_.extract(as_slice(checksum));
+    stats_.crypto_time += td::Clocks::monotonic() - begin_time;
+    stats_.bytes_received += len_ + 4;
 
     exit_loop = false;
     read_len_ = false;
     len_ = 0;
-    return receive_packet(std::move(dec_data));
+    if (as_slice(checksum) != S.substr(checksum_size)) {
+      return td::Status::Error(ErrorCode::protoviolation, "sha256 mismatch");
+    }
+    return process_decrypted_packet(std::move(data));
   } else {
     if (input.size() < 256) {
       exit_loop = true;
@@ -112,6 +157,7 @@ td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_l
 }
 
 void AdnlExtConnection::loop() {
+  flush_scheduled_ = false;
   auto status = [&] {
     TRY_STATUS(buffered_fd_.flush_read());
     auto &input = buffered_fd_.input_buffer();
@@ -119,6 +165,7 @@ void AdnlExtConnection::loop() {
     while (!exit_loop) {
       TRY_STATUS(receive(input, exit_loop));
     }
+    flush_send_buffer();
     TRY_STATUS(buffered_fd_.flush_write());
     if (td::can_close(buffered_fd_)) {
       stop();
@@ -159,17 +206,8 @@ td::Status AdnlExtConnection::init_crypto(td::Slice S) {
   return td::Status::OK();
 }
 
-td::Status AdnlExtConnection::receive_packet(td::BufferSlice data) {
+td::Status AdnlExtConnection::process_decrypted_packet(td::BufferSlice data) {
   LOG(DEBUG) << "received packet of size " << data.size();
-  auto S = data.as_slice();
-  S.truncate(data.size() - 32);
-  auto D = data.as_slice();
-  D.remove_prefix(data.size() - 32);
-
-  if (td::sha256(S) != D) {
-    return td::Status::Error(ErrorCode::protoviolation, "sha256 mismatch");
-  }
-
   data.truncate(data.size() - 32);
   data.confirm_read(32);
 
@@ -187,6 +225,15 @@ td::Status AdnlExtConnection::receive_packet(td::BufferSlice data) {
   return process_packet(std::move(data));
 }
 
+void AdnlExtConnection::log_stats() const {
+  auto duration = td::max(td::Clocks::monotonic() - created_at_, 1e-9);
+  auto megabytes = static_cast<double>(stats_.bytes_sent + stats_.bytes_received) / (1 << 20);
+  LOG(DEBUG) << "connection stats: sent " << stats_.bytes_sent << " bytes ("
+             << static_cast<double>(stats_.bytes_sent) / duration << " B/s), received " << stats_.bytes_received
+             << " bytes (" << static_cast<double>(stats_.bytes_received) / duration << " B/s), crypto "
+             << (megabytes > 0 ? stats_.crypto_time * 1e6 / megabytes : 0.0) << " us/MB";
+}
+
 }  // namespace adnl
 
 }  // namespace ton
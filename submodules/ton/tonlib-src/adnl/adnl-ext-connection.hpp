@@ -21,6 +21,8 @@
 #include "td/net/TcpListener.h"
 #include "td/utils/crypto.h"
 #include "td/utils/BufferedFd.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/UInt.h"
 #include "tl-utils/tl-utils.hpp"
 #include "td/utils/Random.h"
 #include "common/errorcode.h"
@@ -52,7 +54,7 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
   void send_uninit(td::BufferSlice data);
   td::Status receive(td::ChainBufferReader &input, bool &exit_loop);
   virtual td::Status process_packet(td::BufferSlice data) = 0;
-  td::Status receive_packet(td::BufferSlice data);
+  td::Status process_decrypted_packet(td::BufferSlice data);
   virtual td::Status process_custom_packet(td::BufferSlice &data, bool &processed) = 0;
   virtual td::Status process_init_packet(td::BufferSlice data) = 0;
   virtual bool authorized() const {
@@ -82,6 +84,16 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
     }
   }
 
+  struct Stats {
+    td::uint64 bytes_sent{0};
+    td::uint64 bytes_received{0};
+    double crypto_time{0};  // seconds spent in encryption, decryption and checksums
+  };
+  const Stats &get_stats() const {
+    return stats_;
+  }
+  void log_stats() const;
+
  protected:
   td::BufferedFd<td::SocketFd> buffered_fd_;
   td::actor::ActorId<AdnlExtConnection> self_;
@@ -107,6 +119,11 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
  private:
   td::AesCtrState in_ctr_;
   td::AesCtrState out_ctr_;
+  td::Sha256State in_sha_;
+  size_t out_pending_ = 0;  // size of the packets written to the output buffer, but not encrypted yet
+  bool flush_scheduled_ = false;
+  Stats stats_;
+  double created_at_ = td::Clocks::monotonic();
   bool inited_ = false;
   bool stop_read_ = false;
   bool read_len_ = false;
@@ -116,11 +133,16 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
   td::Timestamp send_ping_at_;
   bool ping_sent_ = false;
 
+  enum : size_t { MAX_SEND_BATCH_SIZE = 1 << 16, CRYPTO_CHUNK_SIZE = 1 << 14 };
+
   void on_net() {
     loop();
   }
 
+  void flush_send_buffer();
+
   void tear_down() override {
+    log_stats();
     if (callback_) {
       callback_->on_close(actor_id(this));
       callback_ = nullptr;
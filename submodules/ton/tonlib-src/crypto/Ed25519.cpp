@@ -35,11 +35,11 @@
 #include <openssl/pem.h>
 #include <openssl/x509.h>
 
-#else
+#endif
 
 #include "crypto/ellcurve/Ed25519.h"
 
-#endif
+#include <algorithm>
 
 namespace td {
 
@@ -389,6 +389,67 @@ Result<SecureString> Ed25519::compute_shared_secret(const PublicKey &public_key,
 
 #endif
 
+namespace {
+Status verify_signature(const Ed25519::SignatureToCheck &signature) {
+  return Ed25519::PublicKey(SecureString(signature.public_key)).verify_signature(signature.data, signature.signature);
+}
+
+#if TD_HAVE_INT128
+// splits a failed batch in halves until the bad signatures are found
+void find_bad_signatures_in_batch(const crypto::Ed25519::BatchVerifier &verifier, size_t begin, size_t end,
+                                  const std::vector<size_t> &ids, Span<Ed25519::SignatureToCheck> signatures,
+                                  std::vector<size_t> &bad) {
+  if (end - begin <= 2) {
+    for (auto i = begin; i < end; i++) {
+      if (verify_signature(signatures[ids[i]]).is_error()) {
+        bad.push_back(ids[i]);
+      }
+    }
+    return;
+  }
+  if (verifier.check(begin, end)) {
+    return;
+  }
+  auto middle = begin + (end - begin) / 2;
+  find_bad_signatures_in_batch(verifier, begin, middle, ids, signatures, bad);
+  find_bad_signatures_in_batch(verifier, middle, end, ids, signatures, bad);
+}
+#endif
+}  // namespace
+
+std::vector<size_t> Ed25519::find_bad_signatures(Span<SignatureToCheck> signatures) {
+  std::vector<size_t> bad;
+#if TD_HAVE_INT128
+  crypto::Ed25519::BatchVerifier verifier;
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < signatures.size(); i++) {
+    auto &signature = signatures[i];
+    if (verifier.add(signature.public_key, signature.data, signature.signature)) {
+      ids.push_back(i);
+    } else if (verify_signature(signature).is_error()) {
+      bad.push_back(i);
+    }
+  }
+  find_bad_signatures_in_batch(verifier, 0, ids.size(), ids, signatures, bad);
+  std::sort(bad.begin(), bad.end());
+#else
+  for (size_t i = 0; i < signatures.size(); i++) {
+    if (verify_signature(signatures[i]).is_error()) {
+      bad.push_back(i);
+    }
+  }
+#endif
+  return bad;
+}
+
+Status Ed25519::verify_signatures(Span<SignatureToCheck> signatures) {
+  auto bad = find_bad_signatures(signatures);
+  if (bad.empty()) {
+    return Status::OK();
+  }
+  return verify_signature(signatures[bad[0]]).move_as_error_prefix(PSLICE() << "Signature " << bad[0] << ": ");
+}
+
 }  // namespace td
 
 #endif
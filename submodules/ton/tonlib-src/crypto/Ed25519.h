@@ -20,6 +20,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/SharedSlice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 #if TD_HAVE_OPENSSL
@@ -65,6 +66,22 @@ class Ed25519 {
   static Result<PrivateKey> generate_private_key();
 
   static Result<SecureString> compute_shared_secret(const PublicKey &public_key, const PrivateKey &private_key);
+
+  struct SignatureToCheck {
+    Slice public_key;
+    Slice data;
+    Slice signature;
+  };
+
+  // Checks the signatures in batches, which is much faster than checking them one by one.
+  // Returns the indices of the bad signatures in increasing order.
+  // The batch equation is cofactored, unlike PublicKey::verify_signature(), so a signature with a small-order
+  // component may be accepted here and rejected there. Do not use it where the result must match
+  // verify_signature() exactly, e.g. when validating block proofs.
+  static std::vector<size_t> find_bad_signatures(Span<SignatureToCheck> signatures);
+
+  // Returns the error of the first bad signature
+  static Status verify_signatures(Span<SignatureToCheck> signatures);
 };
 
 }  // namespace td
@@ -278,7 +278,13 @@ td::Result<TransactionList::Info> TransactionList::validate() const {
   if (R.is_error()) {
     return td::Status::Error("cannot deserialize transactions BoC");
   }
-  auto list = R.move_as_ok();
+  return validate(R.move_as_ok());
+}
+
+td::Result<TransactionList::Info> TransactionList::validate(std::vector<td::Ref<vm::Cell>> list) const {
+  if (blkids.empty()) {
+    return td::Status::Error("transaction list must be non-empty");
+  }
   if (list.size() != blkids.size()) {
     return td::Status::Error(PSLICE() << "transaction list size " << list.size()
                                       << " must be equal to the size of block id list " << blkids.size());
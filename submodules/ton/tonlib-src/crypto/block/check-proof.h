@@ -85,6 +85,8 @@ struct TransactionList {
   };
 
   td::Result<Info> validate() const;
+  // transactions_boc is ignored, the transactions are already deserialized
+  td::Result<Info> validate(std::vector<td::Ref<vm::Cell>> list) const;
 };
 
 }  // namespace block
@@ -344,6 +344,9 @@ class BigIntG {
     return *this;
   }
   bool normalize_bool() {
+    if (n == 1 && digits[0] >= -Tr::Half && digits[0] < Tr::Half) {
+      return true;
+    }
     return as_any_int().normalize_bool_any();
   }
   BigIntG& normalize() {
@@ -460,6 +463,14 @@ class BigIntG {
 
   template <int len2, int len3>
   bool add_mul_bool(const BigIntG<len2, Tr>& y, const BigIntG<len3, Tr>& z) {
+#if TD_HAVE_INT128
+    int128 xv, yv, zv;
+    if (has_int128_fast_path && get_int128(xv) && y.get_int128(yv) && z.get_int128(zv) && fits_int128(xv, 124) &&
+        fits_int128(yv, 62) && fits_int128(zv, 62)) {
+      set_int128(xv + yv * zv);
+      return true;
+    }
+#endif
     return as_any_int().add_mul_any(y.as_any_int(), z.as_any_int());
   }
 
@@ -503,6 +514,27 @@ class BigIntG {
 
   template <int len2, int len3>
   bool mod_div_bool(const BigIntG<len2, Tr>& y, BigIntG<len3, Tr>& quot, int round_mode = -1) {
+#if TD_HAVE_INT128
+    int128 xv, yv;
+    // the generic code leaves the quotient invalid if both operands have the same size
+    // and the top word of x is relatively small; this case is left to it
+    if (has_int128_fast_path && BigIntG<len3, Tr>::has_int128_fast_path && get_int128(xv) && y.get_int128(yv) && yv &&
+        (n != y.n || std::abs(top_word()) * 2 > std::abs(y.top_word()))) {
+      int128 q = xv / yv, r = xv % yv;
+      if (r && (r < 0) != (yv < 0)) {
+        // floor
+        q--;
+        r += yv;
+      }
+      if (round_mode > 0 ? r != 0 : !round_mode && (yv > 0 ? 2 * r >= yv : 2 * r <= yv)) {
+        q++;
+        r -= yv;
+      }
+      quot.set_int128(q);
+      set_int128(r);
+      return true;
+    }
+#endif
     auto q = quot.as_any_int();
     return as_any_int().mod_div_any(y.as_any_int(), q, round_mode);
   }
@@ -660,6 +692,39 @@ class BigIntG {
   double top_double() const {
     return n > 1 ? (double)digits[n - 1] + (double)digits[n - 2] * (1.0 / Tr::Base) : (double)digits[n - 1];
   }
+
+#if TD_HAVE_INT128
+  // Values of at most two words are handled with 128-bit arithmetic,
+  // producing the same normalized results as the generic code
+  typedef __int128 int128;
+  enum { has_int128_fast_path = len >= 128 && word_shift <= 56 };
+
+  bool get_int128(int128& x) const {
+    if (n == 1) {
+      x = digits[0];
+      return true;
+    }
+    if (n == 2) {
+      x = static_cast<int128>(digits[1]) * Tr::Base + digits[0];
+      return true;
+    }
+    return false;
+  }
+  void set_int128(int128 x) {
+    n = 0;
+    do {
+      word_t d = static_cast<word_t>(x & (Tr::Base - 1));
+      if (d >= Tr::Half) {
+        d -= Tr::Base;
+      }
+      digits[n++] = d;
+      x = (x - d) >> word_shift;
+    } while (x);
+  }
+  static bool fits_int128(int128 x, int bits) {
+    return x < (static_cast<int128>(1) << bits) && x > -(static_cast<int128>(1) << bits);
+  }
+#endif
 };
 
 template <class Tr>
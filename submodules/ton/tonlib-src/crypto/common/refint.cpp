@@ -214,8 +214,14 @@ int sgn(RefInt256 x) {
 }
 
 extern RefInt256 make_refint(long long x) {
-  auto xx = td::RefInt256{true, x};
-  xx.unique_write().normalize();
+  if (x >= -(1LL << 62) && x < (1LL << 62)) {
+    auto xx = td::RefInt256{true, x};
+    xx.unique_write().normalize();
+    return xx;
+  }
+  // normalize() cannot carry out of a single word this close to the limits of long long
+  auto xx = td::RefInt256{true, x >> BigIntInfo::word_shift};
+  xx.unique_write().mul_short(BigIntInfo::Base).add_tiny(x & (BigIntInfo::Base - 1)).normalize();
   return xx;
 }
 
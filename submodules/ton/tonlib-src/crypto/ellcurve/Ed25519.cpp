@@ -126,6 +126,94 @@ bool PublicKey::check_message_signature(const unsigned char signature[sign_bytes
   return !std::memcmp(pR1_bytes, signature, 32);
 }
 
+#if TD_HAVE_INT128
+bool BatchVerifier::add(td::Slice public_key, td::Slice message, td::Slice signature) {
+  if (public_key.size() != pubkey_bytes || signature.size() != sign_bytes ||
+      all_bytes_same(public_key.ubegin(), pubkey_bytes)) {
+    return false;
+  }
+  Item item;
+  if (!item.neg_a.import_point(public_key.ubegin()) || !item.neg_r.import_point(signature.ubegin())) {
+    return false;
+  }
+  item.neg_a.negate();
+  item.neg_r.negate();
+
+  const arith::Bignum &L = ellcurve::Ed25519().get_ell();
+  arith::Bignum S;
+  S.import_lsb(signature.ubegin() + 32, 32);
+  if (S >= L) {
+    return false;
+  }
+  std::memcpy(item.s.raw, signature.ubegin() + 32, 32);
+
+  unsigned char hash[64];
+  {
+    digest::SHA512 hasher(signature.ubegin(), 32);
+    hasher.feed(public_key.ubegin(), 32);
+    hasher.feed(message.ubegin(), message.size());
+    hasher.extract(hash);
+  }
+  arith::Bignum H;
+  H.import_lsb(hash, 64);
+  H %= L;
+  H.export_lsb(item.h.raw, 32);
+
+  items_.push_back(item);
+  return true;
+}
+
+bool BatchVerifier::check(std::size_t begin, std::size_t end) const {
+  CHECK(begin <= end && end <= items_.size());
+  auto n = end - begin;
+  if (n == 0) {
+    return true;
+  }
+  // checks [8]([sum z_i s_i]B + sum [z_i](-R_i) + sum [z_i h_i](-A_i)) = 0 for random 128-bit z_i
+  std::vector<ellcurve::Ed25519Point> points;
+  std::vector<td::UInt256> scalars;
+  points.reserve(2 * n + 1);
+  scalars.reserve(2 * n + 1);
+
+  std::vector<unsigned char> random_bytes(16 * n);
+  td::Random::secure_bytes(random_bytes.data(), random_bytes.size());
+
+  const arith::Bignum &L = ellcurve::Ed25519().get_ell();
+  arith::Bignum sum_zs{0}, z, x;
+  td::UInt256 scalar;
+  for (std::size_t i = 0; i < n; i++) {
+    auto &item = items_[begin + i];
+    z.import_lsb(random_bytes.data() + 16 * i, 16);
+    z += 1;
+
+    z.export_lsb(scalar.raw, 32);
+    points.push_back(item.neg_r);
+    scalars.push_back(scalar);
+
+    x.import_lsb(item.h.raw, 32);
+    x *= z;
+    x %= L;
+    x.export_lsb(scalar.raw, 32);
+    points.push_back(item.neg_a);
+    scalars.push_back(scalar);
+
+    x.import_lsb(item.s.raw, 32);
+    x *= z;
+    sum_zs += x;
+  }
+  sum_zs %= L;
+  sum_zs.export_lsb(scalar.raw, 32);
+  points.push_back(ellcurve::Ed25519Point::base_point());
+  scalars.push_back(scalar);
+
+  auto res = ellcurve::multi_power_point(points, scalars);
+  for (int i = 0; i < 3; i++) {
+    ellcurve::double_point(res, res);
+  }
+  return res.is_zero();
+}
+#endif
+
 // ---------------------
 class PrivateKey;
 
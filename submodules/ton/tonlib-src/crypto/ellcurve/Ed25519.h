@@ -25,6 +25,9 @@
 #include <cstring>
 
 #include "td/utils/buffer.h"
+#include "td/utils/UInt.h"
+
+#include <vector>
 
 namespace crypto {
 namespace Ed25519 {
@@ -184,5 +187,33 @@ class TempKeyGenerator {
                                  const unsigned char *rand = 0, std::size_t rand_size = 0);
 };
 
+#if TD_HAVE_INT128
+// Checks many signatures at once with a single multi-scalar multiplication over random linear combination
+// of their verification equations.
+// The equations are multiplied by the cofactor 8, so a signature that differs from a valid one only by a point
+// of small order passes the batch, while check_message_signature rejects it.
+// Signatures made by honest signers never contain such points.
+class BatchVerifier {
+ public:
+  // returns false if the signature can't be checked in a batch and must be checked individually,
+  // e.g. if it uses a non-canonical encoding
+  bool add(td::Slice public_key, td::Slice message, td::Slice signature);
+  std::size_t size() const {
+    return items_.size();
+  }
+  // checks the signatures with indices in [begin, end) using fresh random coefficients
+  bool check(std::size_t begin, std::size_t end) const;
+
+ private:
+  struct Item {
+    ellcurve::Ed25519Point neg_a;
+    ellcurve::Ed25519Point neg_r;
+    td::UInt256 s;
+    td::UInt256 h;
+  };
+  std::vector<Item> items_;
+};
+#endif
+
 }  // namespace Ed25519
 }  // namespace crypto
@@ -30,4 +30,106 @@ td::Ref<ResidueRing> Fp25519() {
   static const td::Ref<ResidueRing> Fp25519(true, P25519());
   return Fp25519;
 }
+
+#if TD_HAVE_INT128
+Residue25519::Residue25519(const Residue& x) {
+  unsigned char buffer[32];
+  x.extract().export_lsb(buffer, 32);
+  import_lsb(buffer);
+}
+
+bool Residue25519::import_lsb(const unsigned char buffer[32]) {
+  td::uint64 w[4];
+  for (int i = 0; i < 4; i++) {
+    w[i] = 0;
+    for (int j = 7; j >= 0; j--) {
+      w[i] = (w[i] << 8) | buffer[i * 8 + j];
+    }
+  }
+  v_[0] = w[0] & mask;
+  v_[1] = ((w[0] >> 51) | (w[1] << 13)) & mask;
+  v_[2] = ((w[1] >> 38) | (w[2] << 26)) & mask;
+  v_[3] = ((w[2] >> 25) | (w[3] << 39)) & mask;
+  v_[4] = (w[3] >> 12) & mask;
+  // the value is not less than P25519 iff it is at least 2^255-19, i.e. all limbs are maximal
+  return !(v_[0] >= mask - 18 && v_[1] == mask && v_[2] == mask && v_[3] == mask && v_[4] == mask);
+}
+
+void Residue25519::export_lsb(unsigned char buffer[32]) const {
+  Residue25519 x(*this);
+  x.carry();
+  // now x < 2 * P25519, subtract P25519 if x + 19 >= 2^255
+  td::uint64 q = (x.v_[0] + 19) >> 51;
+  for (int i = 1; i < 5; i++) {
+    q = (x.v_[i] + q) >> 51;
+  }
+  x.v_[0] += 19 * q;
+  for (int i = 0; i < 4; i++) {
+    x.v_[i + 1] += x.v_[i] >> 51;
+    x.v_[i] &= mask;
+  }
+  x.v_[4] &= mask;
+  td::uint64 w[4] = {x.v_[0] | (x.v_[1] << 51), (x.v_[1] >> 13) | (x.v_[2] << 38), (x.v_[2] >> 26) | (x.v_[3] << 25),
+                     (x.v_[3] >> 39) | (x.v_[4] << 12)};
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 8; j++) {
+      buffer[i * 8 + j] = static_cast<unsigned char>(w[i] >> (j * 8));
+    }
+  }
+}
+
+bool Residue25519::is_zero() const {
+  unsigned char buffer[32];
+  export_lsb(buffer);
+  unsigned char acc = 0;
+  for (auto c : buffer) {
+    acc |= c;
+  }
+  return acc == 0;
+}
+
+bool Residue25519::is_odd() const {
+  unsigned char buffer[32];
+  export_lsb(buffer);
+  return buffer[0] & 1;
+}
+
+namespace {
+Residue25519 sqr_n(Residue25519 x, int n) {
+  while (n-- > 0) {
+    x = sqr(x);
+  }
+  return x;
+}
+
+// computes x^(2^250-1) and x^11
+void pow_2_250_1(const Residue25519& x, Residue25519& x_250_0, Residue25519& x_11) {
+  auto x2 = sqr(x);
+  auto x9 = sqr_n(x2, 2) * x;
+  x_11 = x9 * x2;
+  auto x_5_0 = sqr(x_11) * x9;
+  auto x_10_0 = sqr_n(x_5_0, 5) * x_5_0;
+  auto x_20_0 = sqr_n(x_10_0, 10) * x_10_0;
+  auto x_40_0 = sqr_n(x_20_0, 20) * x_20_0;
+  auto x_50_0 = sqr_n(x_40_0, 10) * x_10_0;
+  auto x_100_0 = sqr_n(x_50_0, 50) * x_50_0;
+  auto x_200_0 = sqr_n(x_100_0, 100) * x_100_0;
+  x_250_0 = sqr_n(x_200_0, 50) * x_50_0;
+}
+}  // namespace
+
+Residue25519 inverse(const Residue25519& x) {
+  Residue25519 x_250_0, x_11;
+  pow_2_250_1(x, x_250_0, x_11);
+  // P25519 - 2 = 2^255 - 21
+  return sqr_n(x_250_0, 5) * x_11;
+}
+
+Residue25519 pow22523(const Residue25519& x) {
+  Residue25519 x_250_0, x_11;
+  pow_2_250_1(x, x_250_0, x_11);
+  // (P25519 - 5) / 8 = 2^252 - 3
+  return sqr_n(x_250_0, 2) * x;
+}
+#endif
 }  // namespace ellcurve
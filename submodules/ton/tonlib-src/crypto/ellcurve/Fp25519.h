@@ -20,6 +20,9 @@
 #include "common/refcnt.hpp"
 #include "openssl/residue.h"
 
+#include "td/utils/common.h"
+#include "td/utils/port/platform.h"
+
 namespace ellcurve {
 using namespace arith;
 
@@ -29,4 +32,112 @@ const Bignum& P25519();
 // residue ring modulo P25519
 td::Ref<ResidueRing> Fp25519();
 
+#if TD_HAVE_INT128
+// residue modulo P25519 stored in five 51-bit limbs
+// much faster than Residue, used where many field operations are needed (e.g. batch signature verification)
+class Residue25519 {
+ public:
+  Residue25519() : v_{0, 0, 0, 0, 0} {
+  }
+  explicit Residue25519(td::uint64 x) : v_{x & mask, x >> 51, 0, 0, 0} {
+  }
+  explicit Residue25519(const Residue& x);
+
+  static Residue25519 zero() {
+    return Residue25519();
+  }
+  static Residue25519 one() {
+    return Residue25519(1);
+  }
+
+  // bit 255 is ignored; returns false if the rest is not less than P25519
+  bool import_lsb(const unsigned char buffer[32]);
+  // always exports the canonical representation
+  void export_lsb(unsigned char buffer[32]) const;
+
+  bool is_zero() const;
+  // the lowest bit of the canonical representation
+  bool is_odd() const;
+  bool operator==(const Residue25519& y) const {
+    return (*this - y).is_zero();
+  }
+  bool operator!=(const Residue25519& y) const {
+    return !(*this == y);
+  }
+
+  friend Residue25519 operator+(const Residue25519& x, const Residue25519& y) {
+    Residue25519 res;
+    for (int i = 0; i < 5; i++) {
+      res.v_[i] = x.v_[i] + y.v_[i];
+    }
+    return res.carry();
+  }
+  friend Residue25519 operator-(const Residue25519& x, const Residue25519& y) {
+    // adds 4*P25519 to stay non-negative
+    Residue25519 res;
+    res.v_[0] = x.v_[0] + 0x1fffffffffffb4 - y.v_[0];
+    for (int i = 1; i < 5; i++) {
+      res.v_[i] = x.v_[i] + 0x1ffffffffffffc - y.v_[i];
+    }
+    return res.carry();
+  }
+  friend Residue25519 operator-(const Residue25519& x) {
+    return Residue25519() - x;
+  }
+  friend Residue25519 operator*(const Residue25519& x, const Residue25519& y);
+  friend Residue25519 sqr(const Residue25519& x) {
+    return x * x;
+  }
+  friend Residue25519 inverse(const Residue25519& x);
+  // x^((P25519-5)/8), used for square roots
+  friend Residue25519 pow22523(const Residue25519& x);
+
+ private:
+  static constexpr td::uint64 mask = (static_cast<td::uint64>(1) << 51) - 1;
+  // every limb is less than 2^52 between operations
+  td::uint64 v_[5];
+
+  Residue25519& carry() {
+    for (int i = 0; i < 4; i++) {
+      v_[i + 1] += v_[i] >> 51;
+      v_[i] &= mask;
+    }
+    v_[0] += (v_[4] >> 51) * 19;
+    v_[4] &= mask;
+    v_[1] += v_[0] >> 51;
+    v_[0] &= mask;
+    return *this;
+  }
+};
+
+inline Residue25519 operator*(const Residue25519& x, const Residue25519& y) {
+  using td::uint64;
+  using uint128 = unsigned __int128;
+  const uint64* a = x.v_;
+  const uint64* b = y.v_;
+  uint64 b1 = b[1] * 19, b2 = b[2] * 19, b3 = b[3] * 19, b4 = b[4] * 19;
+  uint128 r0 = (uint128)a[0] * b[0] + (uint128)a[1] * b4 + (uint128)a[2] * b3 + (uint128)a[3] * b2 + (uint128)a[4] * b1;
+  uint128 r1 = (uint128)a[0] * b[1] + (uint128)a[1] * b[0] + (uint128)a[2] * b4 + (uint128)a[3] * b3 + (uint128)a[4] * b2;
+  uint128 r2 =
+      (uint128)a[0] * b[2] + (uint128)a[1] * b[1] + (uint128)a[2] * b[0] + (uint128)a[3] * b4 + (uint128)a[4] * b3;
+  uint128 r3 =
+      (uint128)a[0] * b[3] + (uint128)a[1] * b[2] + (uint128)a[2] * b[1] + (uint128)a[3] * b[0] + (uint128)a[4] * b4;
+  uint128 r4 =
+      (uint128)a[0] * b[4] + (uint128)a[1] * b[3] + (uint128)a[2] * b[2] + (uint128)a[3] * b[1] + (uint128)a[4] * b[0];
+  r1 += static_cast<uint64>(r0 >> 51);
+  r2 += static_cast<uint64>(r1 >> 51);
+  r3 += static_cast<uint64>(r2 >> 51);
+  r4 += static_cast<uint64>(r3 >> 51);
+  Residue25519 res;
+  res.v_[0] = (static_cast<uint64>(r0) & Residue25519::mask) + static_cast<uint64>(r4 >> 51) * 19;
+  res.v_[1] = static_cast<uint64>(r1) & Residue25519::mask;
+  res.v_[2] = static_cast<uint64>(r2) & Residue25519::mask;
+  res.v_[3] = static_cast<uint64>(r3) & Residue25519::mask;
+  res.v_[4] = static_cast<uint64>(r4) & Residue25519::mask;
+  res.v_[1] += res.v_[0] >> 51;
+  res.v_[0] &= Residue25519::mask;
+  return res;
+}
+#endif
+
 }  // namespace ellcurve
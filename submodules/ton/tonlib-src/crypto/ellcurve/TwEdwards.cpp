@@ -20,6 +20,8 @@
 #include <assert.h>
 #include <cstring>
 
+#include "td/utils/logging.h"
+
 namespace ellcurve {
 using namespace arith;
 
@@ -252,4 +254,142 @@ const TwEdwardsCurve& Ed25519() {
   }();
   return Ed25519;
 }
+
+#if TD_HAVE_INT128
+namespace {
+struct Ed25519Constants {
+  Residue25519 d;
+  Residue25519 d2;
+  Residue25519 sqrt_m1;
+};
+
+const Ed25519Constants& ed25519_constants() {
+  static const Ed25519Constants constants = [] {
+    Ed25519Constants res;
+    res.d = Residue25519(Fp25519()->frac(-121665, 121666));
+    res.d2 = res.d + res.d;
+    res.sqrt_m1 = Residue25519(Fp25519()->img_i());
+    return res;
+  }();
+  return constants;
+}
+}  // namespace
+
+const Ed25519Point& Ed25519Point::base_point() {
+  static const Ed25519Point base_point = [] {
+    unsigned char buffer[32];
+    CHECK(Ed25519().get_base_point().export_point(buffer));
+    Ed25519Point res;
+    CHECK(res.import_point(buffer));
+    return res;
+  }();
+  return base_point;
+}
+
+bool Ed25519Point::import_point(const unsigned char point[32]) {
+  // recovers x from -x^2+y^2 = 1+d*x^2*y^2 as in RFC 8032, 5.1.3
+  Residue25519 y;
+  if (!y.import_lsb(point)) {
+    return false;
+  }
+  bool x_sign = point[31] >> 7;
+  auto& constants = ed25519_constants();
+  auto yy = sqr(y);
+  auto u = yy - Residue25519::one();
+  auto v = constants.d * yy + Residue25519::one();
+  auto v3 = sqr(v) * v;
+  auto x = u * v3 * pow22523(u * sqr(v3) * v);
+  auto vxx = v * sqr(x);
+  if (vxx != u) {
+    if (vxx != -u) {
+      return false;
+    }
+    x = x * constants.sqrt_m1;
+  }
+  if (x.is_zero() && x_sign) {
+    return false;
+  }
+  if (x.is_odd() != x_sign) {
+    x = -x;
+  }
+  X = x;
+  Y = y;
+  Z = Residue25519::one();
+  T = x * y;
+  return true;
+}
+
+void add_points(Ed25519Point& R, const Ed25519Point& P, const Ed25519Point& Q) {
+  // add-2008-hwcd-3, complete for Ed25519
+  auto a = (P.Y - P.X) * (Q.Y - Q.X);
+  auto b = (P.Y + P.X) * (Q.Y + Q.X);
+  auto c = P.T * ed25519_constants().d2 * Q.T;
+  auto zz = P.Z * Q.Z;
+  auto d = zz + zz;
+  auto e = b - a;
+  auto f = d - c;
+  auto g = d + c;
+  auto h = b + a;
+  R.X = e * f;
+  R.Y = g * h;
+  R.T = e * h;
+  R.Z = f * g;
+}
+
+void double_point(Ed25519Point& R, const Ed25519Point& P) {
+  // dbl-2008-hwcd with a = -1
+  auto a = sqr(P.X);
+  auto b = sqr(P.Y);
+  auto zz = sqr(P.Z);
+  auto c = zz + zz;
+  auto h = -(a + b);
+  auto e = sqr(P.X + P.Y) + h;
+  auto g = b - a;
+  auto f = g - c;
+  R.X = e * f;
+  R.Y = g * h;
+  R.T = e * h;
+  R.Z = f * g;
+}
+
+// Pippenger's bucket method: every window of c bits costs one addition per point and 2^(c+1) additions for buckets
+Ed25519Point multi_power_point(td::Span<Ed25519Point> points, td::Span<td::UInt256> scalars) {
+  CHECK(points.size() == scalars.size());
+  auto n = points.size();
+  int c = n < 16 ? 3 : n < 64 ? 4 : n < 256 ? 5 : n < 1024 ? 6 : n < 4096 ? 7 : 8;
+  auto get_digit = [c](const td::UInt256& scalar, int pos) {
+    int i = pos >> 3;
+    unsigned x = scalar.raw[i];
+    if (i + 1 < 32) {
+      x |= static_cast<unsigned>(scalar.raw[i + 1]) << 8;
+    }
+    return (x >> (pos & 7)) & ((1u << c) - 1);
+  };
+
+  Ed25519Point res;
+  std::vector<Ed25519Point> buckets(static_cast<size_t>(1) << c);
+  for (int pos = (255 / c) * c; pos >= 0; pos -= c) {
+    for (int i = 0; i < c; i++) {
+      double_point(res, res);
+    }
+    for (auto& bucket : buckets) {
+      bucket = Ed25519Point();
+    }
+    for (size_t i = 0; i < n; i++) {
+      auto digit = get_digit(scalars[i], pos);
+      if (digit != 0) {
+        add_points(buckets[digit], buckets[digit], points[i]);
+      }
+    }
+    // sum of [j]buckets[j]
+    Ed25519Point running, sum;
+    for (size_t j = buckets.size() - 1; j > 0; j--) {
+      add_points(running, running, buckets[j]);
+      add_points(sum, sum, running);
+    }
+    add_points(res, res, sum);
+  }
+  return res;
+}
+#endif
 }  // namespace ellcurve
@@ -53,6 +53,14 @@ Ref<WordDef> CtxTailWord::run_tail(IntCtx& ctx) const {
   return f(ctx);
 }
 
+//
+// LiteralWord
+//
+Ref<WordDef> LiteralWord::run_tail(IntCtx& ctx) const {
+  ctx.stack.push(value);
+  return {};
+}
+
 //
 // WordList
 //
@@ -63,11 +71,13 @@ WordList::WordList(const std::vector<Ref<WordDef>>& _list) : list(_list) {
 }
 
 WordList& WordList::push_back(Ref<WordDef> word_def) {
+  threaded.clear();
   list.push_back(std::move(word_def));
   return *this;
 }
 
 WordList& WordList::push_back(WordDef& wd) {
+  threaded.clear();
   list.emplace_back(&wd);
   return *this;
 }
@@ -76,6 +86,9 @@ Ref<WordDef> WordList::run_tail(IntCtx& ctx) const {
   if (list.empty()) {
     return {};
   }
+  if (threaded.size() == list.size()) {
+    return run_threaded(ctx);
+  }
   auto it = list.cbegin(), it2 = list.cend() - 1;
   while (it < it2) {
     (*it)->run(ctx);
@@ -84,15 +97,68 @@ Ref<WordDef> WordList::run_tail(IntCtx& ctx) const {
   return *it;
 }
 
+Ref<WordDef> WordList::run_threaded(IntCtx& ctx) const {
+  auto it = threaded.cbegin(), it2 = threaded.cend() - 1;
+  while (it < it2) {
+    it->run(ctx);
+    ++it;
+  }
+  if (it->kind == ThreadedOp::Generic) {
+    // keep the tail call so that tail-recursive definitions do not grow the native stack
+    return list.back();
+  }
+  it->run(ctx);
+  return {};
+}
+
 void WordList::close() {
   list.shrink_to_fit();
+  threaded.clear();
+  threaded.reserve(list.size());
+  for (const auto& word_def : list) {
+    threaded.emplace_back(word_def.get());
+  }
 }
 
 WordList& WordList::append(const std::vector<Ref<WordDef>>& other) {
+  threaded.clear();
   list.insert(list.end(), other.begin(), other.end());
   return *this;
 }
 
+WordList::ThreadedOp::ThreadedOp(const WordDef* word_def) : kind(Generic), def(word_def) {
+  if (auto literal_word = dynamic_cast<const LiteralWord*>(word_def)) {
+    kind = Literal;
+    literal = &literal_word->get_value();
+  } else if (auto stack_word = dynamic_cast<const StackWord*>(word_def)) {
+    if (auto func = stack_word->get_func().target<void (*)(vm::Stack&)>()) {
+      kind = StackFunc;
+      stack_func = *func;
+    }
+  } else if (auto ctx_word = dynamic_cast<const CtxWord*>(word_def)) {
+    if (auto func = ctx_word->get_func().target<void (*)(IntCtx&)>()) {
+      kind = CtxFunc;
+      ctx_func = *func;
+    }
+  }
+}
+
+void WordList::ThreadedOp::run(IntCtx& ctx) const {
+  switch (kind) {
+    case Literal:
+      ctx.stack.push(*literal);
+      break;
+    case StackFunc:
+      stack_func(ctx.stack);
+      break;
+    case CtxFunc:
+      ctx_func(ctx);
+      break;
+    default:
+      def->run(ctx);
+  }
+}
+
 //
 // WordRef
 //
@@ -129,11 +195,45 @@ bool WordRef::is_active() const {
 // Dictionary
 //
 WordRef* Dictionary::lookup(td::Slice name) {
-  auto it = words_.find(name);
-  if (it == words_.end()) {
+  auto it = index_.find(name);
+  if (it == index_.end()) {
     return nullptr;
   }
-  return &it->second;
+  return it->second;
+}
+
+WordRef* Dictionary::lookup_prefix(td::Slice word, std::size_t* prefix_size) {
+  auto res = lookup(td::Slice());
+  *prefix_size = 0;
+  for (std::size_t i = 1; i <= word.size(); i++) {
+    auto prefix = word.substr(0, i);
+    if (prefix_word_prefixes_.find(prefix) == prefix_word_prefixes_.end()) {
+      break;
+    }
+    auto entry = lookup(prefix);
+    if (entry) {
+      res = entry;
+      *prefix_size = i;
+    }
+  }
+  return res;
+}
+
+void Dictionary::add_prefix_word(td::Slice name, int delta) {
+  if (name.empty() || name.back() == ' ') {
+    return;
+  }
+  for (std::size_t i = 1; i <= name.size(); i++) {
+    auto prefix = name.substr(0, i);
+    auto it = prefix_word_prefixes_.find(prefix);
+    if (it == prefix_word_prefixes_.end()) {
+      it = prefix_word_prefixes_.emplace(prefix.str(), 0).first;
+    }
+    it->second += delta;
+    if (it->second == 0) {
+      prefix_word_prefixes_.erase(it);
+    }
+  }
 }
 
 void Dictionary::def_ctx_word(std::string name, CtxWordFunc func) {
@@ -156,6 +256,8 @@ void Dictionary::def_ctx_tail_word(std::string name, CtxTailWordFunc func) {
 void Dictionary::def_word(std::string name, WordRef word) {
   auto res = words_.emplace(name, std::move(word));
   LOG_IF(FATAL, !res.second) << "Cannot redefine word: " << name;
+  index_.emplace(res.first->first, &res.first->second);
+  add_prefix_word(res.first->first, 1);
 }
 
 void Dictionary::undef_word(td::Slice name) {
@@ -163,6 +265,8 @@ void Dictionary::undef_word(td::Slice name) {
   if (it == words_.end()) {
     return;
   }
+  add_prefix_word(it->first, -1);
+  index_.erase(it->first);
   words_.erase(it);
 }
 
@@ -20,6 +20,7 @@
 
 #include <functional>
 #include <map>
+#include <unordered_map>
 
 #include "IntCtx.h"
 
@@ -59,6 +60,9 @@ class StackWord : public WordDef {
   }
   ~StackWord() override = default;
   Ref<WordDef> run_tail(IntCtx& ctx) const override;
+  const StackWordFunc& get_func() const {
+    return f;
+  }
 };
 
 class CtxWord : public WordDef {
@@ -69,6 +73,9 @@ class CtxWord : public WordDef {
   }
   ~CtxWord() override = default;
   Ref<WordDef> run_tail(IntCtx& ctx) const override;
+  const CtxWordFunc& get_func() const {
+    return f;
+  }
 };
 
 typedef std::function<Ref<WordDef>(IntCtx&)> CtxTailWordFunc;
@@ -83,8 +90,38 @@ class CtxTailWord : public WordDef {
   Ref<WordDef> run_tail(IntCtx& ctx) const override;
 };
 
+// pushes a constant value onto the stack; used for compiled literals
+class LiteralWord : public WordDef {
+  vm::StackEntry value;
+
+ public:
+  LiteralWord(vm::StackEntry _value) : value(std::move(_value)) {
+  }
+  ~LiteralWord() override = default;
+  Ref<WordDef> run_tail(IntCtx& ctx) const override;
+  const vm::StackEntry& get_value() const {
+    return value;
+  }
+};
+
 class WordList : public WordDef {
+  // threaded code built by close(): words with a plain function or a literal are dispatched without
+  // virtual calls and std::function indirection; pointers are kept alive by the Refs in list
+  struct ThreadedOp {
+    enum Kind : unsigned char { Generic, Literal, StackFunc, CtxFunc } kind;
+    union {
+      const WordDef* def;
+      const vm::StackEntry* literal;
+      void (*stack_func)(vm::Stack&);
+      void (*ctx_func)(IntCtx&);
+    };
+    ThreadedOp(const WordDef* word_def);
+    void run(IntCtx& ctx) const;
+  };
   std::vector<Ref<WordDef>> list;
+  std::vector<ThreadedOp> threaded;
+
+  Ref<WordDef> run_threaded(IntCtx& ctx) const;
 
  public:
   ~WordList() override = default;
@@ -150,6 +187,8 @@ WordRef::WordRef(std::vector<Ref<WordDef>>&& word_list) : def(Ref<WordList>{true
 class Dictionary {
  public:
   WordRef* lookup(td::Slice name);
+  // finds the longest prefix of word (maybe empty) that is defined as a prefix word, i.e. without a trailing space
+  WordRef* lookup_prefix(td::Slice word, std::size_t* prefix_size);
   void def_ctx_word(std::string name, CtxWordFunc func);
   void def_ctx_tail_word(std::string name, CtxTailWordFunc func);
   void def_active_word(std::string name, CtxWordFunc func);
@@ -168,6 +207,12 @@ class Dictionary {
 
  private:
   std::map<std::string, WordRef, std::less<>> words_;
+  // hash index of words_, keys point to the strings owned by words_
+  std::unordered_map<td::Slice, WordRef*, td::SliceHash> index_;
+  // number of prefix words starting with the key, so lookup_prefix can stop as soon as no prefix word can match
+  std::map<std::string, int, std::less<>> prefix_word_prefixes_;
+
+  void add_prefix_word(td::Slice name, int delta);
 };
 
 /*
@@ -214,10 +214,6 @@ void interpret_const(vm::Stack& stack, long long val) {
   stack.push_smallint(val);
 }
 
-void interpret_big_const(vm::Stack& stack, td::RefInt256 val) {
-  stack.push_int(std::move(val));
-}
-
 void interpret_literal(vm::Stack& stack, vm::StackEntry se) {
   stack.push(std::move(se));
 }
@@ -1280,6 +1276,8 @@ void interpret_is_eqv(vm::Stack& stack) {
   stack.push_bool(are_eqv(std::move(x), std::move(y)));
 }
 
+// compares values by identity; integers kept inline in vm::StackEntry (-2^62..2^62-1) have no identity
+// and are compared by value, so that 1 1 eq? is true, while 1 62 << 1 62 << eq? is false
 void interpret_is_eq(vm::Stack& stack) {
   auto y = stack.pop(), x = stack.pop();
   stack.push_bool(x == y);
@@ -2388,18 +2386,15 @@ void do_compile(vm::Stack& stack, Ref<WordDef> word_def) {
 }
 
 void compile_one_literal(WordList& wlist, vm::StackEntry val) {
-  using namespace std::placeholders;
   if (val.type() == vm::StackEntry::t_int) {
     auto x = std::move(val).as_int();
     if (!x->signed_fits_bits(257)) {
       throw IntError{"invalid numeric literal"};
-    } else if (x->signed_fits_bits(td::BigIntInfo::word_shift)) {
-      wlist.push_back(Ref<StackWord>{true, std::bind(interpret_const, _1, x->to_long())});
     } else {
-      wlist.push_back(Ref<StackWord>{true, std::bind(interpret_big_const, _1, std::move(x))});
+      wlist.push_back(Ref<LiteralWord>{true, std::move(x)});
     }
   } else {
-    wlist.push_back(Ref<StackWord>{true, std::bind(interpret_literal, _1, std::move(val))});
+    wlist.push_back(Ref<LiteralWord>{true, std::move(val)});
   }
 }
 
@@ -2829,28 +2824,25 @@ int funny_interpret_loop(IntCtx& ctx) {
       if (!*ptr) {
         break;
       }
-      std::string Word;
-      Word.reserve(128);
-      auto entry = ctx.dictionary->lookup("");
-      std::string entry_word;
-      const char* ptr_end = ptr;
-      while (*ptr && *ptr != ' ' && *ptr != '\t') {
-        Word += *ptr++;
-        auto cur = ctx.dictionary->lookup(Word);
-        if (cur) {
-          entry = cur;
-          entry_word = Word;
-          ptr_end = ptr;
-        }
+      const char* word_end = ptr;
+      while (*word_end && *word_end != ' ' && *word_end != '\t') {
+        ++word_end;
       }
-      auto cur = ctx.dictionary->lookup(Word + " ");
+      std::string Word;
+      Word.reserve(word_end - ptr + 1);
+      Word.append(ptr, word_end);
+      std::size_t prefix_size;
+      auto entry = ctx.dictionary->lookup_prefix(Word, &prefix_size);
+      Word += ' ';
+      auto cur = ctx.dictionary->lookup(Word);
+      Word.pop_back();
       if (cur || !entry) {
-        entry = std::move(cur);
-        ctx.set_input(ptr);
+        entry = cur;
+        ctx.set_input(word_end);
         ctx.skipspc();
       } else {
-        Word = entry_word;
-        ctx.set_input(ptr_end);
+        Word.resize(prefix_size);
+        ctx.set_input(ptr + prefix_size);
       }
       try {
         if (entry) {
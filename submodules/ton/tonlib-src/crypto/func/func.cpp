@@ -29,15 +29,105 @@
 #include "parser/srcread.h"
 #include "parser/lexer.h"
 #include "parser/symtable.h"
+#include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
 #include <getopt.h>
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
 
 namespace funC {
 
-int verbosity, indent, opt_level = 2;
-bool stack_layout_comments, op_rewrite_comments, program_envelope, asm_preamble;
+int verbosity, indent, opt_level = 2, threads = 1;
+bool stack_layout_comments, op_rewrite_comments, program_envelope, asm_preamble, show_timings;
 std::ostream* outs = &std::cout;
-std::string generated_from, boc_output_filename;
+std::string generated_from, boc_output_filename, cache_dir;
+
+/*
+ * 
+ *   COMPILATION STATISTICS
+ * 
+ */
+
+std::vector<std::pair<std::string, double>> phase_timings;
+int cache_hits, cache_misses;
+
+struct PhaseTimer {
+  const char* name;
+  std::chrono::steady_clock::time_point started_at = std::chrono::steady_clock::now();
+  explicit PhaseTimer(const char* _name) : name(_name) {
+  }
+  ~PhaseTimer() {
+    std::chrono::duration<double, std::milli> passed = std::chrono::steady_clock::now() - started_at;
+    phase_timings.emplace_back(name, passed.count());
+  }
+};
+
+void print_timings(std::ostream& os) {
+  os << "timings:";
+  double total = 0;
+  for (const auto& phase : phase_timings) {
+    os << ' ' << phase.first << ' ' << phase.second << "ms,";
+    total += phase.second;
+  }
+  os << " total " << total << "ms (" << threads << " codegen threads)";
+  if (!cache_dir.empty()) {
+    os << "; cache: " << cache_hits << " hits, " << cache_misses << " misses";
+  }
+  os << std::endl;
+}
+
+/*
+ * 
+ *   COMPILATION CACHE
+ * 
+ */
+
+// Code generated for a function depends on its analyzed code, on the functions it calls, on code generation
+// flags and on the compiler itself. Called asm functions are compiled into the caller, so their bodies are a part
+// of the key. Called FunC functions are referenced by name, but their flags choose between CALLDICT
+// and INLINECALLDICT, so the flags and method ids are a part of the key too. Builtins are a part of the compiler.
+
+// must be changed whenever the generated code may change, because cached code from older compilers is reused otherwise
+const char* const cache_version = "func-cache-2";
+
+void collect_calls(const Op* op, std::set<SymDef*>& res) {
+  for (; op; op = op->next.get()) {
+    if (op->fun_ref) {
+      res.insert(op->fun_ref);
+    }
+    collect_calls(op->block0.get(), res);
+    collect_calls(op->block1.get(), res);
+  }
+}
+
+std::string compute_cache_key(const CodeBlob& code, int mode) {
+  std::ostringstream os;
+  os << cache_version << ' ' << mode << ' ' << indent + 1 << ' ' << op_rewrite_comments << '\n';
+  code.print(os, 2 | 4 | 8);
+  std::set<SymDef*> calls;
+  collect_calls(code.ops.get(), calls);
+  for (auto sym : calls) {
+    if (auto asm_func = dynamic_cast<const SymValAsmFunc*>(sym->value)) {
+      if (!asm_func->asm_source.empty()) {
+        os << sym->name() << " asm " << asm_func->asm_source << '\n';
+      }
+    } else if (auto code_func = dynamic_cast<const SymValCodeFunc*>(sym->value)) {
+      os << sym->name() << " flags " << code_func->flags << " method_id "
+         << (code_func->method_id.is_null() ? std::string("none") : code_func->method_id->to_dec_string()) << '\n';
+    }
+  }
+  return td::buffer_to_hex(td::sha256(os.str()));
+}
+
+std::string cache_file_path(const std::string& key) {
+  return cache_dir + TD_DIR_SLASH + key + ".fif";
+}
 
 /*
  * 
@@ -45,69 +135,108 @@ std::string generated_from, boc_output_filename;
  * 
  */
 
-void generate_output_func(SymDef* func_sym) {
-  SymValCodeFunc* func_val = dynamic_cast<SymValCodeFunc*>(func_sym->value);
+struct FuncOutput {
+  SymDef* func_sym{nullptr};
+  CodeBlob* code{nullptr};
+  int mode{0};
+  std::string cache_key;
+  bool from_cache{false};
+  std::string text;
+  std::string error;
+};
+
+// analyzes the function; it modifies shared type expressions, so it must be done sequentially
+void prepare_output_func(FuncOutput& res) {
+  SymValCodeFunc* func_val = dynamic_cast<SymValCodeFunc*>(res.func_sym->value);
   assert(func_val);
-  std::string name = sym::symbols.get_name(func_sym->sym_idx);
+  std::string name = sym::symbols.get_name(res.func_sym->sym_idx);
   if (verbosity >= 2) {
     std::cerr << "\n\n=========================\nfunction " << name << " : " << func_val->get_type() << std::endl;
   }
   if (!func_val->code) {
-    std::cerr << "( function `" << name << "` undefined )\n";
-  } else {
-    CodeBlob& code = *(func_val->code);
-    if (verbosity >= 3) {
-      code.print(std::cerr, 9);
+    return;
+  }
+  CodeBlob& code = *(func_val->code);
+  if (verbosity >= 3) {
+    code.print(std::cerr, 9);
+  }
+  code.simplify_var_types();
+  if (verbosity >= 5) {
+    std::cerr << "after simplify_var_types: \n";
+    code.print(std::cerr, 0);
+  }
+  code.prune_unreachable_code();
+  if (verbosity >= 5) {
+    std::cerr << "after prune_unreachable: \n";
+    code.print(std::cerr, 0);
+  }
+  code.split_vars(true);
+  if (verbosity >= 5) {
+    std::cerr << "after split_vars: \n";
+    code.print(std::cerr, 0);
+  }
+  for (int i = 0; i < 8; i++) {
+    code.compute_used_code_vars();
+    if (verbosity >= 4) {
+      std::cerr << "after compute_used_vars: \n";
+      code.print(std::cerr, 6);
     }
-    code.simplify_var_types();
+    code.fwd_analyze();
     if (verbosity >= 5) {
-      std::cerr << "after simplify_var_types: \n";
-      code.print(std::cerr, 0);
+      std::cerr << "after fwd_analyze: \n";
+      code.print(std::cerr, 6);
     }
     code.prune_unreachable_code();
     if (verbosity >= 5) {
       std::cerr << "after prune_unreachable: \n";
-      code.print(std::cerr, 0);
+      code.print(std::cerr, 6);
     }
-    code.split_vars(true);
-    if (verbosity >= 5) {
-      std::cerr << "after split_vars: \n";
-      code.print(std::cerr, 0);
-    }
-    for (int i = 0; i < 8; i++) {
-      code.compute_used_code_vars();
-      if (verbosity >= 4) {
-        std::cerr << "after compute_used_vars: \n";
-        code.print(std::cerr, 6);
-      }
-      code.fwd_analyze();
-      if (verbosity >= 5) {
-        std::cerr << "after fwd_analyze: \n";
-        code.print(std::cerr, 6);
-      }
-      code.prune_unreachable_code();
-      if (verbosity >= 5) {
-        std::cerr << "after prune_unreachable: \n";
-        code.print(std::cerr, 6);
-      }
-    }
-    code.mark_noreturn();
-    if (verbosity >= 3) {
-      code.print(std::cerr, 15);
-    }
-    if (verbosity >= 2) {
-      std::cerr << "\n---------- resulting code for " << name << " -------------\n";
+  }
+  code.mark_noreturn();
+  if (verbosity >= 3) {
+    code.print(std::cerr, 15);
+  }
+  res.code = &code;
+  res.mode =
+      (stack_layout_comments ? Stack::_StkCmt | Stack::_CptStkCmt : 0) | (opt_level < 2 ? Stack::_DisableOpt : 0);
+  if (!cache_dir.empty()) {
+    res.cache_key = compute_cache_key(code, res.mode);
+  }
+}
+
+// generates and optimizes code of an analyzed function; may be run for several functions in parallel
+void generate_output_func(FuncOutput& res) {
+  try {
+    std::ostringstream os;
+    res.code->generate_code(os, res.mode, indent + 1);
+    res.text = os.str();
+  } catch (src::Error& err) {
+    std::ostringstream os;
+    os << err;
+    res.error = os.str();
+  }
+}
+
+void generate_output_funcs(std::vector<FuncOutput>& funcs) {
+  std::vector<FuncOutput*> queue;
+  for (auto& func : funcs) {
+    if (func.code && !func.from_cache) {
+      queue.push_back(&func);
     }
-    bool inline_ref = (func_val->flags & 2);
-    *outs << std::string(indent * 2, ' ') << name << " PROC" << (inline_ref ? "REF" : "") << ":<{\n";
-    code.generate_code(
-        *outs,
-        (stack_layout_comments ? Stack::_StkCmt | Stack::_CptStkCmt : 0) | (opt_level < 2 ? Stack::_DisableOpt : 0),
-        indent + 1);
-    *outs << std::string(indent * 2, ' ') << "}>\n";
-    if (verbosity >= 2) {
-      std::cerr << "--------------\n";
+  }
+  std::atomic<std::size_t> next{0};
+  auto worker = [&] {
+    for (std::size_t i; (i = next.fetch_add(1)) < queue.size();) {
+      generate_output_func(*queue[i]);
     }
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads && (std::size_t)i < queue.size(); i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : workers) {
+    thread.join();
   }
 }
 
@@ -130,14 +259,71 @@ int generate_output() {
       *outs << func_val->method_id << " DECLMETHOD " << name << "\n";
     }
   }
+  std::vector<FuncOutput> funcs;
+  funcs.reserve(glob_func.size());
+  {
+    PhaseTimer timer{"analyze"};
+    for (SymDef* func_sym : glob_func) {
+      funcs.emplace_back();
+      funcs.back().func_sym = func_sym;
+      try {
+        prepare_output_func(funcs.back());
+      } catch (src::Error& err) {
+        std::ostringstream os;
+        os << err;
+        funcs.back().error = os.str();
+        funcs.back().code = nullptr;
+      }
+    }
+  }
+  if (!cache_dir.empty()) {
+    PhaseTimer timer{"cache lookup"};
+    for (auto& func : funcs) {
+      if (!func.code) {
+        continue;
+      }
+      auto r_text = td::read_file_str(cache_file_path(func.cache_key));
+      if (r_text.is_ok()) {
+        func.text = r_text.move_as_ok();
+        func.from_cache = true;
+        ++cache_hits;
+      } else {
+        ++cache_misses;
+      }
+    }
+  }
+  {
+    PhaseTimer timer{"codegen"};
+    generate_output_funcs(funcs);
+  }
+  PhaseTimer timer{"output"};
   int errors = 0;
-  for (SymDef* func_sym : glob_func) {
-    try {
-      generate_output_func(func_sym);
-    } catch (src::Error& err) {
-      std::cerr << "cannot generate code for function `" << sym::symbols.get_name(func_sym->sym_idx) << "`:\n"
-                << err << std::endl;
+  for (auto& func : funcs) {
+    std::string name = sym::symbols.get_name(func.func_sym->sym_idx);
+    if (!func.error.empty()) {
+      std::cerr << "cannot generate code for function `" << name << "`:\n" << func.error << std::endl;
       ++errors;
+      continue;
+    }
+    if (!func.code) {
+      std::cerr << "( function `" << name << "` undefined )\n";
+      continue;
+    }
+    if (verbosity >= 2) {
+      std::cerr << "\n---------- resulting code for " << name << " -------------\n";
+    }
+    bool inline_ref = (dynamic_cast<SymValCodeFunc*>(func.func_sym->value)->flags & 2);
+    *outs << std::string(indent * 2, ' ') << name << " PROC" << (inline_ref ? "REF" : "") << ":<{\n";
+    *outs << func.text;
+    *outs << std::string(indent * 2, ' ') << "}>\n";
+    if (verbosity >= 2) {
+      std::cerr << "--------------\n";
+    }
+    if (!func.from_cache && !cache_dir.empty()) {
+      auto status = td::atomic_write_file(cache_file_path(func.cache_key), func.text);
+      if (status.is_error() && verbosity >= 1) {
+        std::cerr << "cannot store code of function `" << name << "` in cache: " << status.to_string() << std::endl;
+      }
     }
   }
   if (program_envelope) {
@@ -154,7 +340,8 @@ int generate_output() {
 void usage(const char* progname) {
   std::cerr
       << "usage: " << progname
-      << " [-vIAPSR][-O<level>][-i<indent-spc>][-o<output-filename>][-W<boc-filename>] {<func-source-filename> ...}\n"
+      << " [-vIAPSRT][-O<level>][-i<indent-spc>][-o<output-filename>][-W<boc-filename>][-j<threads>][-C<cache-dir>] "
+         "{<func-source-filename> ...}\n"
          "\tGenerates Fift TVM assembler code from a funC source\n"
          "-I\tEnables interactive mode (parse stdin)\n"
          "-o<fift-output-filename>\tWrites generated code into specified file instead of stdout\n"
@@ -166,7 +353,10 @@ void usage(const char* progname) {
          "-S\tInclude stack layout comments in the output code\n"
          "-R\tInclude operation rewrite comments in the output code\n"
          "-W<output-boc-file>\tInclude Fift code to serialize and save generated code into specified BoC file. Enables "
-         "-A and -P.\n";
+         "-A and -P.\n"
+         "-j<threads>\tGenerates and optimizes code of independent functions in parallel\n"
+         "-C<cache-dir>\tReuses code generated for functions by previous runs, keeping it in the specified directory\n"
+         "-T\tPrints time spent in each compilation phase into stderr\n";
   std::exit(2);
 }
 
@@ -175,14 +365,20 @@ std::string output_filename;
 int main(int argc, char* const argv[]) {
   int i;
   bool interactive = false;
-  while ((i = getopt(argc, argv, "Ahi:Io:O:PRSvW:")) != -1) {
+  while ((i = getopt(argc, argv, "AC:hi:Ij:o:O:PRSTvW:")) != -1) {
     switch (i) {
       case 'A':
         funC::asm_preamble = true;
         break;
+      case 'C':
+        funC::cache_dir = optarg;
+        break;
       case 'I':
         interactive = true;
         break;
+      case 'j':
+        funC::threads = std::max(1, atoi(optarg));
+        break;
       case 'i':
         funC::indent = std::max(0, atoi(optarg));
         break;
@@ -201,6 +397,9 @@ int main(int argc, char* const argv[]) {
       case 'S':
         funC::stack_layout_comments = true;
         break;
+      case 'T':
+        funC::show_timings = true;
+        break;
       case 'v':
         ++funC::verbosity;
         break;
@@ -221,17 +420,24 @@ int main(int argc, char* const argv[]) {
   funC::define_keywords();
   funC::define_builtins();
 
+  if (!funC::cache_dir.empty()) {
+    td::mkpath(funC::cache_dir + TD_DIR_SLASH).ignore();
+  }
+
   int ok = 0, proc = 0;
   try {
-    while (optind < argc) {
-      funC::generated_from += std::string{"`"} + argv[optind] + "` ";
-      ok += funC::parse_source_file(argv[optind++]);
-      proc++;
-    }
-    if (interactive) {
-      funC::generated_from += "stdin ";
-      ok += funC::parse_source_stdin();
-      proc++;
+    {
+      funC::PhaseTimer timer{"parse"};
+      while (optind < argc) {
+        funC::generated_from += std::string{"`"} + argv[optind] + "` ";
+        ok += funC::parse_source_file(argv[optind++]);
+        proc++;
+      }
+      if (interactive) {
+        funC::generated_from += "stdin ";
+        ok += funC::parse_source_stdin();
+        proc++;
+      }
     }
     if (ok < proc) {
       throw src::Fatal{"output code generation omitted because of errors"};
@@ -249,6 +455,9 @@ int main(int argc, char* const argv[]) {
       funC::outs = fs.get();
     }
     funC::generate_output();
+    if (funC::show_timings) {
+      funC::print_timings(std::cerr);
+    }
   } catch (src::Fatal& fatal) {
     std::cerr << "fatal: " << fatal << std::endl;
     std::exit(1);
@@ -19,6 +19,7 @@
 #include "func.h"
 #include "td/utils/crypto.h"
 #include <fstream>
+#include <sstream>
 
 namespace sym {
 
@@ -923,6 +924,8 @@ SymValAsmFunc* parse_asm_func_body(Lexer& lex, TypeExpr* func_type, const Formal
   }
   std::vector<AsmOp> asm_ops;
   std::vector<int> arg_order, ret_order;
+  std::ostringstream asm_source;
+  asm_source << cnt << ' ' << width << " :";
   if (lex.tp() == '(') {
     lex.expect('(');
     if (lex.tp() != _Mapsto) {
@@ -947,6 +950,7 @@ SymValAsmFunc* parse_asm_func_body(Lexer& lex, TypeExpr* func_type, const Formal
         visited[j] = true;
         int c1 = cum_arg_width[j], c2 = cum_arg_width[j + 1];
         while (c1 < c2) {
+          asm_source << ' ' << c1;
           arg_order.push_back(c1++);
         }
         lex.next();
@@ -965,6 +969,7 @@ SymValAsmFunc* parse_asm_func_body(Lexer& lex, TypeExpr* func_type, const Formal
           lex.cur().error("expected integer return value index 0 .. width-1");
         }
         visited[j] = true;
+        asm_source << " r" << j;
         ret_order.push_back(j);
         lex.next();
       }
@@ -972,6 +977,7 @@ SymValAsmFunc* parse_asm_func_body(Lexer& lex, TypeExpr* func_type, const Formal
     lex.expect(')');
   }
   while (lex.tp() == _String) {
+    asm_source << '\n' << lex.cur().str;
     asm_ops.push_back(AsmOp::Parse(lex.cur().str, cnt, width));
     lex.next();
     if (asm_ops.back().is_custom()) {
@@ -985,6 +991,7 @@ SymValAsmFunc* parse_asm_func_body(Lexer& lex, TypeExpr* func_type, const Formal
   auto res = new SymValAsmFunc{func_type, asm_ops, impure};
   res->arg_order = std::move(arg_order);
   res->ret_order = std::move(ret_order);
+  res->asm_source = asm_source.str();
   return res;
 }
 
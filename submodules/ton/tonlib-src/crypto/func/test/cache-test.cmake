@@ -0,0 +1,30 @@
+# Checks that code of a function cached by `func -C` is not reused after a function it calls changes.
+# Run as cmake -DFUNC=<func binary> -DWORK_DIR=<dir> -P cache-test.cmake
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/cache")
+
+function(compile_with_cache NAME CALLEE_SPEC)
+  file(WRITE "${WORK_DIR}/${NAME}.fc"
+    "int callee(int x) ${CALLEE_SPEC} { return x + 1; }\n"
+    "int caller(int x) { return callee(x) * 2; }\n")
+  execute_process(COMMAND "${FUNC}" -o "${WORK_DIR}/${NAME}.ref.fif" "${WORK_DIR}/${NAME}.fc" RESULT_VARIABLE res)
+  if (NOT res EQUAL 0)
+    message(FATAL_ERROR "func failed for ${NAME}")
+  endif()
+  execute_process(COMMAND "${FUNC}" -C "${WORK_DIR}/cache" -o "${WORK_DIR}/${NAME}.fif" "${WORK_DIR}/${NAME}.fc"
+    RESULT_VARIABLE res)
+  if (NOT res EQUAL 0)
+    message(FATAL_ERROR "func -C failed for ${NAME}")
+  endif()
+  file(READ "${WORK_DIR}/${NAME}.ref.fif" expected)
+  file(READ "${WORK_DIR}/${NAME}.fif" got)
+  if (NOT expected STREQUAL got)
+    message(FATAL_ERROR "cached code differs for ${NAME}:\n${got}\nexpected:\n${expected}")
+  endif()
+endfunction()
+
+compile_with_cache(inline "inline")
+compile_with_cache(not_inline "")
+compile_with_cache(inline_again "inline")
+compile_with_cache(inline_ref "inline_ref")
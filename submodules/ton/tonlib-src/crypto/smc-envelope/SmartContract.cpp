@@ -25,8 +25,13 @@
 #include "vm/cellslice.h"
 #include "vm/cp0.h"
 #include "vm/continuation.h"
+#include "vm/cells/CellArena.h"
 
 #include "td/utils/crypto.h"
+#include "td/utils/port/thread.h"
+
+#include <atomic>
+#include <map>
 
 namespace ton {
 namespace {
@@ -68,11 +73,31 @@ td::Ref<vm::Tuple> prepare_vm_c7() {
   return vm::make_tuple_ref(std::move(tuple));
 }
 
-SmartContract::Answer run_smartcont(SmartContract::State state, td::Ref<vm::Stack> stack, td::Ref<vm::Tuple> c7,
-                                    vm::GasLimits gas, bool ignore_chksig) {
-  auto gas_credit = gas.gas_credit;
+void init_vm() {
   vm::init_op_cp0();
   vm::DictionaryBase::get_empty_dictionary();
+}
+
+void prepare_get_method_args(SmartContract::Args& args) {
+  if (!args.limits) {
+    args.limits = vm::GasLimits{1000000};
+  }
+  if (!args.stack) {
+    args.stack = td::Ref<vm::Stack>(true);
+  }
+  CHECK(args.method_id);
+  args.stack.value().write().push_smallint(args.method_id.unwrap());
+}
+
+SmartContract::Answer run_smartcont(SmartContract::State state, td::Ref<vm::CellSlice> code,
+                                    SmartContract::Args args) {
+  auto gas = args.limits.unwrap();
+  auto gas_credit = gas.gas_credit;
+  init_vm();
+  std::unique_ptr<vm::CellArena> arena;
+  if (args.use_cell_arena) {
+    arena = std::make_unique<vm::CellArena>();
+  }
 
   class Logger : public td::LogInterface {
    public:
@@ -94,9 +119,10 @@ SmartContract::Answer run_smartcont(SmartContract::State state, td::Ref<vm::Stac
   }
 
   SmartContract::Answer res;
-  vm::VmState vm{state.code, std::move(stack), gas, 1, state.data, log};
-  vm.set_c7(std::move(c7));
-  vm.set_chksig_always_succeed(ignore_chksig);
+  vm::VmState vm{std::move(code), args.stack.unwrap(), gas, 1, state.data, log};
+  vm.set_c7(args.c7.unwrap());
+  vm.set_chksig_always_succeed(args.ignore_chksig);
+  vm.set_profiler(args.profiler);
   try {
     res.code = ~vm.run();
   } catch (...) {
@@ -157,8 +183,7 @@ SmartContract::Answer SmartContract::run_method(Args args) {
   CHECK(args.stack);
   CHECK(args.method_id);
   args.stack.value().write().push_smallint(args.method_id.unwrap());
-  auto res =
-      run_smartcont(get_state(), args.stack.unwrap(), args.c7.unwrap(), args.limits.unwrap(), args.ignore_chksig);
+  auto res = run_smartcont(get_state(), vm::VmState::convert_code_cell(get_state().code), std::move(args));
   state_ = res.new_state;
   return res;
 }
@@ -167,21 +192,59 @@ SmartContract::Answer SmartContract::run_get_method(Args args) const {
   if (!args.c7) {
     args.c7 = prepare_vm_c7();
   }
-  if (!args.limits) {
-    args.limits = vm::GasLimits{1000000};
-  }
-  if (!args.stack) {
-    args.stack = td::Ref<vm::Stack>(true);
-  }
-  CHECK(args.method_id);
-  args.stack.value().write().push_smallint(args.method_id.unwrap());
-  return run_smartcont(get_state(), args.stack.unwrap(), args.c7.unwrap(), args.limits.unwrap(), args.ignore_chksig);
+  prepare_get_method_args(args);
+  return run_smartcont(get_state(), vm::VmState::convert_code_cell(get_state().code), std::move(args));
 }
 
 SmartContract::Answer SmartContract::run_get_method(td::Slice method, Args args) const {
   return run_get_method(args.set_method_id(method));
 }
 
+std::vector<SmartContract::Answer> SmartContract::run_get_methods(std::vector<BatchQuery> queries, size_t threads_n) {
+  // everything shared by the queries is created here, before the workers are started
+  init_vm();
+  auto c7 = prepare_vm_c7();
+  std::map<vm::CellHash, td::Ref<vm::CellSlice>> code_by_hash;
+  std::vector<td::Ref<vm::CellSlice>> codes(queries.size());
+  for (size_t i = 0; i < queries.size(); i++) {
+    auto& query = queries[i];
+    if (!query.args.c7) {
+      query.args.c7 = c7;
+    }
+    prepare_get_method_args(query.args);
+    if (query.state.code.not_null()) {
+      auto& code = code_by_hash[query.state.code->get_hash()];
+      if (code.is_null()) {
+        code = vm::VmState::convert_code_cell(query.state.code);
+      }
+      codes[i] = code;
+    }
+  }
+
+  std::vector<Answer> answers(queries.size());
+  std::atomic<size_t> next_query{0};
+  auto worker = [&] {
+    while (true) {
+      auto i = next_query.fetch_add(1, std::memory_order_relaxed);
+      if (i >= queries.size()) {
+        break;
+      }
+      auto& args = queries[i].args;
+      answers[i] = run_smartcont(std::move(queries[i].state), std::move(codes[i]), std::move(args));
+    }
+  };
+  threads_n = td::min(threads_n, queries.size());
+  std::vector<td::thread> threads;
+  for (size_t i = 1; i < threads_n; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return answers;
+}
+
 SmartContract::Answer SmartContract::send_external_message(td::Ref<vm::Cell> cell, Args args) {
   return run_method(args.set_stack(prepare_vm_stack(vm::load_cell_slice_ref(cell))).set_method_id(-1));
 }
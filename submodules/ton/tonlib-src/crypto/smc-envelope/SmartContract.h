@@ -56,6 +56,8 @@ class SmartContract : public td::CntObject {
     td::optional<td::Ref<vm::Tuple>> c7;
     td::optional<td::Ref<vm::Stack>> stack;
     bool ignore_chksig{false};
+    vm::VmProfiler* profiler{nullptr};
+    bool use_cell_arena{false};
 
     Args() {
     }
@@ -90,11 +92,31 @@ class SmartContract : public td::CntObject {
       this->ignore_chksig = ignore_chksig;
       return std::move(*this);
     }
+    Args&& set_profiler(vm::VmProfiler* profiler) {
+      this->profiler = profiler;
+      return std::move(*this);
+    }
+    // runs the VM inside a vm::CellArena
+    Args&& set_use_cell_arena(bool use_cell_arena) {
+      this->use_cell_arena = use_cell_arena;
+      return std::move(*this);
+    }
+  };
+
+  struct BatchQuery {
+    State state;
+    Args args;
   };
 
   Answer run_method(Args args = {});
   Answer run_get_method(Args args = {}) const;
   Answer run_get_method(td::Slice method, Args args = {}) const;
+  // Runs the get methods of all queries on threads_n threads, including the calling one; answers are in query order.
+  // Code shared by several contracts is loaded once, and the default c7 is built once for the whole batch.
+  // A profiler may be attached to at most one of the queries.
+  // The threads are started by each call and joined before it returns; starting a thread costs tens of microseconds,
+  // about as much as a simple get method, so batches of a few queries per thread should be run with threads_n = 1.
+  static std::vector<Answer> run_get_methods(std::vector<BatchQuery> queries, size_t threads_n = 1);
   Answer send_external_message(td::Ref<vm::Cell> cell, Args args = {});
 
   size_t code_size() const;
@@ -17,8 +17,11 @@
     Copyright 2017-2019 Telegram Systems LLP
 */
 #include "crypto/Ed25519.h"
+#include "crypto/ellcurve/Ed25519.h"
+#include "td/utils/benchmark.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/tests.h"
 #include "td/utils/JsonBuilder.h"
@@ -149,6 +152,9 @@ TEST(Crypto, ed25519) {
 
 TEST(Crypto, wycheproof) {
   std::vector<std::pair<std::string, std::string>> bad_tests;
+  std::vector<std::string> keys;
+  std::vector<std::pair<std::string, std::string>> messages;
+  std::vector<bool> is_valid;
   auto json_str = wycheproof_ed25519();
   auto value = td::json_decode(json_str).move_as_ok();
   auto &root = value.get_object();
@@ -195,8 +201,23 @@ TEST(Crypto, wycheproof) {
       if (result != has_result) {
         bad_tests.push_back({id, comment});
       }
+      keys.push_back(pk.as_octet_string().as_slice().str());
+      messages.emplace_back(msg, sig);
+      is_valid.push_back(td::Slice(has_result) == "valid");
     }
   }
+
+  // batch verification must find exactly the signatures rejected by verify_signature
+  std::vector<td::Ed25519::SignatureToCheck> to_check;
+  std::vector<size_t> expected_bad;
+  for (size_t i = 0; i < keys.size(); i++) {
+    to_check.push_back({keys[i], messages[i].first, messages[i].second});
+    if (!is_valid[i]) {
+      expected_bad.push_back(i);
+    }
+  }
+  CHECK(td::Ed25519::find_bad_signatures(to_check) == expected_bad);
+
   if (bad_tests.empty()) {
     return;
   }
@@ -217,3 +238,163 @@ TEST(Crypto, almost_zero) {
     }
   }
 }
+
+#if TD_HAVE_INT128
+TEST(Crypto, residue25519) {
+  auto &ring = *ellcurve::Fp25519();
+  auto random_residue = [&] {
+    unsigned char buffer[32];
+    td::Random::secure_bytes(buffer, 32);
+    arith::Bignum x;
+    x.import_lsb(buffer, 32);
+    return ring.convert(x);
+  };
+  auto same = [](const ellcurve::Residue25519 &x, const arith::Residue &y) {
+    unsigned char buffer_x[32], buffer_y[32];
+    x.export_lsb(buffer_x);
+    y.extract().export_lsb(buffer_y, 32);
+    return std::memcmp(buffer_x, buffer_y, 32) == 0;
+  };
+  for (int i = 0; i < 1000; i++) {
+    auto a = random_residue();
+    auto b = i % 10 == 0 ? ring.convert(-(i / 10)) : random_residue();
+    ellcurve::Residue25519 x(a), y(b);
+    CHECK(same(x, a));
+    CHECK(same(x + y, a + b));
+    CHECK(same(x - y, a - b));
+    CHECK(same(-x, -a));
+    CHECK(same(x * y, a * b));
+    CHECK(same(sqr(x - y) * (x + y), sqr(a - b) * (a + b)));
+    CHECK(same(inverse(y), inverse(b)));
+    CHECK((x == y) == (a == b));
+  }
+
+  unsigned char buffer[32];
+  std::memset(buffer, 0xff, 32);
+  ellcurve::Residue25519 x;
+  CHECK(!x.import_lsb(buffer));
+  buffer[0] = 0xec;  // 2^255-20
+  CHECK(x.import_lsb(buffer));
+  CHECK(same(x, ring.convert(-1)));
+  buffer[0] = 0xed;  // 2^255-19
+  CHECK(!x.import_lsb(buffer));
+}
+
+TEST(Crypto, ed25519_multi_power_point) {
+  auto &E = ellcurve::Ed25519();
+  std::vector<ellcurve::Ed25519Point> points;
+  std::vector<td::UInt256> scalars;
+  auto expected = E.get_base_point();
+  for (int n = 0; n < 40; n++) {
+    td::UInt256 scalar;
+    td::Random::secure_bytes(scalar.raw, 32);
+    scalar.raw[31] &= 0x0f;
+    arith::Bignum k;
+    k.import_lsb(scalar.raw, 32);
+    auto point = E.power_gen(k + n);
+
+    unsigned char buffer[32];
+    CHECK(point.export_point(buffer));
+    ellcurve::Ed25519Point fast_point;
+    CHECK(fast_point.import_point(buffer));
+    points.push_back(fast_point);
+    scalars.push_back(scalar);
+    expected = n == 0 ? E.power_point(point, k) : E.add_points(expected, E.power_point(point, k));
+
+    auto result = ellcurve::multi_power_point(points, scalars);
+    unsigned char expected_buffer[32];
+    CHECK(expected.export_point(expected_buffer));
+    ellcurve::Ed25519Point expected_point;
+    CHECK(expected_point.import_point(expected_buffer));
+    CHECK(result.X * expected_point.Z == expected_point.X * result.Z);
+    CHECK(result.Y * expected_point.Z == expected_point.Y * result.Z);
+  }
+}
+#endif
+
+namespace {
+struct SignedMessages {
+  std::vector<td::SecureString> keys;
+  std::vector<std::string> messages;
+  std::vector<td::SecureString> signatures;
+
+  explicit SignedMessages(size_t n, size_t key_count) {
+    std::vector<td::Ed25519::PrivateKey> private_keys;
+    for (size_t i = 0; i < key_count; i++) {
+      private_keys.push_back(td::Ed25519::generate_private_key().move_as_ok());
+    }
+    for (size_t i = 0; i < n; i++) {
+      auto &private_key = private_keys[i % key_count];
+      keys.push_back(private_key.get_public_key().move_as_ok().as_octet_string());
+      messages.push_back(td::rand_string('a', 'z', td::Random::fast(0, 100)));
+      signatures.push_back(private_key.sign(messages.back()).move_as_ok());
+    }
+  }
+
+  std::vector<td::Ed25519::SignatureToCheck> to_check() const {
+    std::vector<td::Ed25519::SignatureToCheck> res;
+    for (size_t i = 0; i < keys.size(); i++) {
+      res.push_back({keys[i], messages[i], signatures[i]});
+    }
+    return res;
+  }
+};
+}  // namespace
+
+TEST(Crypto, ed25519_batch) {
+  for (size_t n : {0, 1, 2, 3, 10, 100}) {
+    SignedMessages signed_messages(n, 7);
+    CHECK(td::Ed25519::find_bad_signatures(signed_messages.to_check()).empty());
+    td::Ed25519::verify_signatures(signed_messages.to_check()).ensure();
+    if (n == 0) {
+      continue;
+    }
+
+    std::vector<size_t> expected_bad;
+    for (size_t i = 0; i < n; i++) {
+      if (td::Random::fast(0, 9) == 0 || i + 1 == n) {
+        auto &signature = signed_messages.signatures[i];
+        signature.as_mutable_slice()[td::Random::fast(0, 63)] ^= static_cast<char>(1 << td::Random::fast(0, 7));
+        expected_bad.push_back(i);
+      }
+    }
+    CHECK(td::Ed25519::find_bad_signatures(signed_messages.to_check()) == expected_bad);
+    td::Ed25519::verify_signatures(signed_messages.to_check()).ensure_error();
+  }
+}
+
+class BenchEd25519Verify : public td::Benchmark {
+ public:
+  BenchEd25519Verify(size_t batch_size, bool use_batch)
+      : signed_messages_(batch_size, batch_size), use_batch_(use_batch) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "Ed25519 verify " << signed_messages_.keys.size() << " signatures "
+                     << (use_batch_ ? "in a batch" : "one by one");
+  }
+  void run(int n) override {
+    auto to_check = signed_messages_.to_check();
+    for (int i = 0; i < n; i++) {
+      if (use_batch_) {
+        CHECK(td::Ed25519::find_bad_signatures(to_check).empty());
+      } else {
+        for (auto &signature : to_check) {
+          td::Ed25519::PublicKey(td::SecureString(signature.public_key))
+              .verify_signature(signature.data, signature.signature)
+              .ensure();
+        }
+      }
+    }
+  }
+
+ private:
+  SignedMessages signed_messages_;
+  bool use_batch_;
+};
+
+TEST(Crypto, BenchEd25519Verify) {
+  for (size_t batch_size : {4, 16, 64, 256}) {
+    td::bench(BenchEd25519Verify(batch_size, false));
+    td::bench(BenchEd25519Verify(batch_size, true));
+  }
+}
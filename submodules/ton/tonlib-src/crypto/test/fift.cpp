@@ -20,6 +20,7 @@
 #include "fift/Fift.h"
 #include "fift/utils.h"
 
+#include "td/utils/benchmark.h"
 #include "td/utils/tests.h"
 #include "td/utils/PathView.h"
 #include "td/utils/port/path.h"
@@ -110,3 +111,137 @@ TEST(Fift, test_sort) {
 TEST(Fift, test_sort2) {
   run_fift("sort2.fif");
 }
+
+int run_word(const fift::WordRef* word) {
+  CHECK(word);
+  fift::IntCtx ctx;
+  (*word)(ctx);
+  return ctx.stack.pop_smallint_range(1000);
+}
+
+TEST(Fift, DictionaryLookup) {
+  fift::Dictionary dict;
+  auto word = [](int x) { return fift::WordRef(fift::StackWordFunc([x](vm::Stack& stack) { stack.push_smallint(x); })); };
+  dict.def_word("ab", word(1));
+  dict.def_word("abc", word(2));
+  dict.def_word("abcd ", word(3));
+  dict.def_word("x ", word(4));
+
+  ASSERT_EQ(3, run_word(dict.lookup("abcd ")));
+  ASSERT_EQ(4, run_word(dict.lookup("x ")));
+  ASSERT_EQ(2, run_word(dict.lookup("abc")));
+  ASSERT_TRUE(dict.lookup("abcd") == nullptr);
+  ASSERT_TRUE(dict.lookup("y ") == nullptr);
+  ASSERT_TRUE(dict.lookup("") == nullptr);
+
+  // only words without a trailing space are prefix words
+  std::size_t prefix_size = 100;
+  ASSERT_EQ(2, run_word(dict.lookup_prefix("abcdef", &prefix_size)));
+  ASSERT_EQ(3u, prefix_size);
+  ASSERT_EQ(1, run_word(dict.lookup_prefix("abx", &prefix_size)));
+  ASSERT_EQ(2u, prefix_size);
+  ASSERT_TRUE(dict.lookup_prefix("a", &prefix_size) == nullptr);
+  ASSERT_EQ(0u, prefix_size);
+  ASSERT_TRUE(dict.lookup_prefix("x", &prefix_size) == nullptr);
+  ASSERT_EQ(0u, prefix_size);
+
+  // the empty word is the fallback for any word
+  dict.def_word("", word(5));
+  ASSERT_EQ(5, run_word(dict.lookup_prefix("zzz", &prefix_size)));
+  ASSERT_EQ(0u, prefix_size);
+
+  // a forgotten word is removed both from the index and from the prefix table
+  dict.undef_word("abc");
+  ASSERT_TRUE(dict.lookup("abc") == nullptr);
+  ASSERT_EQ(1, run_word(dict.lookup_prefix("abcdef", &prefix_size)));
+  ASSERT_EQ(2u, prefix_size);
+  dict.undef_word("ab");
+  ASSERT_EQ(5, run_word(dict.lookup_prefix("abcdef", &prefix_size)));
+  ASSERT_EQ(0u, prefix_size);
+  dict.def_word("abc", word(6));
+  ASSERT_EQ(6, run_word(dict.lookup_prefix("abcdef", &prefix_size)));
+  ASSERT_EQ(3u, prefix_size);
+  ASSERT_EQ(3, run_word(dict.lookup("abcd ")));
+}
+
+TEST(Fift, ThreadedCode) {
+  // redefined and forgotten words do not change already compiled words
+  auto res = fift::mem_run_fift(
+                 "{ 1 } : one { one 2 + } : three three .\n"
+                 "{ 10 } : one three . one .\n"
+                 "forget one three .\n"
+                 "{ 42 } :_ Ans { 100 } :_ Answer { 7 } : Ansx\n"
+                 "Ans7 + . Answer1 + . Ansx . Ans .\n"
+                 "{ Ans7 Answer1 \"!\" } : prefixes prefixes type . . . .\n"
+                 "{ dup 0> { 1- @' countdown } { drop } cond } : countdown 1000 countdown .s\n")
+                 .move_as_ok();
+  ASSERT_EQ("3 3 10 3 49 101 7 42 !1 100 7 42 \n", res.output);
+
+  // a word list is run correctly after it is modified after close
+  void (*add)(vm::Stack&) = [](vm::Stack& stack) {
+    auto y = stack.pop_int();
+    stack.push_int(stack.pop_int() + y);
+  };
+  fift::StackWordFunc add_twice = [add](vm::Stack& stack) {
+    add(stack);
+    add(stack);
+  };
+  td::Ref<fift::WordList> list{true};
+  list.write().push_back(td::Ref<fift::LiteralWord>{true, td::make_refint(1)});
+  list.write().push_back(td::Ref<fift::LiteralWord>{true, td::make_refint(2)});
+  list.write().push_back(td::Ref<fift::StackWord>{true, add});
+  auto run = [&] {
+    fift::IntCtx ctx;
+    list->run(ctx);
+    return ctx.stack.pop_smallint_range(1000);
+  };
+  list.write().close();
+  ASSERT_EQ(3, run());
+  list.write().push_back(td::Ref<fift::LiteralWord>{true, td::make_refint(10)});
+  list.write().push_back(td::Ref<fift::LiteralWord>{true, td::make_refint(20)});
+  list.write().push_back(td::Ref<fift::StackWord>{true, add_twice});
+  ASSERT_EQ(33, run());
+  list.write().close();
+  ASSERT_EQ(33, run());
+  list.write().append({td::Ref<fift::LiteralWord>{true, td::make_refint(100)}, td::Ref<fift::StackWord>{true, add}});
+  ASSERT_EQ(133, run());
+}
+
+TEST(Fift, IsEq) {
+  // eq? compares integers kept inline in vm::StackEntry (all integers in the range -2^62..2^62-1) by value,
+  // and all other values, including larger integers, by identity
+  auto res = fift::mem_run_fift(
+                 "1 dup eq? . 1 1 eq? . 1 1 eqv? .\n"
+                 "true true eq? . false 0 eq? .\n"
+                 "1 62 << dup eq? . 1 62 << 1 62 << eq? .\n"
+                 "\"a\" dup eq? . \"a\" \"a\" eq? . \"a\" \"a\" eqv? .\n")
+                 .move_as_ok();
+  ASSERT_EQ("-1 -1 -1 -1 -1 -1 0 -1 0 -1 ", res.output);
+}
+
+class BenchAsmWallets : public td::Benchmark {
+ public:
+  BenchAsmWallets() {
+    source_ = "\"Asm.fif\" include\n";
+    for (auto name : {"simple-wallet-code", "wallet-code", "wallet3-code", "highload-wallet-code",
+                      "highload-wallet-v2-code", "restricted-wallet2-code", "multisig-code"}) {
+      source_ += td::read_file_str(current_dir() + "../smartcont/auto/" + name + ".fif").move_as_ok();
+      source_ += " drop\n";
+    }
+  }
+  std::string get_description() const override {
+    return "assemble wallet contracts with Asm.fif";
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      fift::mem_run_fift(source_).ensure();
+    }
+  }
+
+ private:
+  std::string source_;
+};
+
+TEST(Fift, BenchAsmWallets) {
+  td::bench(BenchAsmWallets());
+}
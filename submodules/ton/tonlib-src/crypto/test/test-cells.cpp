@@ -33,6 +33,7 @@
 #include "common/util.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "vm/cells/CellArena.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
@@ -196,6 +197,53 @@ void test_bitstring_fill(unsigned n, unsigned p, unsigned k) {
   ASSERT_EQ(td::to_binary(bs), s);
 }
 
+TEST(Cells, CellArena) {
+  auto create_tree = [] {
+    std::vector<td::Ref<vm::Cell>> cells;
+    for (int i = 0; i < 300; i++) {
+      vm::CellBuilder cb;
+      cb.store_long(i % 100, 13);
+      if (!cells.empty()) {
+        cb.store_ref(cells[(i * 7) % cells.size()]);
+      }
+      cells.push_back(cb.finalize());
+    }
+    vm::CellBuilder cb;
+    for (size_t i = 0; i < 4; i++) {
+      cb.store_ref(cells[cells.size() - 1 - i]);
+    }
+    return cb.finalize();
+  };
+
+  auto expected = create_tree();
+  td::Ref<vm::Cell> root;
+  {
+    vm::CellArena arena;
+    root = create_tree();
+    ASSERT_EQ(expected->get_hash(), root->get_hash());
+    ASSERT_EQ(expected->get_depth(), root->get_depth());
+    ASSERT_TRUE(arena.get_stats().cells_reused > 0);
+    ASSERT_EQ(301, arena.get_stats().cells_created + arena.get_stats().cells_reused);
+
+    vm::CellBuilder cb1;
+    vm::CellBuilder cb2;
+    auto c1 = cb1.store_bytes("Hello, world!", 13).store_ref(root).finalize();
+    auto c2 = cb2.store_bytes("Hello, world!", 13).store_ref(root).finalize();
+    ASSERT_TRUE(c1.get() == c2.get());
+    ASSERT_TRUE(cb1.store_bytes("Hello, world?", 13).finalize().get() != c1.get());
+  }
+  // the cells outlive the arena
+  ASSERT_EQ(expected->get_hash(), root->get_hash());
+  auto expected_child = vm::CellSlice(vm::NoVm(), expected).prefetch_ref(0);
+  auto child = vm::CellSlice(vm::NoVm(), root).prefetch_ref(0);
+  ASSERT_EQ(vm::CellSlice(vm::NoVm(), expected_child).fetch_ulong(13), vm::CellSlice(vm::NoVm(), child).fetch_ulong(13));
+
+  vm::CellArena arena{false};
+  ASSERT_EQ(expected->get_hash(), create_tree()->get_hash());
+  ASSERT_EQ(301, arena.get_stats().cells_created);
+  ASSERT_EQ(0, arena.get_stats().cells_reused);
+}
+
 TEST(Bitstrings, main) {
   os = create_ss();
   auto test = td::BitSlice{(const unsigned char*)"test", 32};
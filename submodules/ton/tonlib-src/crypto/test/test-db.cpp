@@ -729,6 +729,195 @@ TEST(TonDb, BocMultipleRoots) {
   }
 };
 
+TEST(TonDb, BocParallelSerialize) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 20; t++) {
+    auto cells = gen_random_cells(rnd.fast(1, 10), rnd.fast(vm::BagOfCells::parallel_min_cells, 20000), rnd);
+    auto mode = get_random_serialization_mode(rnd);
+    auto serialized = serialize_boc(cells, mode);
+    for (int threads : {2, 3, 8}) {
+      auto parallel_serialized = vm::std_boc_serialize_multi_parallel(cells, mode, threads).move_as_ok();
+      ASSERT_EQ(serialized, parallel_serialized.as_slice().str());
+    }
+  }
+};
+
+TEST(TonDb, BocChunkedDeserialize) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 200; t++) {
+    auto cells = gen_random_cells(rnd.fast(1, 10), rnd.fast(1, 1000), rnd);
+    auto mode = get_random_serialization_mode(rnd);
+    auto serialized = serialize_boc(cells, mode);
+    auto expected = deserialize_boc_multiple(serialized);
+
+    BagOfCellsChunkedDeserializer deserializer;
+    td::Slice data = serialized;
+    while (!data.empty()) {
+      auto chunk_size = std::min(data.size(), static_cast<size_t>(rnd.fast(1, 1000)));
+      deserializer.add_data(data.substr(0, chunk_size)).ensure();
+      data.remove_prefix(chunk_size);
+    }
+    auto loaded_cells = deserializer.finish().move_as_ok();
+    ASSERT_EQ(expected.size(), loaded_cells.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_EQ(expected[i]->get_hash(), loaded_cells[i]->get_hash());
+    }
+
+    BagOfCellsChunkedDeserializer truncated;
+    truncated.add_data(td::Slice(serialized).substr(0, rnd.fast(0, (int)serialized.size() - 1))).ensure();
+    ASSERT_TRUE(truncated.finish().is_error());
+  }
+
+  // parents precede children, so every cell of a chain is pending until the last one arrives
+  auto get_max_pending_cells = [](Ref<Cell> root) {
+    BagOfCellsChunkedDeserializer deserializer;
+    auto serialized = serialize_boc(root);
+    for (auto c : serialized) {
+      deserializer.add_data(td::Slice(&c, 1)).ensure();
+    }
+    CHECK(deserializer.finish().move_as_ok()[0]->get_hash() == root->get_hash());
+    return deserializer.get_max_pending_cells();
+  };
+  Ref<Cell> chain = CellBuilder().store_long(0, 32).finalize();
+  for (int i = 1; i < 100; i++) {
+    chain = CellBuilder().store_long(i, 32).store_ref(chain).finalize();
+  }
+  ASSERT_EQ(99u, get_max_pending_cells(chain));
+  CellBuilder cb;
+  for (int i = 0; i < 4; i++) {
+    cb.store_ref(CellBuilder().store_long(i, 32).finalize());
+  }
+  ASSERT_EQ(1u, get_max_pending_cells(cb.finalize()));
+};
+
+TEST(TonDb, BocChunkedDeserializeFile) {
+  td::Random::Xorshift128plus rnd{123};
+  td::CSlice boc_path = "chunked_boc.boc";
+  auto check = [](const std::vector<Ref<Cell>>& expected, const std::vector<Ref<Cell>>& loaded) {
+    ASSERT_EQ(expected.size(), loaded.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      ASSERT_EQ(expected[i]->get_hash(), loaded[i]->get_hash());
+    }
+  };
+  for (int t = 0; t < 50; t++) {
+    auto cells = gen_random_cells(rnd.fast(2, 10), rnd.fast(1, 1000), rnd);
+    auto serialized = serialize_boc(cells, get_random_serialization_mode(rnd));
+    auto expected = deserialize_boc_multiple(serialized);
+    td::unlink(boc_path).ignore();
+    td::write_file(boc_path, serialized).ensure();
+
+    auto from_path = std_boc_deserialize_multi_file(boc_path);
+    bool has_level = std::any_of(expected.begin(), expected.end(), [](auto& c) { return c->get_level() != 0; });
+    ASSERT_EQ(has_level, from_path.is_error());
+    if (!has_level) {
+      check(expected, from_path.move_as_ok());
+    }
+
+    BagOfCellsChunkedDeserializer from_file;
+    auto fd = td::FileFd::open(boc_path, td::FileFd::Read).move_as_ok();
+    from_file.add_data(fd, rnd.fast(1, 1000)).ensure();
+    fd.close();
+    check(expected, from_file.finish().move_as_ok());
+
+    td::ChainBufferWriter writer;
+    td::Slice data = serialized;
+    while (!data.empty()) {
+      auto chunk_size = std::min(data.size(), static_cast<size_t>(rnd.fast(1, 1000)));
+      writer.append(data.substr(0, chunk_size));
+      data.remove_prefix(chunk_size);
+    }
+    auto reader = writer.extract_reader();
+    BagOfCellsChunkedDeserializer from_chain;
+    from_chain.add_data(reader).ensure();
+    ASSERT_TRUE(reader.empty());
+    check(expected, from_chain.finish().move_as_ok());
+  }
+
+  // random cells usually have a non-zero level, so also round-trip a plain multi-root bag
+  auto shared = CellBuilder().store_long(-1, 64).finalize();
+  std::vector<Ref<Cell>> roots;
+  for (int i = 0; i < 5; i++) {
+    roots.push_back(CellBuilder().store_long(i, 32).store_ref(shared).finalize());
+  }
+  td::unlink(boc_path).ignore();
+  td::write_file(boc_path, serialize_boc(roots, BagOfCells::WithCRC32C)).ensure();
+  check(roots, std_boc_deserialize_multi_file(boc_path).move_as_ok());
+  td::unlink(boc_path).ignore();
+  ASSERT_TRUE(std_boc_deserialize_multi_file(boc_path).is_error());
+}
+
+TEST(TonDb, StaticBocIndexFile) {
+  td::Random::Xorshift128plus rnd{123};
+  td::CSlice boc_path = "static_boc_index.boc";
+  td::CSlice index_path = "static_boc_index.idx";
+  td::unlink(index_path).ignore();
+  for (int t = 0; t < 20; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd);
+    auto serialized = serialize_boc(cell);
+    // index file is used only for bags of cells without a built-in index
+    td::unlink(boc_path).ignore();
+    auto mode = get_random_serialization_mode(rnd) & ~(BagOfCells::WithIndex | BagOfCells::WithCacheBits);
+    td::write_file(boc_path, serialize_boc(cell, mode)).ensure();
+    if (rnd() % 2 == 0) {
+      td::unlink(index_path).ignore();
+    }
+
+    StaticBagOfCellsDbLazy::Options options;
+    options.index_path = index_path.str();
+    if (rnd() % 2 == 0) {
+      options.blob_hash = td::sha256(td::read_file_str(boc_path).move_as_ok());
+    } else if (!(mode & BagOfCells::WithCRC32C)) {
+      // without a CRC32C or a caller-provided hash there is nothing cheap to validate the index file with
+      auto db = StaticBagOfCellsDbLazy::create(FileBlobView::create(boc_path).move_as_ok(), options).move_as_ok();
+      ASSERT_TRUE(db->get_root_cell(0).is_error());
+      continue;
+    }
+    // the first open builds the index or detects a stale one, the second one just maps it
+    for (int i = 0; i < 2; i++) {
+      auto blob = i == 0 ? FileBlobView::create(boc_path) : FileMemoryMappingBlobView::create(boc_path);
+      auto db = StaticBagOfCellsDbLazy::create(blob.move_as_ok(), options).move_as_ok();
+      auto root = db->get_root_cell(0).move_as_ok();
+      ASSERT_EQ(cell->get_hash(), root->get_hash());
+      ASSERT_EQ(serialized, serialize_boc(root));
+    }
+  }
+
+  // a blob of the same size which differs only in the middle must not reuse the index, as its CRC32C differs
+  auto create_cell = [](bool swap) {
+    auto create_chain = [](int n, bool bit) {
+      Ref<Cell> chain = CellBuilder().store_long(bit, 8).finalize();
+      for (int i = 1; i < n; i++) {
+        chain = CellBuilder().store_long(bit ? -1 : 0, 64).store_zeroes(952).store_ref(chain).finalize();
+      }
+      return chain;
+    };
+    auto small = CellBuilder().store_long(1, 8).finalize();
+    auto big = CellBuilder().store_ones(800).finalize();
+    Ref<Cell> middle = CellBuilder().store_ref(swap ? big : small).store_ref(swap ? small : big).finalize();
+    for (int i = 0; i < 10; i++) {
+      middle = CellBuilder().store_long(i, 8).store_ref(middle).finalize();
+    }
+    return CellBuilder()
+        .store_ref(create_chain(10, false))
+        .store_ref(middle)
+        .store_ref(create_chain(10, true))
+        .finalize();
+  };
+  StaticBagOfCellsDbLazy::Options options;
+  options.index_path = index_path.str();
+  td::unlink(index_path).ignore();
+  for (auto swap : {false, true}) {
+    auto cell = create_cell(swap);
+    td::write_file(boc_path, serialize_boc(cell, BagOfCells::WithCRC32C)).ensure();
+    auto db = StaticBagOfCellsDbLazy::create(FileBlobView::create(boc_path).move_as_ok(), options).move_as_ok();
+    auto root = db->get_root_cell(0).move_as_ok();
+    ASSERT_EQ(cell->get_hash(), root->get_hash());
+    ASSERT_EQ(serialize_boc(cell), serialize_boc(root));
+  }
+  td::unlink(boc_path).ignore();
+  td::unlink(index_path).ignore();
+};
+
 TEST(TonDb, DynamicBoc) {
   td::Random::Xorshift128plus rnd{123};
   std::string old_root_hash;
@@ -771,6 +960,62 @@ TEST(TonDb, DynamicBoc) {
   ASSERT_EQ(0u, kv->count("").ok());
 };
 
+TEST(TonDb, DynamicBocCacheBudget) {
+  td::Random::Xorshift128plus rnd{123};
+  std::string old_root_hash;
+  std::vector<std::string> old_hashes;
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  DynamicBagOfCellsDb::CacheOptions cache_options;
+  cache_options.max_bytes = 1 << 12;
+  auto dboc = DynamicBagOfCellsDb::create(cache_options);
+  DynamicBagOfCellsDb::Stats stats;
+  for (int t = 100; t >= 0; t--) {
+    dboc->set_loader(std::make_unique<CellLoader>(kv));
+    for (int i = 0; i < 2; i++) {
+      for (auto &hash : old_hashes) {
+        ASSERT_EQ(hash, dboc->load_cell(hash).move_as_ok()->get_hash().as_slice().str());
+      }
+    }
+    Ref<Cell> old_root;
+    if (!old_root_hash.empty()) {
+      old_root = dboc->load_cell(old_root_hash).move_as_ok();
+    }
+
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd, false);
+    old_root_hash = cell->get_hash().as_slice().str();
+    old_hashes.clear();
+    std::set<std::string> all_hashes;
+    std::vector<Ref<Cell>> to_visit{cell};
+    while (!to_visit.empty()) {
+      auto next = std::move(to_visit.back());
+      to_visit.pop_back();
+      if (!all_hashes.insert(next->get_hash().as_slice().str()).second) {
+        continue;
+      }
+      CellSlice cs(NoVm(), next);
+      for (unsigned i = 0; i < cs.size_refs(); i++) {
+        to_visit.push_back(cs.prefetch_ref(i));
+      }
+    }
+    old_hashes.assign(all_hashes.begin(), all_hashes.end());
+
+    dboc->dec(old_root);
+    if (t != 0) {
+      dboc->inc(cell);
+    }
+    dboc->prepare_commit();
+    stats.apply_diff(dboc->get_stats_diff());
+    {
+      CellStorer cell_storer(*kv);
+      dboc->commit(cell_storer);
+    }
+  }
+  ASSERT_EQ(0u, kv->count("").ok());
+  ASSERT_TRUE(stats.cache_hits > 0);
+  ASSERT_TRUE(stats.cache_misses > 0);
+  ASSERT_TRUE(stats.cache_evictions > 0);
+};
+
 TEST(TonDb, DynamicBoc2) {
   int VERBOSITY_NAME(boc) = VERBOSITY_NAME(DEBUG) + 10;
   td::Random::Xorshift128plus rnd{123};
@@ -1561,6 +1806,131 @@ TEST(TonDb, BenchBocSerializerSerialize) {
   td::bench(BenchBocSerializerSerialize());
 }
 
+vm::Ref<vm::Cell> gen_cell_tree(int leaves, td::Random::Xorshift128plus &rnd) {
+  std::vector<vm::Ref<vm::Cell>> level;
+  for (int i = 0; i < leaves; i++) {
+    level.push_back(vm::CellBuilder().store_long(static_cast<long long>(rnd()), 64).store_long(i, 32).finalize());
+  }
+  while (level.size() > 1) {
+    std::vector<vm::Ref<vm::Cell>> next;
+    for (size_t i = 0; i < level.size(); i += 4) {
+      vm::CellBuilder cb;
+      cb.store_long(static_cast<long long>(rnd()), 64);
+      for (size_t j = i; j < std::min(i + 4, level.size()); j++) {
+        cb.store_ref(std::move(level[j]));
+      }
+      next.push_back(cb.finalize());
+    }
+    level = std::move(next);
+  }
+  return level[0];
+}
+
+class BenchBocSerializerParallel : public td::Benchmark {
+ public:
+  explicit BenchBocSerializerParallel(int threads) : threads_(threads) {
+    td::Random::Xorshift128plus rnd{123};
+    root_ = gen_cell_tree(leaves_count, rnd);
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchBocSerializerParallel threads=" << threads_;
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      vm::std_boc_serialize_parallel(root_, 31, threads_).ensure();
+    }
+  }
+
+ private:
+  // about 1M cells in total
+  static constexpr int leaves_count = 768 * 1024;
+  int threads_;
+  vm::Ref<vm::Cell> root_;
+};
+
+TEST(TonDb, BenchBocSerializerParallel) {
+  for (int threads : {1, 2, 4, 8}) {
+    td::bench(BenchBocSerializerParallel(threads));
+  }
+}
+
+class BenchDynamicBocLoad : public td::Benchmark {
+ public:
+  BenchDynamicBocLoad(bool batch_loads, bool read_walk) : batch_loads_(batch_loads), read_walk_(read_walk) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchDynamicBocLoad " << (read_walk_ ? "read" : "dec") << " batch_loads=" << batch_loads_;
+  }
+
+  void start_up() override {
+    td::RocksDb::destroy(db_path_).ensure();
+    kv_ = std::make_shared<td::RocksDb>(td::RocksDb::open(db_path_).move_as_ok());
+    td::Random::Xorshift128plus rnd{123};
+    auto root = gen_cell_tree(leaves_count, rnd);
+    root_hash_ = root->get_hash().as_slice().str();
+    auto dboc = vm::DynamicBagOfCellsDb::create();
+    dboc->set_loader(std::make_unique<vm::CellLoader>(kv_));
+    dboc->inc(root);
+    dboc->prepare_commit().ensure();
+    vm::CellStorer cell_storer(*kv_);
+    kv_->begin_transaction().ensure();
+    dboc->commit(cell_storer).ensure();
+    kv_->commit_transaction().ensure();
+  }
+
+  // dec of the whole state loads every cell, level by level;
+  // a read walk loads every cell through ExtCell, together with its siblings
+  void run(int n) override {
+    vm::DynamicBagOfCellsDb::CacheOptions cache_options;
+    cache_options.batch_loads = batch_loads_;
+    for (int i = 0; i < n; i++) {
+      auto dboc = vm::DynamicBagOfCellsDb::create(cache_options);
+      dboc->set_loader(std::make_unique<vm::CellLoader>(std::shared_ptr<td::KeyValueReader>(kv_->snapshot())));
+      auto root = dboc->load_cell(root_hash_).move_as_ok();
+      if (read_walk_) {
+        CHECK(count_leaves(root) == leaves_count);
+      } else {
+        dboc->dec(root);
+        dboc->prepare_commit().ensure();
+      }
+    }
+  }
+
+  void tear_down() override {
+    kv_.reset();
+    td::RocksDb::destroy(db_path_).ensure();
+  }
+
+ private:
+  static constexpr int leaves_count = 64 * 1024;
+  bool batch_loads_;
+  bool read_walk_;
+  std::string db_path_{"dynamic_boc_load_db"};
+  std::shared_ptr<td::RocksDb> kv_;
+  std::string root_hash_;
+
+  static int count_leaves(vm::Ref<vm::Cell> cell) {
+    vm::CellSlice cs(vm::NoVm(), std::move(cell));
+    if (cs.size_refs() == 0) {
+      return 1;
+    }
+    int res = 0;
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      res += count_leaves(cs.prefetch_ref(i));
+    }
+    return res;
+  }
+};
+
+TEST(TonDb, BenchDynamicBocLoad) {
+  for (bool read_walk : {false, true}) {
+    for (bool batch_loads : {false, true}) {
+      td::bench(BenchDynamicBocLoad(batch_loads, read_walk));
+    }
+  }
+}
+
 template <class DeserializerT>
 void bench_deserializer(std::string name, bool full) {
   using Config = BenchBocDeserializerConfig;
@@ -17,6 +17,8 @@
     Copyright 2017-2019 Telegram Systems LLP
 */
 #include "vm/dict.h"
+#include "vm/profiler.h"
+#include "vm/cells/CellArena.h"
 #include "common/bigint.hpp"
 
 #include "Ed25519.h"
@@ -37,6 +39,7 @@
 #include "smc-envelope/WalletV3.h"
 
 #include "td/utils/base64.h"
+#include "td/utils/benchmark.h"
 #include "td/utils/crypto.h"
 #include "td/utils/Random.h"
 #include "td/utils/tests.h"
@@ -46,9 +49,11 @@
 #include "td/utils/PathView.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 
 #include <bitset>
 #include <set>
+#include <sstream>
 #include <tuple>
 
 std::string current_dir() {
@@ -599,3 +604,227 @@ TEST(Smartcont, MultisigStress) {
   LOG(INFO) << "Final code size: " << ms->code_size();
   LOG(INFO) << "Final data size: " << ms->data_size();
 }
+
+class BenchContractExecution : public td::Benchmark {
+ public:
+  BenchContractExecution() {
+    auto private_key = td::Ed25519::generate_private_key().move_as_ok();
+    auto public_key = private_key.get_public_key().move_as_ok().as_octet_string();
+    wallet_ = SimpleWallet::create(SimpleWallet::create_empty()->create_init_state(public_key));
+
+    std::vector<td::Ed25519::PrivateKey> keys;
+    for (int i = 0; i < 10; i++) {
+      keys.push_back(td::Ed25519::generate_private_key().move_as_ok());
+    }
+    multisig_ = ton::MultisigWallet::create(ton::MultisigWallet::create()->create_init_data(
+        td::transform(keys, [](auto& key) { return key.get_public_key().ok().as_octet_string(); }), 5));
+    CHECK(multisig_.write().send_external_message(vm::CellBuilder().finalize()).code == 0);
+    for (int i = 0; i < queries_n; i++) {
+      ton::MultisigWallet::QueryBuilder qb(i + 1, vm::CellBuilder().store_long(i, 32).finalize());
+      CHECK(multisig_.write().send_external_message(qb.create(i, keys[i])).code == 0);
+    }
+  }
+  std::string get_description() const override {
+    return "BenchContractExecution";
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      CHECK(wallet_->seqno() == 0);
+      CHECK(multisig_->get_n_k() == std::make_pair(10, 5));
+      CHECK(multisig_->get_unsigned_messaged().size() == static_cast<size_t>(queries_n));
+    }
+  }
+
+ private:
+  static constexpr int queries_n = 5;
+  td::Ref<SimpleWallet> wallet_;
+  td::Ref<ton::MultisigWallet> multisig_;
+};
+
+TEST(Smartcont, BenchContractExecution) {
+  td::bench(BenchContractExecution());
+}
+
+TEST(Smartcont, VmProfiler) {
+  auto private_key = td::Ed25519::generate_private_key().move_as_ok();
+  auto public_key = private_key.get_public_key().move_as_ok().as_octet_string();
+  auto w = SimpleWallet::create(SimpleWallet::create_empty()->create_init_state(public_key));
+
+  auto check_profile = [](const vm::VmProfiler& profiler, const ton::SmartContract::Answer& res) {
+    ASSERT_EQ(res.gas_used, profiler.get_gas());
+    long long steps = 0;
+    long long gas = 0;
+    for (auto& it : profiler.get_instr_stats()) {
+      CHECK(!it.first.empty() && it.first.find(' ') == std::string::npos);
+      steps += it.second.count;
+      gas += it.second.gas;
+    }
+    ASSERT_EQ(profiler.get_steps(), steps);
+    ASSERT_EQ(profiler.get_gas(), gas);
+    steps = 0;
+    gas = 0;
+    for (auto& it : profiler.get_cell_stats()) {
+      steps += it.second.steps;
+      gas += it.second.gas;
+    }
+    ASSERT_EQ(profiler.get_steps(), steps);
+    ASSERT_EQ(profiler.get_gas(), gas);
+    gas = 0;
+    for (auto& line : td::full_split(profiler.to_folded_stacks(), '\n')) {
+      if (!line.empty()) {
+        gas += td::to_integer<long long>(line.substr(line.rfind(' ') + 1));
+      }
+    }
+    ASSERT_EQ(profiler.get_gas(), gas);
+  };
+
+  vm::VmProfiler profiler;
+  auto res = w->run_get_method("seqno", ton::SmartContract::Args().set_profiler(&profiler));
+  CHECK(res.success);
+  check_profile(profiler, res);
+  CHECK(profiler.get_instr_stats().count("CTOS") != 0);
+  LOG(INFO) << "seqno profile:\n" << profiler.to_string();
+
+  profiler.clear();
+  auto msg = w->sign_message(w->prepare_send_message(vm::CellBuilder().finalize()), private_key);
+  res = w.write().send_external_message(msg, ton::SmartContract::Args().set_profiler(&profiler));
+  CHECK(res.success);
+  check_profile(profiler, res);
+  CHECK(profiler.get_cell_loads() > 0);
+  CHECK(profiler.get_cell_creates() > 0);
+  LOG(INFO) << "external message profile:\n" << profiler.to_string() << profiler.to_folded_stacks();
+  ASSERT_EQ(1, w->seqno());
+}
+
+TEST(Smartcont, RunGetMethods) {
+  std::vector<td::Ref<SimpleWallet>> wallets;
+  for (int i = 0; i < 3; i++) {
+    auto public_key = td::Ed25519::generate_private_key().move_as_ok().get_public_key().move_as_ok();
+    wallets.push_back(SimpleWallet::create(SimpleWallet::create_empty()->create_init_state(public_key.as_octet_string())));
+  }
+  std::vector<td::Ed25519::PrivateKey> keys;
+  for (int i = 0; i < 3; i++) {
+    keys.push_back(td::Ed25519::generate_private_key().move_as_ok());
+  }
+  auto multisig = ton::MultisigWallet::create(ton::MultisigWallet::create()->create_init_data(
+      td::transform(keys, [](auto& key) { return key.get_public_key().ok().as_octet_string(); }), 2));
+
+  auto stack_to_string = [](const td::Ref<vm::Stack>& stack) {
+    std::ostringstream os;
+    stack->dump(os, false);
+    return os.str();
+  };
+  std::vector<ton::SmartContract::BatchQuery> queries;
+  std::vector<ton::SmartContract::Answer> expected;
+  for (int i = 0; i < 20; i++) {
+    auto& wallet = wallets[i % wallets.size()];
+    queries.push_back({wallet->get_state(), ton::SmartContract::Args().set_method_id("seqno")});
+    expected.push_back(wallet->run_get_method("seqno"));
+    queries.push_back({multisig->get_state(), ton::SmartContract::Args().set_method_id("get_n_k")});
+    expected.push_back(multisig->run_get_method("get_n_k"));
+  }
+  // the query is not a get method of the contract
+  queries.push_back({multisig->get_state(), ton::SmartContract::Args().set_method_id("seqno")});
+  expected.push_back(multisig->run_get_method("seqno"));
+  CHECK(!expected.back().success);
+
+  for (size_t threads_n : {1, 2, 4}) {
+    auto answers = ton::SmartContract::run_get_methods(queries, threads_n);
+    ASSERT_EQ(expected.size(), answers.size());
+    for (size_t i = 0; i < answers.size(); i++) {
+      ASSERT_EQ(expected[i].success, answers[i].success);
+      ASSERT_EQ(expected[i].code, answers[i].code);
+      ASSERT_EQ(expected[i].gas_used, answers[i].gas_used);
+      ASSERT_EQ(stack_to_string(expected[i].stack), stack_to_string(answers[i].stack));
+    }
+  }
+}
+
+TEST(Smartcont, BenchRunGetMethods) {
+  auto public_key = td::Ed25519::generate_private_key().move_as_ok().get_public_key().move_as_ok();
+  auto wallet = SimpleWallet::create(SimpleWallet::create_empty()->create_init_state(public_key.as_octet_string()));
+  constexpr int queries_n = 200;
+  auto create_queries = [&] {
+    // the arguments are filled in place, because moving a temporary Args makes GCC warn about its empty optionals
+    std::vector<ton::SmartContract::BatchQuery> queries(queries_n);
+    for (auto& query : queries) {
+      query.state = wallet->get_state();
+      query.args.set_method_id("seqno");
+    }
+    return queries;
+  };
+
+  td::Timer timer;
+  for (int i = 0; i < queries_n; i++) {
+    CHECK(wallet->run_get_method("seqno").success);
+  }
+  LOG(INFO) << "run_get_method: " << queries_n / timer.elapsed() << " calls/sec";
+
+  std::set<size_t> threads_ns{1, 2, 4, td::max<size_t>(td::thread::hardware_concurrency(), 1)};
+  for (auto threads_n : threads_ns) {
+    auto queries = create_queries();
+    timer = td::Timer();
+    auto answers = ton::SmartContract::run_get_methods(std::move(queries), threads_n);
+    auto elapsed = timer.elapsed();
+    for (auto& answer : answers) {
+      CHECK(answer.success);
+    }
+    LOG(INFO) << "run_get_methods with " << threads_n << " threads: " << queries_n / elapsed << " calls/sec";
+  }
+}
+
+TEST(Smartcont, CellArena) {
+  std::vector<td::Ed25519::PrivateKey> keys;
+  for (int i = 0; i < 10; i++) {
+    keys.push_back(td::Ed25519::generate_private_key().move_as_ok());
+  }
+  auto init_data = ton::MultisigWallet::create()->create_init_data(
+      td::transform(keys, [](auto& key) { return key.get_public_key().ok().as_octet_string(); }), 5);
+  std::vector<td::Ref<vm::Cell>> messages;
+  for (int i = 0; i < 30; i++) {
+    ton::MultisigWallet::QueryBuilder qb(i + 1, vm::CellBuilder().store_long(i, 32).finalize());
+    for (int j = 0; j < 4; j++) {
+      qb.sign(j, keys[j]);
+    }
+    messages.push_back(qb.create(4, keys[4]));
+  }
+
+  // each message runs in its own arena, like a transaction; an arena without hash consing only chunks the storage
+  auto run = [&](bool use_cell_arena, bool hash_consing) {
+    auto ms = ton::MultisigWallet::create(init_data);
+    vm::CellArena::Stats stats;
+    td::Timer timer;
+    CHECK(ms.write().send_external_message(vm::CellBuilder().finalize()).code == 0);
+    for (auto& message : messages) {
+      std::unique_ptr<vm::CellArena> arena;
+      if (use_cell_arena) {
+        arena = std::make_unique<vm::CellArena>(hash_consing);
+      }
+      auto res = ms.write().send_external_message(message);
+      CHECK(res.code == 0);
+      if (arena) {
+        stats.cells_created += arena->get_stats().cells_created;
+        stats.cells_reused += arena->get_stats().cells_reused;
+        stats.chunks_allocated += arena->get_stats().chunks_allocated;
+      }
+    }
+    if (use_cell_arena) {
+      LOG(INFO) << "cell arena " << (hash_consing ? "with" : "without") << " hash consing: " << stats.cells_created
+                << " cells created, " << stats.cells_reused << " cells reused, " << stats.chunks_allocated
+                << " chunks allocated, " << timer.elapsed() * 1000 << "ms";
+    } else {
+      LOG(INFO) << "without cell arena: " << timer.elapsed() * 1000 << "ms";
+    }
+    return ms->get_state().data;
+  };
+  auto data = run(false, false);
+  ASSERT_EQ(data->get_hash(), run(true, false)->get_hash());
+  ASSERT_EQ(data->get_hash(), run(true, true)->get_hash());
+
+  auto ms = ton::MultisigWallet::create(init_data);
+  CHECK(ms.write().send_external_message(vm::CellBuilder().finalize()).code == 0);
+  for (auto& message : messages) {
+    CHECK(ms.write().send_external_message(message, ton::SmartContract::Args().set_use_cell_arena(true)).code == 0);
+  }
+  ASSERT_EQ(data->get_hash(), ms->get_state().data->get_hash());
+}
@@ -19,13 +19,23 @@
 #include "vm/continuation.h"
 #include "vm/cp0.h"
 #include "vm/dict.h"
+#include "vm/boc.h"
+#include "vm/opctable.h"
+#include "vm/dispatch.h"
+#include "vm/profiler.h"
 #include "fift/utils.h"
 #include "common/bigint.hpp"
 
+#include "td/utils/base64.h"
+#include "td/utils/format.h"
+#include "td/utils/benchmark.h"
+#include "td/utils/Random.h"
 #include "td/utils/tests.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/StringBuilder.h"
 
+#include <sstream>
+
 std::string run_vm(td::Ref<vm::Cell> cell) {
   vm::init_op_cp0();
   vm::DictionaryBase::get_empty_dictionary();
@@ -184,6 +194,159 @@ TEST(VM, bigint) {
   REGRESSION_VERIFY(sb.as_cslice());
 }
 
+static td::BigInt256 random_bigint(int max_bytes) {
+  unsigned char buff[32];
+  int bytes = td::Random::fast(1, max_bytes);
+  td::Random::secure_bytes(buff, bytes);
+  td::BigInt256 x;
+  CHECK(x.import_bytes(buff, bytes, true));
+  return x;
+}
+
+static void check_same(const td::BigInt256 &x, const td::BigInt256 &y) {
+  ASSERT_EQ(x.is_valid(), y.is_valid());
+  if (x.is_valid()) {
+    ASSERT_EQ(x.to_hex_string(), y.to_hex_string());
+  }
+}
+
+// checks the word-sized fast paths of BigIntG against the generic AnyIntView code
+TEST(VM, bigint_fast_paths) {
+  std::vector<td::BigInt256> small;
+  for (int i = -20; i <= 20; i++) {
+    small.emplace_back(i);
+  }
+  for (int i = 0; i < 100000 + 41 * 41; i++) {
+    int max_bytes = i % 2 ? 32 : 16;
+    auto x = random_bigint(max_bytes), y = random_bigint(max_bytes), z = random_bigint(max_bytes);
+    if (i >= 100000) {
+      // all rounding ties of small values
+      x = small[(i - 100000) / 41];
+      y = small[(i - 100000) % 41];
+    }
+    if (td::Random::fast(0, 3) == 0) {
+      // the generic division expects a normalized divisor
+      y.mul_short(td::Random::fast(-10, 10)).normalize();
+    }
+
+    auto fast = x;
+    fast.add_mul(y, z).normalize();
+    auto generic = x;
+    generic.invalidate_unless(generic.as_any_int().add_mul_any(y.as_any_int(), z.as_any_int())).normalize();
+    check_same(fast, generic);
+
+    for (int round_mode = -1; round_mode <= 1; round_mode++) {
+      td::BigInt256 fast_quot, generic_quot;
+      auto fast_rem = x;
+      fast_rem.mod_div(y, fast_quot, round_mode);
+      fast_quot.normalize();
+      auto generic_rem = x;
+      auto q = generic_quot.as_any_int();
+      generic_rem.invalidate_unless(generic_rem.as_any_int().mod_div_any(y.as_any_int(), q, round_mode));
+      generic_quot.normalize();
+      check_same(fast_rem, generic_rem);
+      if (fast_rem.is_valid()) {
+        check_same(fast_quot, generic_quot);
+      }
+    }
+  }
+}
+
+// runs the same code on inline integers and on the same values kept as td::RefInt256,
+// so that the StackEntry fast paths in arithops.cpp are compared against the BigInt256 ones
+static std::string run_int_code(const td::Ref<vm::CellSlice> &code, const std::vector<long long> &args, bool inline_ints) {
+  vm::Stack stack;
+  for (auto x : args) {
+    if (inline_ints) {
+      stack.push_smallint(x);
+    } else {
+      stack.push_int(td::make_refint(x));
+    }
+  }
+  vm::VmLog log;
+  log.log_options.level = 0;
+  int exit_code = vm::run_vm_code(code, stack, 0, nullptr, std::move(log));
+  std::ostringstream os;
+  os << exit_code << ": ";
+  stack.dump(os, false);
+  return os.str();
+}
+
+TEST(VM, small_int_fast_paths) {
+  vm::init_op_cp0();
+  auto verbosity = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  SCOPE_EXIT {
+    SET_VERBOSITY_LEVEL(verbosity);
+  };
+  std::vector<long long> values{0, 1, -1};
+  for (int bits : {31, 62}) {
+    for (long long delta = -1; delta <= 1; delta++) {
+      values.push_back((1LL << bits) + delta);
+      values.push_back(-(1LL << bits) + delta);
+    }
+  }
+  std::vector<std::string> binary_ops{"ADD", "SUB", "SUBR",  "MUL", "AND", "OR",  "XOR",     "MIN", "MAX",
+                                      "LESS", "LEQ", "GREATER", "GEQ", "EQUAL", "NEQ", "CMP", "QADD", "QMUL"};
+  std::vector<std::string> unary_ops{"NEGATE",     "INC",        "DEC",       "NOT",        "ABS",
+                                     "SGN",        "ISZERO",     "3 EQINT",   "-1 LESSINT", "1 GTINT",
+                                     "1 ADDCONST", "-1 ADDCONST", "3 MULCONST", "-128 MULCONST",
+                                     "1 RSHIFT#",  "31 RSHIFT#", "62 RSHIFT#", "1 LSHIFT#", "31 LSHIFT#", "62 LSHIFT#"};
+  auto check = [](const std::string &op, const td::Ref<vm::CellSlice> &code, const std::vector<long long> &args) {
+    auto fast = run_int_code(code, args, true);
+    auto generic = run_int_code(code, args, false);
+    if (fast != generic) {
+      LOG(FATAL) << op << " " << td::format::as_array(args) << ": " << fast << " != " << generic;
+    }
+  };
+  auto compile = [](const std::string &op) {
+    return vm::load_cell_slice_ref(fift::compile_asm("\n" + op + "\n").move_as_ok());
+  };
+  for (auto &op : binary_ops) {
+    auto code = compile(op);
+    for (auto x : values) {
+      for (auto y : values) {
+        check(op, code, {x, y});
+      }
+    }
+  }
+  for (auto &op : unary_ops) {
+    auto code = compile(op);
+    for (auto x : values) {
+      check(op, code, {x});
+    }
+  }
+}
+
+TEST(VM, profiler_bit_jumps) {
+  vm::init_op_cp0();
+  // 5 has bits 0 and 2 set, so none of the jumps is taken
+  td::Slice asm_code = R"A(
+5 INT
+<{ }> PUSHCONT 1 IFBITJMP
+<{ }> PUSHCONT 0 IFNBITJMP
+<{ }>c 1 IFBITJMPREF
+<{ }>c 2 IFNBITJMPREF
+)A";
+  auto code = vm::load_cell_slice_ref(fift::compile_asm(asm_code).move_as_ok());
+  std::vector<std::string> instrs;
+  for (vm::CellSlice cs = *code; cs.size() || cs.size_refs();) {
+    instrs.push_back(vm::DispatchTable::get_table(0)->dump_instr(cs));
+  }
+  ASSERT_EQ("PUSHINT 5,PUSHCONT x,IFBITJMP 1,PUSHCONT x,IFNBITJMP 0,IFBITJMPREF 1,IFNBITJMPREF 2",
+            td::implode(instrs, ','));
+  vm::VmProfiler profiler;
+  vm::VmState vm{code, td::make_ref<vm::Stack>()};
+  vm.set_profiler(&profiler);
+  ASSERT_EQ(-1, vm.run());
+  auto& stats = profiler.get_instr_stats();
+  ASSERT_EQ(0u, stats.count("(invalid)"));
+  for (auto mnemonic : {"IFBITJMP", "IFNBITJMP", "IFBITJMPREF", "IFNBITJMPREF"}) {
+    ASSERT_EQ(1u, stats.count(mnemonic));
+    ASSERT_EQ(1, stats.at(mnemonic).count);
+  }
+}
+
 TEST(VM, report3_1) {
   //WA: expect (1, 2, 6, 3)
   td::Slice test1 =
@@ -425,3 +588,175 @@ RETALT
 )A";
   test_run_vm(fift::compile_asm(test1).move_as_ok());
 }
+
+const vm::OpcodeTable &get_cp0_opcode_table() {
+  vm::init_op_cp0();
+  auto table = dynamic_cast<const vm::OpcodeTable *>(vm::DispatchTable::get_table(vm::Codepage::test_cp));
+  CHECK(table);
+  return *table;
+}
+
+TEST(VM, opcode_table_flat) {
+  auto &table = get_cp0_opcode_table();
+  for (unsigned opcode = 0; opcode < vm::top_opcode; opcode++) {
+    ASSERT_TRUE(table.lookup_instr_flat(opcode) == table.lookup_instr_list(opcode));
+  }
+}
+
+std::vector<unsigned> collect_contract_opcodes() {
+  std::vector<td::Ref<vm::Cell>> codes;
+  auto with_tvm_code = [&](auto name, td::Slice code_str) {
+    codes.push_back(vm::std_boc_deserialize(td::base64_decode(code_str).move_as_ok()).move_as_ok());
+  };
+#include "smartcont/auto/multisig-code.cpp"
+#include "smartcont/auto/simple-wallet-ext-code.cpp"
+#include "smartcont/auto/simple-wallet-code.cpp"
+#include "smartcont/auto/wallet-code.cpp"
+#include "smartcont/auto/wallet3-code.cpp"
+#include "smartcont/auto/highload-wallet-v2-code.cpp"
+
+  auto &table = get_cp0_opcode_table();
+  std::vector<unsigned> opcodes;
+  while (!codes.empty()) {
+    auto cs = vm::load_cell_slice(codes.back());
+    codes.pop_back();
+    for (unsigned i = 0; i < cs.size_refs(); i++) {
+      codes.push_back(cs.prefetch_ref(i));
+    }
+    while (!cs.empty_ext()) {
+      unsigned bits = vm::max_opcode_bits;
+      auto prefetch = cs.prefetch_ulong_top(bits);
+      opcodes.push_back(static_cast<unsigned>(prefetch >> (64 - vm::max_opcode_bits)));
+      auto len = table.instr_len(cs);
+      if (len <= 0 || !cs.advance_ext(len)) {
+        break;
+      }
+    }
+  }
+  CHECK(!opcodes.empty());
+  return opcodes;
+}
+
+class BenchOpcodeLookup : public td::Benchmark {
+ public:
+  explicit BenchOpcodeLookup(bool flat) : flat_(flat) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchOpcodeLookup " << (flat_ ? "flat" : "list");
+  }
+  void start_up() override {
+    opcodes_ = collect_contract_opcodes();
+  }
+  void run(int n) override {
+    auto &table = get_cp0_opcode_table();
+    unsigned res = 0;
+    for (int i = 0; i < n; i++) {
+      for (auto opcode : opcodes_) {
+        auto instr = flat_ ? table.lookup_instr_flat(opcode) : table.lookup_instr_list(opcode);
+        res += instr->get_opcode_min();
+      }
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  bool flat_;
+  std::vector<unsigned> opcodes_;
+};
+
+TEST(VM, BenchOpcodeLookup) {
+  td::bench(BenchOpcodeLookup(false));
+  td::bench(BenchOpcodeLookup(true));
+}
+
+class BenchBigIntArith : public td::Benchmark {
+ public:
+  BenchBigIntArith(std::string name, std::string a, std::string b) : name_(std::move(name)) {
+    CHECK(a_.parse_dec(a) > 0 && b_.parse_dec(b) > 0);
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchBigIntArith " << name_;
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      td::BigInt256 x{a_}, q, r{a_};
+      x.add_mul(b_, b_);
+      r.mod_div(b_, q);
+      td::do_not_optimize_away(x.normalize_bool() && q.normalize_bool() && r.normalize_bool());
+    }
+  }
+
+ private:
+  std::string name_;
+  td::BigInt256 a_;
+  td::BigInt256 b_;
+};
+
+TEST(VM, BenchBigIntArith) {
+  td::bench(BenchBigIntArith("small", "123456789", "-1000"));
+  td::bench(BenchBigIntArith("64-bit", "1000000000000000000", "-3000000007"));
+  td::bench(BenchBigIntArith("100-bit", "1000000000000000000000000000000", "-3000000000000000000007"));
+  td::bench(BenchBigIntArith("256-bit", "1" + std::string(70, '0'), "-3000007"));
+}
+
+class BenchVmIntLoop : public td::Benchmark {
+ public:
+  std::string get_description() const override {
+    return "BenchVmIntLoop";
+  }
+  void start_up() override {
+    td::Slice code =
+        R"A(
+0 INT
+1000 INT
+REPEAT:<{
+  INC
+  DUP
+  7 INT
+  AND
+  3 EQINT
+  IF:<{
+    2 ADDCONST
+  }>
+  DUP
+  3 MULCONST
+  1000000 INT
+  LESS
+  DROP
+}>
+)A";
+    code_ = vm::load_cell_slice_ref(fift::compile_asm(code).move_as_ok());
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      run_once();
+    }
+  }
+  // returns the number of executed steps
+  long long run_once() {
+    vm::Stack stack;
+    vm::VmLog log;
+    log.log_options.level = 0;
+    long long steps = 0;
+    vm::run_vm_code(code_, stack, 0, nullptr, std::move(log), &steps);
+    CHECK(stack.depth() == 1);
+    return steps;
+  }
+
+ private:
+  td::Ref<vm::CellSlice> code_;
+};
+
+TEST(VM, BenchVmIntLoop) {
+  vm::init_op_cp0();
+  auto verbosity = GET_VERBOSITY_LEVEL();
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  SCOPE_EXIT {
+    SET_VERBOSITY_LEVEL(verbosity);
+  };
+  BenchVmIntLoop bench;
+  bench.start_up();
+  auto steps = bench.run_once();
+  LOG(ERROR) << "BenchVmIntLoop: " << steps << " steps per run";
+  td::bench(bench);
+}
@@ -28,6 +28,26 @@
 
 namespace vm {
 
+// Fast paths for integers kept inline in stack entries (see StackEntry::small_int()); they do not allocate.
+// Inline values fit into 63 bits, so sums, differences and bitwise results cannot overflow a long long,
+// and results that do not fit into 63 bits are promoted to td::RefInt256 by Stack::push_smallint().
+static bool get_small_int_args(const Stack& stack, long long& x, long long& y) {
+  return stack[1].get_small_int(x) && stack[0].get_small_int(y);
+}
+
+static bool fits_small_factor(long long x) {
+  return x >= -(1LL << 31) && x < (1LL << 31);
+}
+
+static void replace_small_int_args(Stack& stack, int args, long long res) {
+  stack.pop_many(args);
+  stack.push_smallint(res);
+}
+
+static int small_int_cmp(long long x, long long y) {
+  return (x > y) - (x < y);
+}
+
 int exec_push_tinyint4(VmState* st, unsigned args) {
   int x = (int)((args + 5) & 15) - 5;
   Stack& stack = st->get_stack();
@@ -38,7 +58,7 @@ int exec_push_tinyint4(VmState* st, unsigned args) {
 
 std::string dump_push_tinyint4(CellSlice&, unsigned args) {
   int x = (int)((args + 5) & 15) - 5;
-  std::ostringstream os{"PUSHINT "};
+  std::ostringstream os{"PUSHINT ", std::ios_base::ate};
   os << x;
   return os.str();
 }
@@ -53,7 +73,7 @@ int exec_push_tinyint8(VmState* st, unsigned args) {
 
 std::string dump_op_tinyint8(const char* op_prefix, CellSlice&, unsigned args) {
   int x = (signed char)args;
-  std::ostringstream os{op_prefix};
+  std::ostringstream os{op_prefix, std::ios_base::ate};
   os << x;
   return os.str();
 }
@@ -68,7 +88,7 @@ int exec_push_smallint(VmState* st, unsigned args) {
 
 std::string dump_push_smallint(CellSlice&, unsigned args) {
   int x = (short)args;
-  std::ostringstream os{"PUSHINT "};
+  std::ostringstream os{"PUSHINT ", std::ios_base::ate};
   os << x;
   return os.str();
 }
@@ -79,8 +99,14 @@ int exec_push_int(VmState* st, CellSlice& cs, unsigned args, int pfx_bits) {
     throw VmError{Excno::inv_opcode, "not enough bits for integer constant in PUSHINT"};
   }
   cs.advance(pfx_bits);
-  td::RefInt256 x = cs.fetch_int256(3 + l * 8);
   Stack& stack = st->get_stack();
+  if (3 + l * 8 <= StackEntry::small_int_bits) {
+    long long y = cs.fetch_long(3 + l * 8);
+    VM_LOG(st) << "execute PUSHINT " << y;
+    stack.push_smallint(y);
+    return 0;
+  }
+  td::RefInt256 x = cs.fetch_int256(3 + l * 8);
   VM_LOG(st) << "execute PUSHINT " << x;
   stack.push_int(std::move(x));
   return 0;
@@ -93,7 +119,7 @@ std::string dump_push_int(CellSlice& cs, unsigned args, int pfx_bits) {
   }
   cs.advance(pfx_bits);
   td::RefInt256 x = cs.fetch_int256(3 + l * 8);
-  std::ostringstream os{"PUSHINT "};
+  std::ostringstream os{"PUSHINT ", std::ios_base::ate};
   os << x;
   return os.str();
 }
@@ -163,6 +189,11 @@ int exec_add(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ADD";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, a + b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() + std::move(y), quiet);
   return 0;
@@ -172,6 +203,11 @@ int exec_sub(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute SUB";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, a - b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() - std::move(y), quiet);
   return 0;
@@ -181,6 +217,11 @@ int exec_subr(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute SUBR";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, b - a);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(std::move(y) - stack.pop_int(), quiet);
   return 0;
@@ -190,6 +231,11 @@ int exec_negate(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute NEGATE";
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, -a);
+    return 0;
+  }
   stack.push_int_quiet(-stack.pop_int(), quiet);
   return 0;
 }
@@ -198,6 +244,11 @@ int exec_inc(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute INC";
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, a + 1);
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() + 1, quiet);
   return 0;
 }
@@ -206,6 +257,11 @@ int exec_dec(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute DEC";
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, a - 1);
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() - 1, quiet);
   return 0;
 }
@@ -215,6 +271,11 @@ int exec_add_tinyint8(VmState* st, unsigned args, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ADDINT " << x;
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, a + x);
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() + x, quiet);
   return 0;
 }
@@ -224,6 +285,11 @@ int exec_mul_tinyint8(VmState* st, unsigned args, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MULINT " << x;
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a) && fits_small_factor(a)) {
+    replace_small_int_args(stack, 1, a * x);
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() * x, quiet);
   return 0;
 }
@@ -232,6 +298,11 @@ int exec_mul(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MUL";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b) && fits_small_factor(a) && fits_small_factor(b)) {
+    replace_small_int_args(stack, 2, a * b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() * std::move(y), quiet);
   return 0;
@@ -609,6 +680,11 @@ int exec_rshift_tinyint8(VmState* st, unsigned args, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute RSHIFT " << x;
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, x < 63 ? a >> x : (a < 0 ? -1 : 0));
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() >> x, quiet);
   return 0;
 }
@@ -646,6 +722,11 @@ int exec_and(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute AND";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, a & b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() & std::move(y), quiet);
   return 0;
@@ -655,6 +736,11 @@ int exec_or(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute OR";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, a | b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() | std::move(y), quiet);
   return 0;
@@ -664,6 +750,11 @@ int exec_xor(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute XOR";
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, a ^ b);
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() ^ std::move(y), quiet);
   return 0;
@@ -673,6 +764,11 @@ int exec_not(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute NOT";
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, ~a);
+    return 0;
+  }
   stack.push_int_quiet(~stack.pop_int(), quiet);
   return 0;
 }
@@ -791,6 +887,17 @@ int exec_minmax(VmState* st, int mode) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MINMAXOP " << mode;
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    stack.pop_many(2);
+    if (mode & 2) {
+      stack.push_smallint(std::min(a, b));
+    }
+    if (mode & 4) {
+      stack.push_smallint(std::max(a, b));
+    }
+    return 0;
+  }
   auto x = stack.pop_int();
   auto y = stack.pop_int();
   if (!x->is_valid()) {
@@ -813,6 +920,11 @@ int exec_abs(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ABS";
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, a < 0 ? -a : a);
+    return 0;
+  }
   auto x = stack.pop_int();
   if (x->is_valid() && x->sgn() < 0) {
     stack.push_int_quiet(-std::move(x), quiet);
@@ -838,6 +950,11 @@ int exec_sgn(VmState* st, int mode, bool quiet, const char* name) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name;
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, ((mode >> (4 + small_int_cmp(a, 0) * 4)) & 15) - 8);
+    return 0;
+  }
   auto x = stack.pop_int();
   if (!x->is_valid()) {
     stack.push_int_quiet(std::move(x), quiet);
@@ -852,6 +969,11 @@ int exec_cmp(VmState* st, int mode, bool quiet, const char* name) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name;
   stack.check_underflow(2);
+  long long a, b;
+  if (get_small_int_args(stack, a, b)) {
+    replace_small_int_args(stack, 2, ((mode >> (4 + small_int_cmp(a, b) * 4)) & 15) - 8);
+    return 0;
+  }
   auto y = stack.pop_int();
   auto x = stack.pop_int();
   if (!x->is_valid() || !y->is_valid()) {
@@ -868,6 +990,11 @@ int exec_cmp_int(VmState* st, unsigned args, int mode, bool quiet, const char* n
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name << "INT " << y;
   stack.check_underflow(1);
+  long long a;
+  if (stack[0].get_small_int(a)) {
+    replace_small_int_args(stack, 1, ((mode >> (4 + small_int_cmp(a, y) * 4)) & 15) - 8);
+    return 0;
+  }
   auto x = stack.pop_int();
   if (!x->is_valid()) {
     stack.push_int_quiet(std::move(x), quiet);
@@ -882,6 +1009,10 @@ int exec_is_nan(VmState* st) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ISNAN";
   stack.check_underflow(1);
+  if (stack[0].is_small_int()) {
+    replace_small_int_args(stack, 1, 0);
+    return 0;
+  }
   auto x = stack.pop_int();
   stack.push_smallint(x->is_valid() ? 0 : -1);
   return 0;
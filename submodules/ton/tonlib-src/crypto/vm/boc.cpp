@@ -26,6 +26,7 @@
 #include "td/utils/Slice-decl.h"
 #include "td/utils/format.h"
 #include "td/utils/crypto.h"
+#include "td/utils/port/thread.h"
 
 namespace vm {
 using td::Ref;
@@ -396,6 +397,10 @@ td::uint64 BagOfCells::compute_sizes(int mode, int& r_size, int& o_size) {
   return data_bytes_adj;
 }
 
+void BagOfCells::set_threads(int threads) {
+  threads_ = threads > 0 ? threads : static_cast<int>(td::thread::hardware_concurrency());
+}
+
 std::size_t BagOfCells::estimate_serialized_size(int mode) {
   if ((mode & Mode::WithCacheBits) && !(mode & Mode::WithIndex)) {
     info.invalidate();
@@ -539,11 +544,7 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     std::size_t offs = 0;
     for (int i = cell_count - 1; i >= 0; --i) {
       const Ref<DataCell>& dc = cell_list_[i].dc_ref;
-      bool with_hash = (mode & Mode::WithIntHashes) && !cell_list_[i].wt;
-      if (cell_list_[i].is_root_cell && (mode & Mode::WithTopHash)) {
-        with_hash = true;
-      }
-      offs += dc->get_serialized_size(with_hash) + dc->size_refs() * info.ref_byte_size;
+      offs += dc->get_serialized_size(cell_with_hash(cell_list_[i], mode)) + dc->size_refs() * info.ref_byte_size;
       auto fixed_offset = offs;
       if (info.has_cache_bits) {
         fixed_offset = offs * 2 + cell_list_[i].should_cache;
@@ -554,38 +555,99 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
   }
   DCHECK(store_ptr - buffer == (long long)info.data_offset);
   unsigned char* keep_ptr = store_ptr;
-  for (int i = 0; i < cell_count; ++i) {
-    const auto& dc_info = cell_list_[cell_count - 1 - i];
-    const Ref<DataCell>& dc = dc_info.dc_ref;
-    bool with_hash = (mode & Mode::WithIntHashes) && !dc_info.wt;
-    if (dc_info.is_root_cell && (mode & Mode::WithTopHash)) {
-      with_hash = true;
-    }
-    int s = dc->serialize(store_ptr, 256, with_hash);
-    store_ptr += s;
-    store_chk();
-    DCHECK(dc->size_refs() == dc_info.ref_num);
-    // std::cerr << (dc_info.is_special() ? '*' : ' ') << i << '<' << (int)dc_info.wt << ">:";
-    for (unsigned j = 0; j < dc_info.ref_num; ++j) {
-      int k = cell_count - 1 - dc_info.ref_idx[j];
-      DCHECK(k > i && k < cell_count);
-      store_ref(k);
-      // std::cerr << ' ' << k;
+  bool parallel = threads_ > 1 && cell_count >= parallel_min_cells;
+  unsigned data_crc = 0;
+  if (parallel) {
+    data_crc = store_cells_parallel(store_ptr, mode, info.has_crc32c);
+    store_ptr += info.data_size;
+  } else {
+    for (int i = 0; i < cell_count; ++i) {
+      store_ptr += store_cell(store_ptr, i, mode);
+      store_chk();
     }
-    // std::cerr << std::endl;
   }
   store_chk();
   DCHECK(store_ptr - keep_ptr == (long long)info.data_size);
   DCHECK(store_end - store_ptr == (info.has_crc32c ? 4 : 0));
   if (info.has_crc32c) {
     // compute crc32c of buffer .. store_ptr
-    unsigned crc = td::crc32c(td::Slice{buffer, store_ptr});
+    unsigned crc = parallel ? td::crc32c_extend(td::crc32c(td::Slice{buffer, keep_ptr}), data_crc, info.data_size)
+                            : td::crc32c(td::Slice{buffer, store_ptr});
     store_uint(td::bswap32(crc), 4);
   }
   DCHECK(store_empty());
   return store_ptr - buffer;
 }
 
+bool BagOfCells::cell_with_hash(const CellInfo& dc_info, int mode) const {
+  return ((mode & Mode::WithIntHashes) && !dc_info.wt) || (dc_info.is_root_cell && (mode & Mode::WithTopHash));
+}
+
+// stores i-th cell (in serialization order) with its references, returns the number of bytes written
+std::size_t BagOfCells::store_cell(unsigned char* ptr, int i, int mode) {
+  const auto& dc_info = cell_list_[cell_count - 1 - i];
+  const Ref<DataCell>& dc = dc_info.dc_ref;
+  std::size_t s = dc->serialize(ptr, 256, cell_with_hash(dc_info, mode));
+  DCHECK(dc->size_refs() == dc_info.ref_num);
+  for (unsigned j = 0; j < dc_info.ref_num; ++j) {
+    int k = cell_count - 1 - dc_info.ref_idx[j];
+    DCHECK(k > i && k < cell_count);
+    info.write_ref(ptr + s, k);
+    s += info.ref_byte_size;
+  }
+  return s;
+}
+
+// splits cells into threads_ chunks of about the same serialized size and stores each chunk in its own thread;
+// returns crc32c of all stored data if with_crc is set, combined from crc32c of the chunks
+td::uint32 BagOfCells::store_cells_parallel(unsigned char* ptr, int mode, bool with_crc) {
+  struct Chunk {
+    int begin;
+    int end;
+    std::size_t offset;
+    std::size_t size;
+    td::uint32 crc;
+  };
+  std::vector<Chunk> chunks;
+  std::size_t chunk_size = info.data_size / threads_ + 1;
+  std::size_t offs = 0, chunk_offset = 0;
+  for (int i = 0, begin = 0; i < cell_count; i++) {
+    const auto& dc_info = cell_list_[cell_count - 1 - i];
+    offs += dc_info.dc_ref->get_serialized_size(cell_with_hash(dc_info, mode)) + dc_info.ref_num * info.ref_byte_size;
+    if (offs - chunk_offset >= chunk_size || i + 1 == cell_count) {
+      chunks.push_back(Chunk{begin, i + 1, chunk_offset, offs - chunk_offset, 0});
+      begin = i + 1;
+      chunk_offset = offs;
+    }
+  }
+  DCHECK(offs == info.data_size);
+
+  auto store_chunk = [&](Chunk& chunk) {
+    unsigned char* chunk_ptr = ptr + chunk.offset;
+    for (int i = chunk.begin; i < chunk.end; i++) {
+      chunk_ptr += store_cell(chunk_ptr, i, mode);
+    }
+    DCHECK(chunk_ptr == ptr + chunk.offset + chunk.size);
+    if (with_crc) {
+      chunk.crc = td::crc32c(td::Slice{ptr + chunk.offset, chunk.size});
+    }
+  };
+  std::vector<td::thread> workers;
+  for (std::size_t i = 1; i < chunks.size(); i++) {
+    workers.emplace_back([&store_chunk, &chunk = chunks[i]] { store_chunk(chunk); });
+  }
+  store_chunk(chunks[0]);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  td::uint32 crc = 0;
+  for (const auto& chunk : chunks) {
+    crc = td::crc32c_extend(crc, chunk.crc, chunk.size);
+  }
+  return crc;
+}
+
 unsigned long long BagOfCells::Info::read_int(const unsigned char* ptr, unsigned bytes) {
   unsigned long long res = 0;
   while (bytes > 0) {
@@ -895,6 +957,263 @@ unsigned long long BagOfCells::get_idx_entry_raw(int index) {
   }
 }
 
+/*
+ * 
+ *  Chunked BoC deserialization
+ * 
+ */
+
+td::Status BagOfCellsChunkedDeserializer::add_data(td::Slice data) {
+  if (state_ == State::Done) {
+    return td::Status::OK();
+  }
+  buffer_.append(data.data(), data.size());
+  auto status = parse();
+  buffer_.erase(0, buffer_pos_);
+  buffer_pos_ = 0;
+  return status;
+}
+
+td::Status BagOfCellsChunkedDeserializer::add_data(td::ChainBufferReader& reader) {
+  while (!reader.empty()) {
+    auto data = reader.prepare_read();
+    TRY_STATUS(add_data(data));
+    reader.confirm_read(data.size());
+  }
+  return td::Status::OK();
+}
+
+td::Status BagOfCellsChunkedDeserializer::add_data(td::FileFd& fd, std::size_t chunk_size) {
+  std::string chunk(chunk_size, '\0');
+  while (true) {
+    TRY_RESULT(size, fd.read(chunk));
+    if (size == 0) {
+      return td::Status::OK();
+    }
+    TRY_STATUS(add_data(td::Slice(chunk).truncate(size)));
+  }
+}
+
+void BagOfCellsChunkedDeserializer::consume(std::size_t size) {
+  if (info_.has_crc32c && state_ != State::Crc) {
+    crc_ = td::crc32c_extend(crc_, td::Slice(buffer_).substr(buffer_pos_, size));
+  }
+  buffer_pos_ += size;
+}
+
+td::Status BagOfCellsChunkedDeserializer::parse() {
+  while (true) {
+    auto data = td::Slice(buffer_).substr(buffer_pos_);
+    switch (state_) {
+      case State::Header: {
+        long long size_est = info_.parse_serialized_header(data);
+        if (size_est == 0) {
+          return td::Status::Error("cannot deserialize bag-of-cells: invalid header");
+        }
+        if (size_est < 0 || data.size() < info_.roots_offset) {
+          return td::Status::OK();
+        }
+        consume(td::narrow_cast<std::size_t>(info_.roots_offset));
+        if (info_.has_cache_bits) {
+          cell_should_cache_.resize(info_.cell_count, 0);
+        }
+        roots_.resize(info_.root_count);
+        state_ = State::Roots;
+        break;
+      }
+      case State::Roots: {
+        auto size = td::narrow_cast<std::size_t>(info_.index_offset - info_.roots_offset);
+        if (data.size() < size) {
+          return td::Status::OK();
+        }
+        for (int i = 0; i < info_.root_count; i++) {
+          int idx = 0;
+          if (info_.has_roots) {
+            idx = (int)info_.read_ref(data.ubegin() + i * info_.ref_byte_size);
+          }
+          if (idx < 0 || idx >= info_.cell_count) {
+            return td::Status::Error(PSLICE() << "bag-of-cells invalid root index " << idx);
+          }
+          root_idx_[idx].push_back(i);
+          if (info_.has_cache_bits) {
+            auto& cnt = cell_should_cache_[idx];
+            if (cnt < 2) {
+              cnt++;
+            }
+          }
+        }
+        consume(size);
+        state_ = State::Index;
+        break;
+      }
+      case State::Index: {
+        auto size = td::narrow_cast<std::size_t>(info_.data_offset - info_.index_offset);
+        if (data.size() < size) {
+          return td::Status::OK();
+        }
+        index_ = data.substr(0, size).str();
+        consume(size);
+        state_ = State::Cells;
+        break;
+      }
+      case State::Cells: {
+        if (next_cell_ == info_.cell_count) {
+          if (data_read_ != info_.data_size) {
+            return td::Status::Error(PSLICE() << "invalid bag-of-cells last cell #" << info_.cell_count - 1
+                                              << ": end offset " << data_read_ << " is different from total data size "
+                                              << info_.data_size);
+          }
+          state_ = info_.has_crc32c ? State::Crc : State::Done;
+          break;
+        }
+        if (data.size() < 2) {
+          return td::Status::OK();
+        }
+        CellSerializationInfo cell_info;
+        auto status = cell_info.init(data.ubegin()[0], data.ubegin()[1], info_.ref_byte_size);
+        if (status.is_error()) {
+          return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << next_cell_ << " "
+                                            << status.error());
+        }
+        if (data.size() < cell_info.end_offset) {
+          return td::Status::OK();
+        }
+        data_read_ += cell_info.end_offset;
+        if (data_read_ > info_.data_size) {
+          return td::Status::Error(PSLICE() << "invalid bag-of-cells cell #" << next_cell_
+                                            << " is out of data bounds");
+        }
+        if (info_.has_index) {
+          auto offs_end = get_idx_entry_raw(next_cell_);
+          if (info_.has_cache_bits) {
+            offs_end /= 2;
+          }
+          if (offs_end != data_read_) {
+            return td::Status::Error(PSLICE() << "invalid index entry " << offs_end << " for cell #" << next_cell_
+                                              << ", expected " << data_read_);
+          }
+        }
+        TRY_STATUS(add_cell(next_cell_, data.substr(0, cell_info.end_offset), cell_info));
+        consume(cell_info.end_offset);
+        next_cell_++;
+        break;
+      }
+      case State::Crc: {
+        if (data.size() < 4) {
+          return td::Status::OK();
+        }
+        unsigned crc_stored = td::as<unsigned>(data.ubegin());
+        if (crc_ != crc_stored) {
+          return td::Status::Error(PSLICE() << "bag-of-cells CRC32C mismatch: expected " << td::format::as_hex(crc_)
+                                            << ", found " << td::format::as_hex(crc_stored));
+        }
+        consume(4);
+        state_ = State::Done;
+        break;
+      }
+      case State::Done:
+        return td::Status::OK();
+    }
+  }
+}
+
+td::Status BagOfCellsChunkedDeserializer::add_cell(int idx, td::Slice cell, const CellSerializationInfo& cell_info) {
+  PendingCell pending;
+  for (int k = 0; k < cell_info.refs_cnt; k++) {
+    int ref_idx = (int)info_.read_ref(cell.ubegin() + cell_info.refs_offset + k * info_.ref_byte_size);
+    if (ref_idx <= idx) {
+      return td::Status::Error(PSLICE() << "bag-of-cells error: reference #" << k << " of cell #" << idx
+                                        << " is to cell #" << ref_idx << " with smaller index");
+    }
+    if (ref_idx >= info_.cell_count) {
+      return td::Status::Error(PSLICE() << "bag-of-cells error: reference #" << k << " of cell #" << idx
+                                        << " is to non-existent cell #" << ref_idx << ", only " << info_.cell_count
+                                        << " cells are defined");
+    }
+    waiting_[ref_idx].emplace_back(idx, k);
+    pending.unresolved++;
+    if (info_.has_cache_bits) {
+      auto& cnt = cell_should_cache_[ref_idx];
+      if (cnt < 2) {
+        cnt++;
+      }
+    }
+  }
+  pending.data = cell.str();
+  if (pending.unresolved != 0) {
+    pending_.emplace(idx, std::move(pending));
+    max_pending_cells_ = std::max(max_pending_cells_, pending_.size());
+    return td::Status::OK();
+  }
+  return create_cells(idx, std::move(pending));
+}
+
+// creates the cell and all its ancestors which have no more unresolved references
+td::Status BagOfCellsChunkedDeserializer::create_cells(int idx, PendingCell cell) {
+  std::vector<std::pair<int, PendingCell>> ready;
+  ready.emplace_back(idx, std::move(cell));
+  while (!ready.empty()) {
+    auto cur_idx = ready.back().first;
+    auto cur = std::move(ready.back().second);
+    ready.pop_back();
+
+    CellSerializationInfo cell_info;
+    TRY_STATUS(cell_info.init(cur.data, info_.ref_byte_size));
+    auto r_cell =
+        cell_info.create_data_cell(cur.data, td::MutableSpan<Ref<Cell>>(cur.refs).substr(0, cell_info.refs_cnt));
+    if (r_cell.is_error()) {
+      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << cur_idx << " "
+                                        << r_cell.error());
+    }
+    Ref<Cell> dc = r_cell.move_as_ok();
+    auto root_it = root_idx_.find(cur_idx);
+    if (root_it != root_idx_.end()) {
+      for (auto i : root_it->second) {
+        roots_[i] = dc;
+      }
+    }
+
+    auto it = waiting_.find(cur_idx);
+    if (it == waiting_.end()) {
+      continue;
+    }
+    for (auto& parent : it->second) {
+      auto parent_it = pending_.find(parent.first);
+      CHECK(parent_it != pending_.end());
+      parent_it->second.refs[parent.second] = dc;
+      if (--parent_it->second.unresolved == 0) {
+        ready.emplace_back(parent.first, std::move(parent_it->second));
+        pending_.erase(parent_it);
+      }
+    }
+    waiting_.erase(it);
+  }
+  return td::Status::OK();
+}
+
+td::Result<std::vector<Ref<Cell>>> BagOfCellsChunkedDeserializer::finish() {
+  if (state_ != State::Done) {
+    return td::Status::Error("cannot deserialize bag-of-cells: not enough bytes");
+  }
+  CHECK(pending_.empty());
+  if (info_.has_cache_bits) {
+    for (int idx = 0; idx < info_.cell_count; idx++) {
+      auto should_cache = cell_should_cache_[idx] > 1;
+      auto stored_should_cache = get_idx_entry_raw(idx) % 2 == 1;
+      if (should_cache != stored_should_cache) {
+        return td::Status::Error(PSLICE() << "invalid bag-of-cells cell #" << idx << " has wrong cache flag "
+                                          << stored_should_cache);
+      }
+    }
+  }
+  for (auto& root : roots_) {
+    if (root.is_null()) {
+      return td::Status::Error("bag of cells has a null root cell (?)");
+    }
+  }
+  return std::move(roots_);
+}
+
 /*
  * 
  *  Simple BoC serialization/deserialization functions
@@ -947,6 +1266,19 @@ td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data) {
   return std::move(roots);
 }
 
+td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi_file(td::CSlice path) {
+  TRY_RESULT(fd, td::FileFd::open(path, td::FileFd::Read));
+  BagOfCellsChunkedDeserializer deserializer;
+  TRY_STATUS(deserializer.add_data(fd));
+  TRY_RESULT(roots, deserializer.finish());
+  for (auto& root : roots) {
+    if (root->get_level() != 0) {
+      return td::Status::Error("bag of cells has a root with non-zero level");
+    }
+  }
+  return std::move(roots);
+}
+
 td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode) {
   if (root.is_null()) {
     return td::Status::Error("cannot serialize a null cell reference into a bag of cells");
@@ -973,6 +1305,28 @@ td::Result<td::BufferSlice> std_boc_serialize_multi(std::vector<Ref<Cell>> roots
   return boc.serialize_to_slice(mode);
 }
 
+td::Result<td::BufferSlice> std_boc_serialize_parallel(Ref<Cell> root, int mode, int threads) {
+  if (root.is_null()) {
+    return td::Status::Error("cannot serialize a null cell reference into a bag of cells");
+  }
+  BagOfCells boc;
+  boc.set_threads(threads);
+  boc.add_root(std::move(root));
+  TRY_STATUS(boc.import_cells());
+  return boc.serialize_to_slice(mode);
+}
+
+td::Result<td::BufferSlice> std_boc_serialize_multi_parallel(std::vector<Ref<Cell>> roots, int mode, int threads) {
+  if (roots.empty()) {
+    return td::BufferSlice{};
+  }
+  BagOfCells boc;
+  boc.set_threads(threads);
+  boc.add_roots(std::move(roots));
+  TRY_STATUS(boc.import_cells());
+  return boc.serialize_to_slice(mode);
+}
+
 /*
  * 
  *  Cell storage statistics
@@ -22,6 +22,7 @@
 #include "td/utils/Status.h"
 #include "td/utils/buffer.h"
 #include "td/utils/HashMap.h"
+#include "td/utils/port/FileFd.h"
 
 namespace vm {
 using td::Ref;
@@ -30,8 +31,14 @@ td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = fa
 td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode = 0);
 
 td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data);
+td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi_file(td::CSlice path);
 td::Result<td::BufferSlice> std_boc_serialize_multi(std::vector<Ref<Cell>> root, int mode = 0);
 
+// same output as std_boc_serialize(_multi), but cell data and crc32c are produced by several threads
+td::Result<td::BufferSlice> std_boc_serialize_parallel(Ref<Cell> root, int mode = 0, int threads = 0);
+td::Result<td::BufferSlice> std_boc_serialize_multi_parallel(std::vector<Ref<Cell>> root, int mode = 0,
+                                                             int threads = 0);
+
 class NewCellStorageStat {
  public:
   NewCellStorageStat() {
@@ -162,6 +169,7 @@ class BagOfCells {
   enum { hash_bytes = vm::Cell::hash_bytes };
   enum Mode { WithIndex = 1, WithCRC32C = 2, WithTopHash = 4, WithIntHashes = 8, WithCacheBits = 16, max = 31 };
   enum { max_cell_whs = 64 };
+  enum { parallel_min_cells = 1 << 12 };
   using Hash = Cell::Hash;
   struct Info {
     enum : td::uint32 { boc_idx = 0x68ff65f3, boc_idx_crc32c = 0xacc3a728, boc_generic = 0xb5ee9c72 };
@@ -204,6 +212,7 @@ class BagOfCells {
   int cell_count{0}, root_count{0}, dangle_count{0}, int_refs{0};
   int int_hashes{0}, top_hashes{0};
   int max_depth{1024};
+  int threads_{1};
   Info info;
   unsigned long long data_bytes{0};
   unsigned char* store_ptr{nullptr};
@@ -252,6 +261,8 @@ class BagOfCells {
   int add_root(td::Ref<vm::Cell> add_root);
   td::Status import_cells() TD_WARN_UNUSED_RESULT;
   BagOfCells() = default;
+  // number of threads used by serialize_to(); 0 means one per hardware thread
+  void set_threads(int threads);
   std::size_t estimate_serialized_size(int mode = 0);
   BagOfCells& serialize(int mode = 0);
   std::string serialize_to_string(int mode = 0);
@@ -301,6 +312,9 @@ class BagOfCells {
   void store_offset(unsigned long long value) {
     store_uint(value, info.offset_byte_size);
   }
+  bool cell_with_hash(const CellInfo& dc_info, int mode) const;
+  std::size_t store_cell(unsigned char* ptr, int i, int mode);
+  td::uint32 store_cells_parallel(unsigned char* ptr, int mode, bool with_crc);
   void reorder_cells();
   int revisit(int cell_idx, int force = 0);
   unsigned long long get_idx_entry_raw(int index);
@@ -311,4 +325,54 @@ class BagOfCells {
                                                      std::vector<td::uint8>* cell_should_cache);
 };
 
+// Deserializes a bag of cells fed in chunks of arbitrary size, so that the serialized bag never has to be
+// contiguous in memory. A cell is created as soon as all its children are created; until then its serialized
+// bytes are kept. References always point to cells later in the bag, so a parent is pending until its last
+// child arrives: the pending cells, like the index, are O(cell count) in the worst case, e.g. for a chain of
+// cells, and the peak memory usage is comparable to that of BagOfCells::deserialize().
+class BagOfCellsChunkedDeserializer {
+ public:
+  td::Status add_data(td::Slice data) TD_WARN_UNUSED_RESULT;
+  td::Status add_data(td::ChainBufferReader& reader) TD_WARN_UNUSED_RESULT;
+  td::Status add_data(td::FileFd& fd, std::size_t chunk_size = 1 << 20) TD_WARN_UNUSED_RESULT;
+  td::Result<std::vector<Ref<Cell>>> finish() TD_WARN_UNUSED_RESULT;
+
+  bool is_finished() const {
+    return state_ == State::Done;
+  }
+  std::size_t get_max_pending_cells() const {
+    return max_pending_cells_;
+  }
+
+ private:
+  enum class State { Header, Roots, Index, Cells, Crc, Done } state_{State::Header};
+  struct PendingCell {
+    std::string data;
+    std::array<Ref<Cell>, 4> refs;
+    int unresolved{0};
+  };
+
+  BagOfCells::Info info_;
+  std::string buffer_;
+  std::size_t buffer_pos_{0};
+  td::uint32 crc_{0};
+  std::string index_;
+  td::HashMap<int, std::vector<int>> root_idx_;  // cell index -> root numbers
+  std::vector<Ref<Cell>> roots_;
+  std::vector<td::uint8> cell_should_cache_;
+  int next_cell_{0};
+  unsigned long long data_read_{0};
+  td::HashMap<int, PendingCell> pending_;
+  td::HashMap<int, std::vector<std::pair<int, int>>> waiting_;  // child -> (parent, reference number)
+  std::size_t max_pending_cells_{0};
+
+  td::Status parse();
+  void consume(std::size_t size);
+  td::Status add_cell(int idx, td::Slice cell, const CellSerializationInfo& cell_info);
+  td::Status create_cells(int idx, PendingCell cell);
+  unsigned long long get_idx_entry_raw(int idx) {
+    return info_.read_offset(reinterpret_cast<const unsigned char*>(index_.data()) + (long)idx * info_.offset_byte_size);
+  }
+};
+
 }  // namespace vm
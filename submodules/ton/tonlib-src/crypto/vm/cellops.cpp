@@ -90,7 +90,7 @@ std::string dump_push_slice_common(CellSlice& cs, unsigned data_bits, unsigned r
   cs.advance(pfx_bits);
   auto slice = cs.fetch_subslice(data_bits, refs);
   slice.unique_write().remove_trailing();
-  std::ostringstream os{name};
+  std::ostringstream os{name, std::ios_base::ate};
   slice->dump_hex(os, 1, false);
   return os.str();
 }
@@ -175,7 +175,7 @@ std::string dump_push_cont(CellSlice& cs, unsigned args, int pfx_bits) {
   }
   cs.advance(pfx_bits);
   auto slice = cs.fetch_subslice(data_bits, refs);
-  std::ostringstream os{"PUSHCONT "};
+  std::ostringstream os{"PUSHCONT ", std::ios_base::ate};
   slice->dump_hex(os, 1, false);
   return os.str();
 }
@@ -206,7 +206,7 @@ std::string dump_push_cont_simple(CellSlice& cs, unsigned args, int pfx_bits) {
   }
   cs.advance(pfx_bits);
   auto slice = cs.fetch_subslice(data_bits);
-  std::ostringstream os{"PUSHCONT "};
+  std::ostringstream os{"PUSHCONT ", std::ios_base::ate};
   slice->dump_hex(os, 1, false);
   return os.str();
 }
@@ -616,7 +616,7 @@ int exec_store_int_fixed(VmState* st, unsigned args) {
 std::string dump_store_int_fixed(CellSlice& cs, unsigned args) {
   unsigned bits = (args & 0xff) + 1;
   bool sgnd = !(args & 0x100);
-  std::ostringstream s{"ST"};
+  std::ostringstream s{"ST", std::ios_base::ate};
   s << (sgnd ? 'I' : 'U');
   if (args & 0x200) {
     s << 'R';
@@ -1044,7 +1044,7 @@ int exec_load_int_fixed2(VmState* st, unsigned args) {
 }
 
 std::string dump_load_int_fixed2(CellSlice&, unsigned args) {
-  std::ostringstream os{args & 0x200 ? "PLD" : "LD"};
+  std::ostringstream os{args & 0x200 ? "PLD" : "LD", std::ios_base::ate};
   os << (args & 0x100 ? 'U' : 'I');
   if (args & 0x400) {
     os << 'Q';
@@ -1065,7 +1065,7 @@ int exec_preload_uint_fixed_0e(VmState* st, unsigned args) {
 }
 
 std::string dump_preload_uint_fixed_0e(CellSlice&, unsigned args) {
-  std::ostringstream os{"PLDUZ "};
+  std::ostringstream os{"PLDUZ ", std::ios_base::ate};
   unsigned bits = ((args & 7) + 1) << 5;
   os << bits;
   return os.str();
@@ -1092,7 +1092,7 @@ int exec_load_slice_fixed2(VmState* st, unsigned args) {
 
 std::string dump_load_slice_fixed2(CellSlice&, unsigned args) {
   unsigned bits = (args & 0xff) + 1;
-  std::ostringstream os{args & 0x100 ? "PLDSLICE" : "LDSLICE"};
+  std::ostringstream os{args & 0x100 ? "PLDSLICE" : "LDSLICE", std::ios_base::ate};
   if (args & 0x200) {
     os << 'Q';
   }
@@ -0,0 +1,103 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#include "vm/cells/CellArena.h"
+
+#include "td/utils/crypto.h"
+
+namespace vm {
+
+std::atomic<int> CellArena::active_count_{0};
+
+char* CellArena::allocate(size_t size, td::Ref<Chunk>& chunk) {
+  size = (size + alignof(void*) - 1) & ~(alignof(void*) - 1);
+  CHECK(size <= chunk_size);
+  if (chunk_size - chunk_used_ < size) {
+    chunk_ = td::Ref<Chunk>(true);
+    chunk_used_ = 0;
+    stats_.chunks_allocated++;
+  }
+  chunk = chunk_;
+  auto* res = chunk_->data + chunk_used_;
+  chunk_used_ += size;
+  return res;
+}
+
+td::uint32 CellArena::calc_hash(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special) {
+  DCHECK(data.offs == 0);
+  auto hash = td::crc32c(td::Slice(data.ptr, bits / 8));
+  unsigned char header[5] = {static_cast<unsigned char>(bits & 0xff), static_cast<unsigned char>(bits >> 8),
+                             static_cast<unsigned char>(refs.size()), static_cast<unsigned char>(special), 0};
+  if (bits & 7) {
+    header[4] = static_cast<unsigned char>(data.ptr[bits / 8] & (0xff00 >> (bits & 7)));
+  }
+  hash = td::crc32c_extend(hash, td::Slice(header, sizeof(header)));
+  for (auto& ref : refs) {
+    auto* ptr = ref.get();
+    hash = td::crc32c_extend(hash, td::Slice(reinterpret_cast<const unsigned char*>(&ptr), sizeof(ptr)));
+  }
+  return hash;
+}
+
+td::Ref<DataCell> CellArena::find(td::uint32 hash, td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs,
+                                  bool special) const {
+  if (cells_.empty()) {
+    return {};
+  }
+  auto mask = cells_.size() - 1;
+  for (auto i = hash & mask; cells_[i].not_null(); i = (i + 1) & mask) {
+    auto& cell = cells_[i];
+    if (cell_hashes_[i] != hash || cell->size() != bits || cell->size_refs() != refs.size() ||
+        cell->is_special() != special) {
+      continue;
+    }
+    bool is_same_refs = true;
+    for (unsigned j = 0; j < refs.size(); j++) {
+      is_same_refs &= cell->get_ref_raw_ptr(j) == refs[j].get();
+    }
+    if (is_same_refs && td::bitstring::bits_memcmp(data, td::ConstBitPtr{cell->get_data()}, bits) == 0) {
+      return cell;
+    }
+  }
+  return {};
+}
+
+void CellArena::insert(td::uint32 hash, td::Ref<DataCell> cell) {
+  if ((cells_count_ + 1) * 2 > cells_.size()) {
+    auto old_cells = std::move(cells_);
+    auto old_hashes = std::move(cell_hashes_);
+    cells_ = std::vector<td::Ref<DataCell>>(td::max<size_t>(old_cells.size() * 2, 64));
+    cell_hashes_ = std::vector<td::uint32>(cells_.size());
+    cells_count_ = 0;
+    for (size_t i = 0; i < old_cells.size(); i++) {
+      if (old_cells[i].not_null()) {
+        insert(old_hashes[i], std::move(old_cells[i]));
+      }
+    }
+  }
+  auto mask = cells_.size() - 1;
+  auto i = hash & mask;
+  while (cells_[i].not_null()) {
+    i = (i + 1) & mask;
+  }
+  cells_[i] = std::move(cell);
+  cell_hashes_[i] = hash;
+  cells_count_++;
+}
+
+}  // namespace vm
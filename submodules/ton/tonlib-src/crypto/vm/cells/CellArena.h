@@ -0,0 +1,94 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+#include "vm/cells/DataCell.h"
+
+#include "td/utils/Context.h"
+
+#include <atomic>
+#include <vector>
+
+namespace vm {
+
+// While a CellArena is active on the current thread, DataCell::create() takes the storage of new cells from
+// shared chunks instead of allocating it separately for every cell. With hash consing enabled it also returns
+// the cell already created in this arena for the same data, references and special flag, so that neither
+// the storage nor the representation hash of a duplicate is computed again.
+//
+// A chunk is freed together with the last cell stored in it, so cells may outlive the arena, but a single
+// long-living cell keeps its whole chunk alive. The hash consing table keeps every cell created in the arena
+// alive until the arena is destroyed. Hence an arena is meant to cover one transaction or one get method run.
+// Without an arena, DataCell::create() pays only for a relaxed load of the number of existing arenas.
+class CellArena : public td::Context<CellArena> {
+ public:
+  struct Stats {
+    td::int64 cells_created{0};
+    td::int64 cells_reused{0};
+    td::int64 chunks_allocated{0};
+  };
+
+  explicit CellArena(bool hash_consing = true) : hash_consing_(hash_consing) {
+    active_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  ~CellArena() {
+    active_count_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  CellArena(const CellArena&) = delete;
+  CellArena& operator=(const CellArena&) = delete;
+
+  // the arena of the current thread; the thread local is not read while there are no arenas in the process
+  static CellArena* get_active() {
+    return active_count_.load(std::memory_order_relaxed) == 0 ? nullptr : get();
+  }
+
+  const Stats& get_stats() const {
+    return stats_;
+  }
+
+ private:
+  friend class DataCell;
+
+  static constexpr size_t chunk_size = 4096;
+  class Chunk : public td::CntObject {
+   public:
+    Chunk() {  // leaves data uninitialized
+    }
+    // cells write their storage through the const Ref they hold
+    alignas(alignof(void*)) mutable char data[chunk_size];
+  };
+
+  static std::atomic<int> active_count_;
+  Guard guard_{this};
+  bool hash_consing_;
+  Stats stats_;
+  td::Ref<Chunk> chunk_;
+  size_t chunk_used_{chunk_size};
+  // open addressing hash table, its size is zero or a power of two
+  std::vector<td::Ref<DataCell>> cells_;
+  std::vector<td::uint32> cell_hashes_;
+  size_t cells_count_{0};
+
+  char* allocate(size_t size, td::Ref<Chunk>& chunk);
+  static td::uint32 calc_hash(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special);
+  td::Ref<DataCell> find(td::uint32 hash, td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs,
+                         bool special) const;
+  void insert(td::uint32 hash, td::Ref<DataCell> cell);
+};
+
+}  // namespace vm
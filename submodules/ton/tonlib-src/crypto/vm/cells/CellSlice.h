@@ -79,6 +79,10 @@ class CellSlice : public td::CntObject {
   bool is_valid() const {
     return cell.not_null();
   }
+  // representation hash of the whole cell the slice is a part of
+  Cell::Hash get_base_cell_hash() const {
+    return cell->get_hash();
+  }
   Cell::SpecialType special_type() const {
     return cell->special_type();
   }
@@ -88,5 +88,34 @@ class CellWithUniquePtrStorage : public CellT {
     return storage_.get();
   }
 };
+
+// the storage lives in a chunk shared with other cells, which is kept alive by the cell
+template <class CellT, class ChunkT>
+class CellWithArenaStorage : public CellT {
+ public:
+  template <class... ArgsT>
+  CellWithArenaStorage(td::Ref<ChunkT> chunk, char* storage, ArgsT&&... args)
+      : CellT(std::forward<ArgsT>(args)...), chunk_(std::move(chunk)), storage_(storage) {
+  }
+  ~CellWithArenaStorage() {
+    CellT::destroy_storage(get_storage());
+  }
+
+  template <class... ArgsT>
+  static std::unique_ptr<CellT> create(td::Ref<ChunkT> chunk, char* storage, ArgsT&&... args) {
+    return std::make_unique<CellWithArenaStorage>(std::move(chunk), storage, std::forward<ArgsT>(args)...);
+  }
+
+ private:
+  td::Ref<ChunkT> chunk_;
+  char* storage_;
+
+  const char* get_storage() const final {
+    return storage_;
+  }
+  char* get_storage() final {
+    return storage_;
+  }
+};
 }  // namespace detail
 }  // namespace vm
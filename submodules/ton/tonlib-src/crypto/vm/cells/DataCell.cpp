@@ -22,10 +22,16 @@
 
 #include "td/utils/ScopeGuard.h"
 
+#include "vm/cells/CellArena.h"
 #include "vm/cells/CellWithStorage.h"
 
 namespace vm {
-std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
+std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info, CellArena* arena) {
+  if (arena) {
+    td::Ref<CellArena::Chunk> chunk;
+    auto* storage = arena->allocate(info.get_storage_size(), chunk);
+    return detail::CellWithArenaStorage<DataCell, CellArena::Chunk>::create(std::move(chunk), storage, info);
+  }
   return detail::CellWithUniquePtrStorage<DataCell>::create(info.get_storage_size(), info);
 }
 
@@ -68,6 +74,21 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     }
   }
 
+  auto* arena = CellArena::get_active();
+  bool use_hash_consing = arena && arena->hash_consing_ && data.offs == 0;
+  td::uint32 content_hash = 0;
+  if (use_hash_consing) {
+    content_hash = CellArena::calc_hash(data, bits, refs, special);
+    auto cell = arena->find(content_hash, data, bits, refs, special);
+    if (cell.not_null()) {
+      arena->stats_.cells_reused++;
+      for (auto& ref : refs) {
+        ref.clear();
+      }
+      return std::move(cell);
+    }
+  }
+
   SpecialType type = SpecialType::Ordinary;
   if (special) {
     if (bits < 8) {
@@ -188,7 +209,7 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
   info.hash_count_ = hash_count & 7;
   info.virtualization_ = virtualization & 7;
 
-  auto data_cell = create_empty_data_cell(info);
+  auto data_cell = create_empty_data_cell(info, arena);
   auto* storage = data_cell->get_storage();
 
   // init data
@@ -281,7 +302,14 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     DCHECK(extracted_size == hash_bytes);
   }
 
-  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+  auto res = Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+  if (arena) {
+    arena->stats_.cells_created++;
+    if (use_hash_consing) {
+      arena->insert(content_hash, res);
+    }
+  }
+  return res;
 }
 
 const DataCell::Hash DataCell::do_get_hash(td::uint32 level) const {
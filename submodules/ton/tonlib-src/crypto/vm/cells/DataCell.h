@@ -25,6 +25,8 @@
 
 namespace vm {
 
+class CellArena;
+
 class DataCell : public Cell {
  public:
   DataCell(const DataCell& other) = delete;
@@ -195,12 +197,13 @@ class DataCell : public Cell {
     static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DataCell");
     return res;
   }
-  static std::unique_ptr<DataCell> create_empty_data_cell(Info info);
+  static std::unique_ptr<DataCell> create_empty_data_cell(Info info, CellArena* arena);
 
   const Hash do_get_hash(td::uint32 level) const override;
   td::uint16 do_get_depth(td::uint32 level) const override;
 
   friend class CellBuilder;
+  friend class CellArena;
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special);
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
                                           bool special);
@@ -20,6 +20,9 @@
 #include "vm/continuation.h"
 #include "vm/dict.h"
 #include "vm/log.h"
+#include "vm/profiler.h"
+
+#include "td/utils/ScopeGuard.h"
 
 namespace vm {
 
@@ -707,14 +710,43 @@ int VmState::step() {
   }
 }
 
+int VmState::profiled_step() {
+  profiler->finish_step(gas.gas_consumed());
+  std::string instr;
+  if (code->size()) {
+    try {
+      // disassembling must neither charge for cell loads nor change the outcome of the step
+      VmStateInterface::Guard guard{nullptr};
+      CellSlice cs{*code};
+      instr = dispatch->dump_instr(cs);
+      instr.resize(std::min(instr.size(), instr.find(' ')));
+    } catch (...) {
+    }
+    if (instr.empty()) {
+      instr = "(invalid)";
+    }
+  } else if (code->size_refs()) {
+    instr = "JMPREF(implicit)";
+  } else {
+    instr = "RET(implicit)";
+  }
+  profiler->start_step(code->get_base_cell_hash(), std::move(instr), gas.gas_consumed());
+  return step();
+}
+
 int VmState::run() {
   int res;
   Guard guard(this);
+  SCOPE_EXIT {
+    if (profiler) {
+      profiler->finish_step(gas.gas_consumed());
+    }
+  };
   do {
     // LOG(INFO) << "[BS] data cells: " << DataCell::get_total_data_cells();
     try {
       try {
-        res = step();
+        res = profiler ? profiled_step() : step();
         gas.check();
       } catch (vm::CellBuilder::CellWriteError) {
         throw VmError{Excno::cell_ov};
@@ -843,10 +875,16 @@ bool VmState::register_library_collection(Ref<Cell> lib) {
 }
 
 void VmState::register_cell_load() {
+  if (profiler) {
+    profiler->register_cell_load();
+  }
   consume_gas(cell_load_gas_price);
 }
 
 void VmState::register_cell_create() {
+  if (profiler) {
+    profiler->register_cell_create();
+  }
   consume_gas(cell_create_gas_price);
 }
 
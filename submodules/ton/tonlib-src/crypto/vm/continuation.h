@@ -31,6 +31,7 @@ using td::Ref;
 class VmState;
 class Continuation;
 class DispatchTable;
+class VmProfiler;
 
 struct ControlRegs {
   static constexpr int creg_num = 4, dreg_num = 2, dreg_idx = 4;
@@ -395,6 +396,7 @@ class VmState final : public VmStateInterface {
   int stack_trace{0}, debug_off{0};
 
   bool chksig_always_succeed{false};
+  VmProfiler* profiler{nullptr};
 
  public:
   static constexpr unsigned cell_load_gas_price = 100, cell_create_gas_price = 500, exception_gas_price = 50,
@@ -597,9 +599,14 @@ class VmState final : public VmStateInterface {
   bool get_chksig_always_succeed() const {
     return chksig_always_succeed;
   }
+  // collects statistics of the following runs into *_profiler, which must outlive them; nullptr disables profiling
+  void set_profiler(VmProfiler* _profiler) {
+    profiler = _profiler;
+  }
 
  private:
   void init_cregs(bool same_c3 = false, bool push_0 = true);
+  int profiled_step();
 };
 
 int run_vm_code(Ref<CellSlice> _code, Ref<Stack>& _stack, int flags = 0, Ref<Cell>* data_ptr = 0, VmLog log = {},
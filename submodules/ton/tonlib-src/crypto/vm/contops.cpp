@@ -329,7 +329,7 @@ int exec_if_bit_jmp(VmState* st, unsigned args) {
 }
 
 std::string dump_if_bit_jmp(CellSlice& cs, unsigned args) {
-  std::ostringstream os{args & 0x20 ? "IFN" : " IF"};
+  std::ostringstream os{args & 0x20 ? "IFN" : "IF", std::ios_base::ate};
   os << "BITJMP " << (args & 0x1f);
   return os.str();
 }
@@ -359,7 +359,7 @@ std::string dump_if_bit_jmpref(CellSlice& cs, unsigned args, int pfx_bits) {
   }
   cs.advance(pfx_bits);
   cs.advance_refs(1);
-  std::ostringstream os{args & 0x20 ? "IFN" : " IF"};
+  std::ostringstream os{args & 0x20 ? "IFN" : "IF", std::ios_base::ate};
   os << "BITJMPREF " << (args & 0x1f);
   return os.str();
 }
@@ -515,7 +515,7 @@ int exec_setcontargs(VmState* st, unsigned args) {
 
 std::string dump_setcontargs(CellSlice& cs, unsigned args, const char* name) {
   int copy = (args >> 4) & 15, more = ((args + 1) & 15) - 1;
-  std::ostringstream os{name};
+  std::ostringstream os{name, std::ios_base::ate};
   os << ' ' << copy << ',' << more;
   return os.str();
 }
@@ -954,7 +954,7 @@ std::string dump_throw_any(CellSlice& cs, unsigned args) {
   bool has_param = args & 1;
   bool has_cond = args & 6;
   bool throw_cond = args & 2;
-  std::ostringstream os{has_param ? "THROWARG" : "THROW"};
+  std::ostringstream os{has_param ? "THROWARG" : "THROW", std::ios_base::ate};
   os << "ANY";
   if (has_cond) {
     os << (throw_cond ? "IF" : "IFNOT");
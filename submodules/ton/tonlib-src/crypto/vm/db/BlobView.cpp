@@ -36,6 +36,13 @@ td::Result<td::Slice> BlobView::view(td::MutableSlice slice, td::uint64 offset)
   }
   return view_impl(slice, offset);
 }
+td::Result<td::Slice> BlobView::view_in_place(std::size_t size, td::uint64 offset) {
+  if (offset > this->size() || size > this->size() - offset) {
+    return td::Status::Error(PSLICE() << "BlobView: invalid range requested " << td::tag("slice offset", offset)
+                                      << td::tag("slice size", size) << td::tag("blob size", this->size()));
+  }
+  return view_in_place_impl(size, offset);
+}
 namespace {
 class BufferSliceBlobViewImpl : public BlobView {
  public:
@@ -48,6 +55,12 @@ class BufferSliceBlobViewImpl : public BlobView {
     }
     return slice_.as_slice().substr(static_cast<std::size_t>(offset), slice.size());
   }
+  td::Result<td::Slice> view_in_place_impl(std::size_t size, td::uint64 offset) override {
+    return slice_.as_slice().substr(static_cast<std::size_t>(offset), size);
+  }
+  bool supports_view_in_place() const override {
+    return true;
+  }
   td::uint64 size() override {
     return slice_.size();
   }
@@ -156,6 +169,12 @@ class FileMemoryMappingBlobViewImpl : public BlobView {
     // optimize anyway
     return mapping_.as_slice().substr(offset, slice.size());
   }
+  td::Result<td::Slice> view_in_place_impl(std::size_t size, td::uint64 offset) override {
+    return mapping_.as_slice().substr(offset, size);
+  }
+  bool supports_view_in_place() const override {
+    return true;
+  }
   td::uint64 size() override {
     return mapping_.as_slice().size();
   }
@@ -24,10 +24,18 @@ class BlobView {
  public:
   virtual ~BlobView() = default;
   td::Result<td::Slice> view(td::MutableSlice slice, td::uint64 offset);
+  // Returns slice of the blob's own memory without any copying. Supported only if supports_view_in_place()
+  td::Result<td::Slice> view_in_place(std::size_t size, td::uint64 offset);
+  virtual bool supports_view_in_place() const {
+    return false;
+  }
   virtual td::uint64 size() = 0;
 
  private:
   virtual td::Result<td::Slice> view_impl(td::MutableSlice slice, td::uint64 offset) = 0;
+  virtual td::Result<td::Slice> view_in_place_impl(std::size_t size, td::uint64 offset) {
+    return td::Status::Error("BlobView: in-place view is not supported");
+  }
 };
 
 class BufferSliceBlobView {
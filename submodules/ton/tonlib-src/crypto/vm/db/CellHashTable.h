@@ -21,6 +21,7 @@
 #include "td/utils/Slice.h"
 
 #include <set>
+#include <string>
 
 namespace vm {
 template <class InfoT>
@@ -65,7 +66,27 @@ class CellHashTable {
     return set_.size();
   }
 
+  // CLOCK sweep: visits elements cyclically, starting right after the element visited last time.
+  // f(info) returns true if the element must be erased; stops when stop() returns true or after two full rounds.
+  template <class StopF, class F>
+  void clock_sweep(StopF &&stop, F &&f) {
+    auto left = set_.size() * 2;
+    auto it = set_.upper_bound(td::Slice(clock_hand_));
+    while (left-- > 0 && !set_.empty() && !stop()) {
+      if (it == set_.end()) {
+        it = set_.begin();
+      }
+      clock_hand_ = it->key().as_slice().str();
+      if (f(const_cast<InfoT &>(*it))) {
+        it = set_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
  private:
   std::set<InfoT, std::less<>> set_;
+  std::string clock_hand_;
 };
 }  // namespace vm
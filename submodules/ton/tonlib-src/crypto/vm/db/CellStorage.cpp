@@ -128,9 +128,27 @@ CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader) : reader_(std::mo
 
 td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator) {
   //LOG(ERROR) << "Storage: load cell " << hash.size() << " " << td::base64_encode(hash);
-  LoadResult res;
   std::string serialized;
   TRY_RESULT(get_status, reader_->get(hash, serialized));
+  return parse(get_status, serialized, need_data, ext_cell_creator);
+}
+
+td::Result<std::vector<CellLoader::LoadResult>> CellLoader::load_multi(td::Span<td::Slice> hashes, bool need_data,
+                                                                       ExtCellCreator &ext_cell_creator) {
+  std::vector<std::string> serialized;
+  TRY_RESULT(get_statuses, reader_->get_multi(hashes, serialized));
+  std::vector<LoadResult> res;
+  res.reserve(hashes.size());
+  for (size_t i = 0; i < hashes.size(); i++) {
+    TRY_RESULT(load_result, parse(get_statuses[i], serialized[i], need_data, ext_cell_creator));
+    res.push_back(std::move(load_result));
+  }
+  return std::move(res);
+}
+
+td::Result<CellLoader::LoadResult> CellLoader::parse(KeyValue::GetStatus get_status, td::Slice serialized,
+                                                     bool need_data, ExtCellCreator &ext_cell_creator) {
+  LoadResult res;
   if (get_status != KeyValue::GetStatus::Ok) {
     DCHECK(get_status == KeyValue::GetStatus::NotFound);
     return res;
@@ -48,8 +48,14 @@ class CellLoader {
   };
   CellLoader(std::shared_ptr<KeyValueReader> reader);
   td::Result<LoadResult> load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator);
+  // Same as load, but fetches all hashes with a single KeyValueReader::get_multi
+  td::Result<std::vector<LoadResult>> load_multi(td::Span<td::Slice> hashes, bool need_data,
+                                                 ExtCellCreator &ext_cell_creator);
 
  private:
+  static td::Result<LoadResult> parse(KeyValue::GetStatus get_status, td::Slice serialized, bool need_data,
+                                      ExtCellCreator &ext_cell_creator);
+
   std::shared_ptr<KeyValueReader> reader_;
 };
 
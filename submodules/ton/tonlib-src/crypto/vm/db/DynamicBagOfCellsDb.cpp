@@ -24,10 +24,13 @@
 
 #include "td/utils/base64.h"
 #include "td/utils/format.h"
+#include "td/utils/HashMap.h"
 #include "td/utils/ThreadSafeCounter.h"
 
 #include "vm/cellslice.h"
 
+#include <mutex>
+
 namespace vm {
 namespace {
 
@@ -57,6 +60,9 @@ struct CellInfo {
   bool was_dfs_new_cells{false};
   bool was{false};
 
+  bool cache_referenced{false};
+  td::uint32 cache_bytes{0};
+
   td::int32 db_refcnt{0};
   td::int32 refcnt_diff{0};
   Ref<Cell> cell;
@@ -78,7 +84,7 @@ bool operator<(td::Slice a, const CellInfo &b) {
 
 class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreator {
  public:
-  DynamicBagOfCellsDbImpl() {
+  explicit DynamicBagOfCellsDbImpl(CacheOptions cache_options) : cache_options_(cache_options) {
     get_thread_safe_counter().add(1);
   }
   ~DynamicBagOfCellsDbImpl() {
@@ -89,18 +95,23 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     return get_cell_info_lazy(level_mask, hash, depth).cell;
   }
   td::Result<Ref<DataCell>> load_cell(td::Slice hash) override {
+    evict_clean_cells();
     TRY_RESULT(loaded_cell, get_cell_info_force(hash).cell->load_cell());
+    if (cell_db_reader_) {
+      cell_db_reader_->prefetch_refs(*loaded_cell.data_cell);
+    }
     return std::move(loaded_cell.data_cell);
   }
   CellInfo &get_cell_info_force(td::Slice hash) {
-    return hash_table_.apply(hash, [&](CellInfo &info) { update_cell_info_force(info, hash); });
+    return touch(hash_table_.apply(hash, [&](CellInfo &info) { update_cell_info_force(info, hash); }));
   }
   CellInfo &get_cell_info_lazy(Cell::LevelMask level_mask, td::Slice hash, td::Slice depth) {
-    return hash_table_.apply(hash.substr(hash.size() - Cell::hash_bytes),
-                             [&](CellInfo &info) { update_cell_info_lazy(info, level_mask, hash, depth); });
+    return touch(hash_table_.apply(hash.substr(hash.size() - Cell::hash_bytes),
+                                   [&](CellInfo &info) { update_cell_info_lazy(info, level_mask, hash, depth); }));
   }
   CellInfo &get_cell_info(const Ref<Cell> &cell) {
-    return hash_table_.apply(cell->get_hash().as_slice(), [&](CellInfo &info) { update_cell_info(info, cell); });
+    return touch(
+        hash_table_.apply(cell->get_hash().as_slice(), [&](CellInfo &info) { update_cell_info(info, cell); }));
   }
 
   void inc(const Ref<Cell> &cell) override {
@@ -162,6 +173,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
 
     to_inc_.clear();
     to_dec_.clear();
+    evict_clean_cells();
 
     return td::Status::OK();
   }
@@ -182,7 +194,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     //cell_db_reader_ = std::make_shared<CellDbReaderImpl>(this);
     // Temporary(?) fix to make ExtCell thread safe.
     // Downside(?) - loaded cells won't be cached
-    cell_db_reader_ = std::make_shared<CellDbReaderImpl>(std::make_unique<CellLoader>(*loader_));
+    cell_db_reader_ =
+        std::make_shared<CellDbReaderImpl>(std::make_unique<CellLoader>(*loader_), cache_options_.batch_loads);
     stats_diff_ = {};
     return td::Status::OK();
   }
@@ -194,6 +207,9 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   CellHashTable<CellInfo> hash_table_;
   std::vector<CellInfo *> visited_;
   Stats stats_diff_;
+  Stats cache_stats_;
+  CacheOptions cache_options_;
+  td::uint64 cache_bytes_{0};
 
   static td::NamedThreadSafeCounter::CounterRef get_thread_safe_counter() {
     static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DynamicBagOfCellsDb");
@@ -204,7 +220,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
                            private ExtCellCreator,
                            public std::enable_shared_from_this<CellDbReaderImpl> {
    public:
-    CellDbReaderImpl(std::unique_ptr<CellLoader> cell_loader) : db_(nullptr), cell_loader_(std::move(cell_loader)) {
+    CellDbReaderImpl(std::unique_ptr<CellLoader> cell_loader, bool batch_loads)
+        : db_(nullptr), cell_loader_(std::move(cell_loader)), batch_loads_(batch_loads) {
       if (cell_loader_) {
         get_thread_safe_counter().add(1);
       }
@@ -239,9 +256,54 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       if (db_) {
         return db_->load_cell(hash);
       }
-      TRY_RESULT(load_result, cell_loader_->load(hash, true, *this));
-      CHECK(load_result.status == CellLoader::LoadResult::Ok);
-      return std::move(load_result.cell());
+      auto cell = take_prefetched(hash);
+      if (cell.is_null()) {
+        TRY_RESULT(load_result, cell_loader_->load(hash, true, *this));
+        CHECK(load_result.status == CellLoader::LoadResult::Ok);
+        cell = std::move(load_result.cell());
+      }
+      prefetch_refs(*cell);
+      return std::move(cell);
+    }
+
+    // an ExtCell is usually loaded right before its siblings, so fetch all unresolved refs with one get_multi
+    void prefetch_refs(const DataCell &cell) {
+      if (!batch_loads_ || !cell_loader_) {
+        return;
+      }
+      std::vector<Cell::Hash> hashes;
+      {
+        std::lock_guard<std::mutex> guard(prefetched_mutex_);
+        for (unsigned i = 0; i < cell.size_refs(); i++) {
+          auto ref = cell.get_ref(i);
+          if (!ref->is_loaded() && prefetched_.count(ref->get_hash()) == 0) {
+            hashes.push_back(ref->get_hash());
+          }
+        }
+      }
+      if (hashes.size() < 2) {
+        return;
+      }
+      std::vector<td::Slice> hash_slices;
+      for (auto &hash : hashes) {
+        hash_slices.push_back(hash.as_slice());
+      }
+      auto r_res = cell_loader_->load_multi(hash_slices, true, *this);
+      if (r_res.is_error()) {
+        // cells will be loaded one by one later
+        return;
+      }
+      auto res = r_res.move_as_ok();
+      std::lock_guard<std::mutex> guard(prefetched_mutex_);
+      // refs which are never visited must not pile up
+      if (prefetched_.size() + hashes.size() > max_prefetched_cells) {
+        prefetched_.clear();
+      }
+      for (size_t i = 0; i < hashes.size(); i++) {
+        if (res[i].status == CellLoader::LoadResult::Ok) {
+          prefetched_.emplace(hashes[i], std::move(res[i].cell()));
+        }
+      }
     }
 
    private:
@@ -249,8 +311,26 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DynamicBagOfCellsDbLoader");
       return res;
     }
+    static constexpr size_t max_prefetched_cells = 1 << 12;
     DynamicBagOfCellsDb *db_;
     std::unique_ptr<CellLoader> cell_loader_;
+    bool batch_loads_{false};
+    std::mutex prefetched_mutex_;
+    td::HashMap<Cell::Hash, Ref<DataCell>, std::hash<Cell::Hash>> prefetched_;
+
+    Ref<DataCell> take_prefetched(td::Slice hash) {
+      if (!batch_loads_) {
+        return {};
+      }
+      std::lock_guard<std::mutex> guard(prefetched_mutex_);
+      auto it = prefetched_.find(Cell::Hash::from_slice(hash));
+      if (it == prefetched_.end()) {
+        return {};
+      }
+      auto cell = std::move(it->second);
+      prefetched_.erase(it);
+      return cell;
+    }
   };
 
   std::shared_ptr<CellDbReaderImpl> cell_db_reader_;
@@ -263,6 +343,44 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     cell_db_reader_.reset();
     //EXPERIMENTAL: clear cache to drop all references to old reader.
     hash_table_ = {};
+    cache_bytes_ = 0;
+  }
+
+  CellInfo &touch(CellInfo &info) {
+    if (!cache_options_.max_bytes) {
+      return info;
+    }
+    info.cache_referenced = true;
+    auto bytes = static_cast<td::uint32>(sizeof(CellInfo) + 4 * sizeof(void *));
+    if (info.cell.not_null() && info.cell->is_loaded()) {
+      bytes += static_cast<td::uint32>(sizeof(DataCell)) +
+               info.cell->load_cell().move_as_ok().data_cell->get_serialized_size(true);
+    }
+    cache_bytes_ -= info.cache_bytes;
+    cache_bytes_ += bytes;
+    info.cache_bytes = bytes;
+    return info;
+  }
+
+  // must not be called while references to CellInfo are held, i.e. only on entry to load_cell or after prepare_commit
+  void evict_clean_cells() {
+    if (!cache_options_.max_bytes || cache_bytes_ <= cache_options_.max_bytes) {
+      return;
+    }
+    hash_table_.clock_sweep([&] { return cache_bytes_ <= cache_options_.max_bytes; },
+                            [&](CellInfo &info) {
+                              // cells of a pending diff are pinned, not yet loaded cells are cheap to keep
+                              if (info.was || info.was_dfs_new_cells || info.refcnt_diff != 0 || !info.sync_with_db) {
+                                return false;
+                              }
+                              if (info.cache_referenced) {
+                                info.cache_referenced = false;
+                                return false;
+                              }
+                              cache_bytes_ -= info.cache_bytes;
+                              cache_stats_.cache_evictions++;
+                              return true;
+                            });
   }
 
   bool is_in_db(CellInfo &info) {
@@ -323,27 +441,82 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     for_each(info, [this](auto &child_info) { dfs_new_cells(child_info); });
   }
 
-  void dfs_old_cells(CellInfo &info) {
-    info.refcnt_diff--;
-    if (!info.was) {
-      info.was = true;
-      visited_.push_back(&info);
+  // processed level by level, so that all cells of a level can be fetched with one get_multi
+  void dfs_old_cells(CellInfo &root_info) {
+    std::vector<CellInfo *> level{&root_info};
+    std::vector<CellInfo *> next_level;
+    while (!level.empty()) {
+      prefetch_cells(level);
+      for (auto info_ptr : level) {
+        auto &info = *info_ptr;
+        info.refcnt_diff--;
+        if (!info.was) {
+          info.was = true;
+          visited_.push_back(&info);
+        }
+        //LOG(ERROR) << "dfs old " << td::format::escaped(info.cell->hash());
+
+        load_cell(info);
+
+        auto new_refcnt = info.refcnt_diff + info.db_refcnt;
+        CHECK(new_refcnt >= 0);
+        if (new_refcnt != 0) {
+          continue;
+        }
+
+        for_each(info, [&next_level](auto &child_info) { next_level.push_back(&child_info); });
+      }
+      level.clear();
+      std::swap(level, next_level);
     }
-    //LOG(ERROR) << "dfs old " << td::format::escaped(info.cell->hash());
-
-    load_cell(info);
+  }
 
-    auto new_refcnt = info.refcnt_diff + info.db_refcnt;
-    CHECK(new_refcnt >= 0);
-    if (new_refcnt != 0) {
+  void prefetch_cells(const std::vector<CellInfo *> &infos) {
+    if (!cache_options_.batch_loads || infos.size() < 2) {
       return;
     }
-
-    for_each(info, [this](auto &child_info) { dfs_old_cells(child_info); });
+    std::vector<CellInfo *> to_load;
+    std::vector<Cell::Hash> hashes;
+    for (auto info_ptr : infos) {
+      if (is_loaded(*info_ptr)) {
+        continue;
+      }
+      to_load.push_back(info_ptr);
+      hashes.push_back(info_ptr->cell->get_hash());
+    }
+    if (to_load.size() < 2) {
+      return;
+    }
+    std::vector<td::Slice> hash_slices;
+    for (auto &hash : hashes) {
+      hash_slices.push_back(hash.as_slice());
+    }
+    CHECK(loader_);
+    auto r_res = loader_->load_multi(hash_slices, true, *this);
+    if (r_res.is_error()) {
+      // cells will be loaded one by one later
+      LOG(ERROR) << "Failed to load cells from db" << r_res.error();
+      return;
+    }
+    auto res = r_res.move_as_ok();
+    for (size_t i = 0; i < to_load.size(); i++) {
+      auto &info = *to_load[i];
+      // the same cell may occur several times in one level
+      if (info.sync_with_db) {
+        continue;
+      }
+      cache_stats_.cache_misses++;
+      apply_load_result(info, hash_slices[i], std::move(res[i]));
+      touch(info);
+    }
   }
 
   void save_diff_prepare() {
     stats_diff_ = {};
+    stats_diff_.cache_hits = cache_stats_.cache_hits;
+    stats_diff_.cache_misses = cache_stats_.cache_misses;
+    stats_diff_.cache_evictions = cache_stats_.cache_evictions;
+    cache_stats_ = {};
     for (auto info_ptr : visited_) {
       save_cell_prepare(*info_ptr);
     }
@@ -399,6 +572,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       //CellSlice(NoVm(), info.cell).print_rec(std::cout);
       storer.erase(info.cell->get_hash().as_slice());
       info.in_db = false;
+      cache_bytes_ -= info.cache_bytes;
       hash_table_.erase(info.cell->get_hash().as_slice());
       guard.dismiss();
     } else {
@@ -463,26 +637,29 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   }
   void update_cell_info_force(CellInfo &info, td::Slice hash) {
     if (info.sync_with_db) {
+      cache_stats_.cache_hits++;
       return;
     }
+    cache_stats_.cache_misses++;
 
-    do {
-      CHECK(loader_);
-      auto r_res = loader_->load(hash, true, *this);
-      if (r_res.is_error()) {
-        //FIXME
-        LOG(ERROR) << "Failed to load cell from db" << r_res.error();
-        break;
-      }
-      auto res = r_res.move_as_ok();
-      if (res.status != CellLoader::LoadResult::Ok) {
-        break;
-      }
+    CHECK(loader_);
+    auto r_res = loader_->load(hash, true, *this);
+    if (r_res.is_error()) {
+      //FIXME
+      LOG(ERROR) << "Failed to load cell from db" << r_res.error();
+      info.sync_with_db = true;
+      return;
+    }
+    apply_load_result(info, hash, r_res.move_as_ok());
+  }
+
+  void apply_load_result(CellInfo &info, td::Slice hash, CellLoader::LoadResult res) {
+    if (res.status == CellLoader::LoadResult::Ok) {
       info.cell = std::move(res.cell());
       CHECK(info.cell->get_hash().as_slice() == hash);
       info.in_db = true;
       info.db_refcnt = res.refcnt();
-    } while (false);
+    }
     info.sync_with_db = true;
   }
 
@@ -495,6 +672,10 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
 }  // namespace
 
 std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create() {
-  return std::make_unique<DynamicBagOfCellsDbImpl>();
+  return create(CacheOptions{});
+}
+
+std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create(CacheOptions cache_options) {
+  return std::make_unique<DynamicBagOfCellsDbImpl>(cache_options);
 }
 }  // namespace vm
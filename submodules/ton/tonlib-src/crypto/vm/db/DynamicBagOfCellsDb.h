@@ -41,11 +41,26 @@ class DynamicBagOfCellsDb {
   struct Stats {
     td::int64 cells_total_count{0};
     td::int64 cells_total_size{0};
+    // cell cache activity since the previous prepare_commit
+    td::int64 cache_hits{0};
+    td::int64 cache_misses{0};
+    td::int64 cache_evictions{0};
     void apply_diff(Stats diff) {
       cells_total_count += diff.cells_total_count;
       cells_total_size += diff.cells_total_size;
+      cache_hits += diff.cache_hits;
+      cache_misses += diff.cache_misses;
+      cache_evictions += diff.cache_evictions;
     }
   };
+  struct CacheOptions {
+    // approximate memory budget for cached cells, 0 means unlimited
+    // cells referenced by a pending inc/dec diff are never evicted, so the budget may be exceeded
+    td::uint64 max_bytes{0};
+    // fetch not yet loaded cells of one dfs level with a single KeyValueReader::get_multi,
+    // and the unresolved refs of a cell loaded on the read path together
+    bool batch_loads{true};
+  };
   virtual void inc(const Ref<Cell> &old_root) = 0;
   virtual void dec(const Ref<Cell> &old_root) = 0;
 
@@ -57,6 +72,7 @@ class DynamicBagOfCellsDb {
   virtual td::Status set_loader(std::unique_ptr<CellLoader> loader) = 0;
 
   static std::unique_ptr<DynamicBagOfCellsDb> create();
+  static std::unique_ptr<DynamicBagOfCellsDb> create(CacheOptions cache_options);
 };
 
 }  // namespace vm
@@ -23,7 +23,9 @@
 
 #include "vm/cells/ExtCell.h"
 
+#include "td/utils/as.h"
 #include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
 #include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/RwMutex.h"
@@ -250,6 +252,7 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
   std::string index_data_;
   std::atomic<int> index_i_{0};
   size_t index_offset_{0};
+  std::unique_ptr<BlobView> index_file_;
   DataCellCacheMutex cells_;
   //DataCellCacheNoop cells_;
   //DataCellCacheTdlib cells_;
@@ -316,6 +319,10 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       TRY_RESULT(new_offset_view, data_->view(td::MutableSlice(arr, info_.offset_byte_size),
                                               info_.index_offset + idx * info_.offset_byte_size));
       offset_view = new_offset_view;
+    } else if (index_file_) {
+      TRY_RESULT(new_offset_view, index_file_->view(td::MutableSlice(arr, info_.offset_byte_size),
+                                                    index_file_header_size + idx * info_.offset_byte_size));
+      offset_view = new_offset_view;
     } else {
       guard = index_data_rw_mutex_.lock_read().move_as_ok();
       offset_view = td::Slice(index_data_).substr(idx * info_.offset_byte_size, info_.offset_byte_size);
@@ -364,6 +371,16 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     return res;
   }
 
+  // Memory mapped and in-memory blobs are viewed in place, without an intermediate copy
+  td::Result<td::Slice> view_cell(const CellLocation& cell_location, Ptr& buf) {
+    auto size = cell_location.end - cell_location.begin;
+    if (data_->supports_view_in_place()) {
+      return data_->view_in_place(size, cell_location.begin);
+    }
+    buf = alloc(size);
+    return data_->view(buf.as_slice(), cell_location.begin);
+  }
+
   td::Status load_header() {
     if (has_info_) {
       return td::Status::OK();
@@ -389,11 +406,73 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       }
     }
     has_info_ = true;
+    if (!info_.has_index && !options_.index_path.empty()) {
+      TRY_STATUS(load_index_file());
+    }
+    return td::Status::OK();
+  }
+
+  // Index file layout: magic, offset_byte_size, cell_count and a zero as 32-bit integers, SHA256 of the blob id,
+  // followed by cell end offsets in the same format as the built-in index
+  static constexpr td::uint32 index_file_magic = 0x33646962;
+  static constexpr std::size_t index_file_header_size = 48;
+
+  // The blob id is either given by the caller, or it is the stored CRC32C of the whole bag together with its size,
+  // so that opening never reads more than the header and the last bytes of the blob
+  td::Result<std::string> get_blob_hash() {
+    if (!options_.blob_hash.empty()) {
+      return td::sha256(options_.blob_hash);
+    }
+    if (!info_.has_crc32c) {
+      return td::Status::Error("bag-of-cells index file requires either blob_hash or a bag of cells with CRC32C");
+    }
+    char crc[4];
+    TRY_RESULT(crc_view, data_->view(td::MutableSlice(crc, 4), info_.total_size - 4));
+    std::string id = PSTRING() << "crc32c " << info_.total_size << " " << td::as<td::uint32>(crc_view.ubegin());
+    return td::sha256(id);
+  }
+
+  td::Status load_index_file() {
+    TRY_RESULT(blob_hash, get_blob_hash());
+    auto index_size = static_cast<td::uint64>(info_.cell_count) * info_.offset_byte_size;
+    auto r_index_file = FileMemoryMappingBlobView::create(options_.index_path);
+    if (r_index_file.is_ok() && r_index_file.ok()->size() == index_file_header_size + index_size) {
+      auto index_file = r_index_file.move_as_ok();
+      char header[index_file_header_size];
+      TRY_RESULT(header_view, index_file->view(td::MutableSlice(header, index_file_header_size), 0));
+      if (td::as<td::uint32>(header_view.ubegin()) == index_file_magic &&
+          td::as<td::uint32>(header_view.ubegin() + 4) == static_cast<td::uint32>(info_.offset_byte_size) &&
+          td::as<td::uint32>(header_view.ubegin() + 8) == static_cast<td::uint32>(info_.cell_count) &&
+          header_view.substr(16, 32) == blob_hash) {
+        index_file_ = std::move(index_file);
+        return td::Status::OK();
+      }
+    }
+
+    // No valid index yet, so build it once and save for the next time
+    if (info_.cell_count > 0) {
+      TRY_STATUS(preload_index(info_.cell_count - 1));
+    }
+    std::string index_file_data(index_file_header_size, '\0');
+    auto header_ptr = &index_file_data[0];
+    td::as<td::uint32>(header_ptr) = index_file_magic;
+    td::as<td::uint32>(header_ptr + 4) = static_cast<td::uint32>(info_.offset_byte_size);
+    td::as<td::uint32>(header_ptr + 8) = static_cast<td::uint32>(info_.cell_count);
+    td::as<td::uint32>(header_ptr + 12) = 0;
+    td::MutableSlice(header_ptr + 16, 32).copy_from(blob_hash);
+    {
+      auto guard = index_data_rw_mutex_.lock_read().move_as_ok();
+      index_file_data += index_data_;
+    }
+    auto status = td::atomic_write_file(options_.index_path, index_file_data);
+    if (status.is_error()) {
+      LOG(WARNING) << "Failed to save bag-of-cells index to " << options_.index_path << ": " << status;
+    }
     return td::Status::OK();
   }
 
   td::Status preload_index(int idx) {
-    if (info_.has_index) {
+    if (info_.has_index || index_file_) {
       return td::Status::OK();
     }
 
@@ -454,8 +533,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     }
 
     TRY_RESULT(cell_location, get_cell_location(idx));
-    auto buf = alloc(cell_location.end - cell_location.begin);
-    TRY_RESULT(cell_slice, data_->view(buf.as_slice(), cell_location.begin));
+    Ptr buf;
+    TRY_RESULT(cell_slice, view_cell(cell_location, buf));
     TRY_RESULT(res, deserialize_any_cell(idx, cell_slice, cell_location.should_cache));
     return std::move(res);
   }
@@ -469,8 +548,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
     }
 
     TRY_RESULT(cell_location, get_cell_location(idx));
-    auto buf = alloc(cell_location.end - cell_location.begin);
-    TRY_RESULT(cell_slice, data_->view(buf.as_slice(), cell_location.begin));
+    Ptr buf;
+    TRY_RESULT(cell_slice, view_cell(cell_location, buf));
     TRY_RESULT(res, deserialize_data_cell(idx, cell_slice, cell_location.should_cache));
     return std::move(res);
   }
@@ -51,6 +51,13 @@ class StaticBagOfCellsDbLazy {
     Options() {
     }
     bool check_crc32c{false};
+    // Path to a file with cell offsets, used only for bags of cells without a built-in index.
+    // It is built and saved on first open, later opens just map it, so several processes may share it.
+    std::string index_path;
+    // Any string identifying the contents of the blob, e.g. its file hash, to validate the index file with.
+    // If empty, the CRC32C stored at the end of the bag is used instead, and bags of cells without one can't have
+    // an index file. Either way opening does not read the whole blob.
+    std::string blob_hash;
   };
   static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create(std::unique_ptr<BlobView> data, Options options = {});
   static td::Result<std::shared_ptr<StaticBagOfCellsDb>> create(td::BufferSlice data, Options options = {});
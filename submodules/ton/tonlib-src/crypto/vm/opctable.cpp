@@ -31,6 +31,8 @@
 
 namespace vm {
 
+static_assert(max_opcode_bits == 24, "flat dispatch table assumes three 8-bit levels");
+
 DispatchTable* OpcodeTable::finalize() {
   if (final) {
     return this;
@@ -57,10 +59,32 @@ DispatchTable* OpcodeTable::finalize() {
   }
 
   instruction_list.shrink_to_fit();
+
+  flat_table.clear();
+  build_flat_level(0, 0);
+  flat_table.shrink_to_fit();
   final = true;
   return this;
 }
 
+// builds the flat dispatch level for opcodes [opcode_min, opcode_min + 2^(24 - 8 * level)), returns its index
+unsigned OpcodeTable::build_flat_level(unsigned opcode_min, unsigned level) {
+  unsigned idx = (unsigned)flat_table.size();
+  flat_table.emplace_back();
+  unsigned shift = max_opcode_bits - (level + 1) * flat_level_bits;
+  for (unsigned i = 0; i < (1U << flat_level_bits); i++) {
+    unsigned lo = opcode_min + (i << shift), hi = lo + (1U << shift);
+    const OpcodeInstr* instr = lookup_instr_list(lo);
+    if (instr->get_opcode_max() >= hi || level + 1 == flat_levels) {
+      flat_table[idx][i].instr = instr;
+    } else {
+      unsigned next = build_flat_level(lo, level + 1);
+      flat_table[idx][i].next = next;
+    }
+  }
+  return idx;
+}
+
 OpcodeTable& OpcodeTable::insert(const OpcodeInstr* instr) {
   LOG_IF(FATAL, !insert_bool(instr)) << td::format::lambda([&](auto& sb) {
     sb << "cannot insert instruction into table " << name << ": ";
@@ -100,7 +124,18 @@ bool OpcodeTable::insert_bool(const OpcodeInstr* instr) {
   return true;
 }
 
-const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) const {
+const OpcodeInstr* OpcodeTable::lookup_instr_flat(unsigned opcode) const {
+  const FlatEntry* entry = &flat_table[0][opcode >> (max_opcode_bits - flat_level_bits)];
+  if (!entry->instr) {
+    entry = &flat_table[entry->next][(opcode >> (max_opcode_bits - 2 * flat_level_bits)) & 0xff];
+    if (!entry->instr) {
+      entry = &flat_table[entry->next][opcode & 0xff];
+    }
+  }
+  return entry->instr;
+}
+
+const OpcodeInstr* OpcodeTable::lookup_instr_list(unsigned opcode) const {
   std::size_t i = 0, j = instruction_list.size();
   assert(j);
   while (j - i > 1) {
@@ -357,7 +392,7 @@ using namespace std::placeholders;
 
 dump_arg_instr_func_t dump_1sr(std::string prefix, std::string suffix) {
   return [prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << (args & 15) << suffix;
     return os.str();
   };
@@ -365,7 +400,7 @@ dump_arg_instr_func_t dump_1sr(std::string prefix, std::string suffix) {
 
 dump_arg_instr_func_t dump_1sr_l(std::string prefix, std::string suffix) {
   return [prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << (args & 255) << suffix;
     return os.str();
   };
@@ -373,7 +408,7 @@ dump_arg_instr_func_t dump_1sr_l(std::string prefix, std::string suffix) {
 
 dump_arg_instr_func_t dump_2sr(std::string prefix, std::string suffix) {
   return [prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << ((args >> 4) & 15) << ",s" << (args & 15) << suffix;
     return os.str();
   };
@@ -381,7 +416,7 @@ dump_arg_instr_func_t dump_2sr(std::string prefix, std::string suffix) {
 
 dump_arg_instr_func_t dump_2sr_adj(unsigned adj, std::string prefix, std::string suffix) {
   return [adj, prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << (int)((args >> 4) & 15) - (int)((adj >> 4) & 15) << ",s" << (int)(args & 15) - (int)(adj & 15)
        << suffix;
     return os.str();
@@ -390,7 +425,7 @@ dump_arg_instr_func_t dump_2sr_adj(unsigned adj, std::string prefix, std::string
 
 dump_arg_instr_func_t dump_3sr(std::string prefix, std::string suffix) {
   return [prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << ((args >> 8) & 15) << ",s" << ((args >> 4) & 15) << ",s" << (args & 15) << suffix;
     return os.str();
   };
@@ -398,7 +433,7 @@ dump_arg_instr_func_t dump_3sr(std::string prefix, std::string suffix) {
 
 dump_arg_instr_func_t dump_3sr_adj(unsigned adj, std::string prefix, std::string suffix) {
   return [adj, prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << 's' << (int)((args >> 8) & 15) - (int)((adj >> 8) & 15) << ",s"
        << (int)((args >> 4) & 15) - (int)((adj >> 4) & 15) << ",s" << (int)(args & 15) - (int)(adj & 15) << suffix;
     return os.str();
@@ -407,7 +442,7 @@ dump_arg_instr_func_t dump_3sr_adj(unsigned adj, std::string prefix, std::string
 
 dump_arg_instr_func_t dump_1c(std::string prefix, std::string suffix) {
   return [prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << (args & 15) << suffix;
     return os.str();
   };
@@ -415,7 +450,7 @@ dump_arg_instr_func_t dump_1c(std::string prefix, std::string suffix) {
 
 dump_arg_instr_func_t dump_1c_l_add(int adj, std::string prefix, std::string suffix) {
   return [adj, prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << (int)(args & 255) + adj << suffix;
     return os.str();
   };
@@ -423,7 +458,7 @@ dump_arg_instr_func_t dump_1c_l_add(int adj, std::string prefix, std::string suf
 
 dump_arg_instr_func_t dump_1c_and(unsigned mask, std::string prefix, std::string suffix) {
   return [mask, prefix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << (args & mask) << suffix;
     return os.str();
   };
@@ -431,7 +466,7 @@ dump_arg_instr_func_t dump_1c_and(unsigned mask, std::string prefix, std::string
 
 dump_arg_instr_func_t dump_2c(std::string prefix, std::string interfix, std::string suffix) {
   return [prefix, interfix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << ((args >> 4) & 15) << interfix << (args & 15) << suffix;
     return os.str();
   };
@@ -439,7 +474,7 @@ dump_arg_instr_func_t dump_2c(std::string prefix, std::string interfix, std::str
 
 dump_arg_instr_func_t dump_2c_add(unsigned add, std::string prefix, std::string interfix, std::string suffix) {
   return [add, prefix, interfix, suffix](CellSlice&, unsigned args) -> std::string {
-    std::ostringstream os{prefix};
+    std::ostringstream os{prefix, std::ios_base::ate};
     os << ((args >> 4) & 15) + ((add >> 4) & 15) << interfix << (args & 15) + (add & 15) << suffix;
     return os.str();
   };
@@ -18,6 +18,7 @@
 */
 #pragma once
 #include "vm/dispatch.h"
+#include <array>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -86,8 +87,16 @@ dump_arg_instr_func_t dump_2c_add(unsigned add, std::string prefix, std::string
 }  // namespace instr
 
 class OpcodeTable : public DispatchTable {
+  // one entry of a flat dispatch level: either the instruction covering the whole subrange, or the next level
+  struct FlatEntry {
+    const OpcodeInstr* instr{nullptr};
+    unsigned next{0};
+  };
+  enum { flat_level_bits = 8, flat_levels = max_opcode_bits / flat_level_bits };
+  using FlatLevel = std::array<FlatEntry, 1U << flat_level_bits>;
   std::map<unsigned, const OpcodeInstr*> instructions;
   std::vector<std::pair<unsigned, const OpcodeInstr*>> instruction_list;
+  std::vector<FlatLevel> flat_table;
   std::string name;
   Codepage codepage;
   bool final;
@@ -109,9 +118,15 @@ class OpcodeTable : public DispatchTable {
   int instr_len(const CellSlice& cs) const override;
   bool insert_bool(const OpcodeInstr*);
   OpcodeTable& insert(const OpcodeInstr*);
+  // both require a finalized table; lookup_instr_list() is the binary search used to build the flat table
+  const OpcodeInstr* lookup_instr_flat(unsigned opcode) const;
+  const OpcodeInstr* lookup_instr_list(unsigned opcode) const;
 
  private:
-  const OpcodeInstr* lookup_instr(unsigned opcode, unsigned bits) const;
+  unsigned build_flat_level(unsigned opcode_min, unsigned level);
+  const OpcodeInstr* lookup_instr(unsigned opcode, unsigned bits) const {
+    return lookup_instr_flat(opcode);
+  }
   const OpcodeInstr* lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const;
 };
 
@@ -0,0 +1,105 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#include "vm/profiler.h"
+
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace vm {
+
+void VmProfiler::clear() {
+  instr_stats.clear();
+  cell_stats.clear();
+  folded_gas.clear();
+  total = {};
+  cur_step = {};
+}
+
+void VmProfiler::start_step(const CellHash& code_cell, std::string instr, long long gas_consumed) {
+  auto& folded = folded_gas[std::make_pair(code_cell, instr)];
+  cur_step.instr = &instr_stats[std::move(instr)];
+  cur_step.cell = &cell_stats[code_cell];
+  cur_step.folded = &folded;
+  cur_step.gas_consumed = gas_consumed;
+  cur_step.cell_loads = total.cell_loads;
+  cur_step.cell_creates = total.cell_creates;
+  cur_step.started_at = td::Time::now();
+}
+
+void VmProfiler::finish_step(long long gas_consumed) {
+  if (!cur_step.instr) {
+    return;
+  }
+  auto time = td::Time::now() - cur_step.started_at;
+  auto gas = gas_consumed - cur_step.gas_consumed;
+  auto& instr = *cur_step.instr;
+  instr.count++;
+  instr.gas += gas;
+  instr.cell_loads += total.cell_loads - cur_step.cell_loads;
+  instr.cell_creates += total.cell_creates - cur_step.cell_creates;
+  instr.time += time;
+  cur_step.cell->steps++;
+  cur_step.cell->gas += gas;
+  *cur_step.folded += gas;
+  total.count++;
+  total.gas += gas;
+  total.time += time;
+  cur_step = {};
+}
+
+std::string VmProfiler::to_string(size_t max_entries) const {
+  std::ostringstream os;
+  os << "steps: " << total.count << ", gas: " << total.gas << ", cell loads: " << total.cell_loads
+     << ", cell creates: " << total.cell_creates << ", time: " << total.time * 1e6 << "us\n";
+
+  std::vector<std::pair<std::string, InstrStats>> instrs(instr_stats.begin(), instr_stats.end());
+  std::sort(instrs.begin(), instrs.end(), [](auto& a, auto& b) { return a.second.gas > b.second.gas; });
+  os << "instructions by gas:\n";
+  for (size_t i = 0; i < instrs.size() && i < max_entries; i++) {
+    auto& stats = instrs[i].second;
+    os << "  " << std::left << std::setw(16) << instrs[i].first << std::right << " count=" << stats.count
+       << " gas=" << stats.gas << " loads=" << stats.cell_loads << " creates=" << stats.cell_creates
+       << " time=" << stats.time * 1e6 << "us\n";
+  }
+
+  std::vector<std::pair<CellHash, CellStats>> cells(cell_stats.begin(), cell_stats.end());
+  std::sort(cells.begin(), cells.end(), [](auto& a, auto& b) { return a.second.gas > b.second.gas; });
+  os << "code cells by gas:\n";
+  for (size_t i = 0; i < cells.size() && i < max_entries; i++) {
+    os << "  " << cells[i].first.to_hex() << " steps=" << cells[i].second.steps << " gas=" << cells[i].second.gas
+       << "\n";
+  }
+  return os.str();
+}
+
+std::string VmProfiler::to_folded_stacks() const {
+  std::ostringstream os;
+  for (auto& it : folded_gas) {
+    if (it.second > 0) {
+      os << it.first.first.to_hex() << ";" << it.first.second << " " << it.second << "\n";
+    }
+  }
+  return os.str();
+}
+
+}  // namespace vm
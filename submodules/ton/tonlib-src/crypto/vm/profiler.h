@@ -0,0 +1,107 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+
+#include "vm/cells/CellHash.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace vm {
+
+class VmState;
+
+// Collects statistics of the VmState runs it is attached to with VmState::set_profiler().
+// Everything consumed between the starts of two consecutive steps, including the handling of the exceptions
+// thrown by the first one, is attributed to the instruction executed by that step and to its code cell.
+class VmProfiler {
+ public:
+  struct InstrStats {
+    long long count{0};
+    long long gas{0};
+    long long cell_loads{0};
+    long long cell_creates{0};
+    double time{0};
+  };
+  struct CellStats {
+    long long steps{0};
+    long long gas{0};
+  };
+
+  // keyed by instruction mnemonic, e.g. "PUSHINT"
+  const std::map<std::string, InstrStats>& get_instr_stats() const {
+    return instr_stats;
+  }
+  // keyed by the representation hash of the code cell containing the instruction
+  const std::map<CellHash, CellStats>& get_cell_stats() const {
+    return cell_stats;
+  }
+  long long get_steps() const {
+    return total.count;
+  }
+  long long get_gas() const {
+    return total.gas;
+  }
+  long long get_cell_loads() const {
+    return total.cell_loads;
+  }
+  long long get_cell_creates() const {
+    return total.cell_creates;
+  }
+  double get_time() const {
+    return total.time;
+  }
+  void clear();
+
+  // summary of the hottest instructions and code cells by gas, at most max_entries of each
+  std::string to_string(size_t max_entries = 20) const;
+  // gas weighted "code_cell_hash;MNEMONIC gas" lines, the collapsed stack format read by flamegraph.pl
+  std::string to_folded_stacks() const;
+
+ private:
+  friend class VmState;
+
+  struct Step {
+    InstrStats* instr{nullptr};
+    CellStats* cell{nullptr};
+    long long* folded{nullptr};
+    long long gas_consumed{0};
+    long long cell_loads{0};
+    long long cell_creates{0};
+    double started_at{0};
+  };
+
+  std::map<std::string, InstrStats> instr_stats;
+  std::map<CellHash, CellStats> cell_stats;
+  std::map<std::pair<CellHash, std::string>, long long> folded_gas;
+  InstrStats total;
+  Step cur_step;
+
+  void start_step(const CellHash& code_cell, std::string instr, long long gas_consumed);
+  void finish_step(long long gas_consumed);
+  void register_cell_load() {
+    total.cell_loads++;
+  }
+  void register_cell_create() {
+    total.cell_creates++;
+  }
+};
+
+}  // namespace vm
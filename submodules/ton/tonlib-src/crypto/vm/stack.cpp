@@ -181,6 +181,20 @@ void StackEntry::print_list_tail(std::ostream& os) const {
   }
 }
 
+static_assert(sizeof(void*) != 8 || sizeof(StackEntry) == 16, "inline integers must not make StackEntry larger");
+
+StackEntry StackEntry::small_int(long long x) {
+  if (!fits_small_int(x)) {
+    return td::make_refint(x);
+  }
+  StackEntry res;
+  res.ref.~RefAny();
+  res.small = x;
+  res.tp = t_int;
+  res.inline_int = true;
+  return res;
+}
+
 StackEntry::StackEntry(Ref<Stack> stack_ref) : ref(std::move(stack_ref)), tp(t_stack) {
 }
 
@@ -339,6 +353,15 @@ void Stack::pop_null() {
   }
 }
 
+bool Stack::pop_small_int(long long& x) {
+  check_underflow(1);
+  if (!tos().get_small_int(x)) {
+    return false;
+  }
+  stack.pop_back();
+  return true;
+}
+
 td::RefInt256 Stack::pop_int() {
   check_underflow(1);
   td::RefInt256 res = pop().as_int();
@@ -357,10 +380,18 @@ td::RefInt256 Stack::pop_int_finite() {
 }
 
 bool Stack::pop_bool() {
+  long long x;
+  if (pop_small_int(x)) {
+    return x != 0;
+  }
   return sgn(pop_int_finite()) != 0;
 }
 
 long long Stack::pop_long() {
+  long long x;
+  if (pop_small_int(x)) {
+    return x;
+  }
   return pop_int()->to_long();
 }
 
@@ -557,7 +588,7 @@ void Stack::push_builder(Ref<CellBuilder> cb) {
 }
 
 void Stack::push_smallint(long long val) {
-  push(td::RefInt256{true, val});
+  push(StackEntry::small_int(val));
 }
 
 void Stack::push_bool(bool val) {
@@ -25,6 +25,7 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <new>
 #include "common/refcnt.hpp"
 #include "common/bigint.hpp"
 #include "common/refint.h"
@@ -62,6 +63,9 @@ constexpr from_object_t from_object{};
 
 class StackEntry {
  public:
+  // integers fitting into small_int_bits signed bits are kept inline (in small, in place of ref);
+  // they are converted into a td::RefInt256 only when requested through as_int()
+  enum { small_int_bits = 63 };
   enum Type {
     t_null,
     t_int,
@@ -80,13 +84,21 @@ class StackEntry {
   };
 
  private:
-  RefAny ref;
+  // an inline integer (tp == t_int && inline_int) occupies the slot of ref, so that StackEntry keeps its size
+  union {
+    RefAny ref;
+    long long small;
+  };
   Type tp;
+  bool inline_int{false};
 
  public:
   StackEntry() : ref(), tp(t_null) {
   }
   ~StackEntry() {
+    if (!inline_int) {
+      ref.~RefAny();
+    }
   }
   StackEntry(Ref<Cell> cell_ref) : ref(std::move(cell_ref)), tp(t_cell) {
   }
@@ -94,7 +106,7 @@ class StackEntry {
   }
   StackEntry(Ref<CellSlice> cs_ref) : ref(std::move(cs_ref)), tp(t_slice) {
   }
-  StackEntry(td::RefInt256 int_ref) : ref(std::move(int_ref)), tp(t_int) {
+  StackEntry(td::RefInt256 int_ref) : ref(std::move(int_ref)), tp(ref.is_null() ? t_null : t_int) {
   }
   StackEntry(std::string str, bool bytes = false) : ref(), tp(bytes ? t_bytes : t_string) {
     ref = Ref<Cnt<std::string>>{true, std::move(str)};
@@ -106,27 +118,46 @@ class StackEntry {
   StackEntry(const std::vector<StackEntry>& tuple_components);
   StackEntry(std::vector<StackEntry>&& tuple_components);
   StackEntry(Ref<Atom> atom_ref);
-  StackEntry(const StackEntry& se) : ref(se.ref), tp(se.tp) {
+  StackEntry(const StackEntry& se) : tp(se.tp), inline_int(se.inline_int) {
+    if (inline_int) {
+      small = se.small;
+    } else {
+      new (&ref) RefAny(se.ref);
+    }
   }
-  StackEntry(StackEntry&& se) noexcept : ref(std::move(se.ref)), tp(se.tp) {
+  StackEntry(StackEntry&& se) noexcept : tp(se.tp), inline_int(se.inline_int) {
+    if (inline_int) {
+      small = se.small;
+      new (&se.ref) RefAny();
+      se.inline_int = false;
+    } else {
+      new (&ref) RefAny(std::move(se.ref));
+    }
     se.tp = t_null;
   }
   template <class T>
   StackEntry(from_object_t, Ref<T> obj_ref) : ref(std::move(obj_ref)), tp(t_object) {
   }
   StackEntry& operator=(const StackEntry& se) {
-    ref = se.ref;
-    tp = se.tp;
+    StackEntry(se).swap(*this);
     return *this;
   }
   StackEntry& operator=(StackEntry&& se) {
-    ref = std::move(se.ref);
-    tp = se.tp;
-    se.tp = t_null;
+    StackEntry(std::move(se)).swap(*this);
     return *this;
   }
+  static bool fits_small_int(long long x) {
+    return x >= -(1LL << (small_int_bits - 1)) && x < (1LL << (small_int_bits - 1));
+  }
+  // creates an inline integer if x fits into small_int_bits, and a td::RefInt256 otherwise
+  static StackEntry small_int(long long x);
   StackEntry& clear() {
-    ref.clear();
+    if (inline_int) {
+      new (&ref) RefAny();
+      inline_int = false;
+    } else {
+      ref.clear();
+    }
     tp = t_null;
     return *this;
   }
@@ -142,15 +173,44 @@ class StackEntry {
   bool is(int wanted) const {
     return tp == wanted;
   }
+  bool is_small_int() const {
+    return inline_int;
+  }
+  // does not allocate; returns false unless the entry is an inline integer
+  bool get_small_int(long long& x) const {
+    if (!is_small_int()) {
+      return false;
+    }
+    x = small;
+    return true;
+  }
   void swap(StackEntry& se) {
-    ref.swap(se.ref);
+    if (inline_int == se.inline_int) {
+      if (inline_int) {
+        std::swap(small, se.small);
+      } else {
+        ref.swap(se.ref);
+      }
+    } else {
+      StackEntry& x = inline_int ? *this : se;
+      StackEntry& y = inline_int ? se : *this;
+      long long value = x.small;
+      new (&x.ref) RefAny(std::move(y.ref));
+      y.ref.~RefAny();
+      y.small = value;
+    }
     std::swap(tp, se.tp);
+    std::swap(inline_int, se.inline_int);
   }
+  // compares references by identity (as Fift eq? does), but inline integers by value
   bool operator==(const StackEntry& other) const {
+    if (inline_int || other.inline_int) {
+      return inline_int == other.inline_int && small == other.small;
+    }
     return tp == other.tp && ref == other.ref;
   }
   bool operator!=(const StackEntry& other) const {
-    return !(tp == other.tp && ref == other.ref);
+    return !(*this == other);
   }
   Type type() const {
     return tp;
@@ -192,10 +252,10 @@ class StackEntry {
     }
   }
   td::RefInt256 as_int() const& {
-    return as<td::CntInt256, t_int>();
+    return is_small_int() ? td::make_refint(small) : as<td::CntInt256, t_int>();
   }
   td::RefInt256 as_int() && {
-    return move_as<td::CntInt256, t_int>();
+    return is_small_int() ? td::make_refint(small) : move_as<td::CntInt256, t_int>();
   }
   Ref<Cell> as_cell() const& {
     return as<Cell, t_cell>();
@@ -434,6 +494,8 @@ class Stack : public td::CntObject {
     return *this;
   }
   void pop_null();
+  // pops the top entry only if it is an inline integer, see StackEntry::small_int()
+  bool pop_small_int(long long& x);
   td::RefInt256 pop_int();
   td::RefInt256 pop_int_finite();
   bool pop_bool();
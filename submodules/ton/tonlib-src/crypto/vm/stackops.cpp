@@ -75,7 +75,7 @@ std::string dump_xchg(CellSlice&, unsigned args) {
   if (!x || x >= y) {
     return "";
   }
-  std::ostringstream os{"XCHG s"};
+  std::ostringstream os{"XCHG s", std::ios_base::ate};
   os << x << ",s" << y;
   return os.str();
 }
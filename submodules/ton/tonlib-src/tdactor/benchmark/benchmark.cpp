@@ -43,6 +43,7 @@ extern "C" {
 #endif
 
 #include "td/actor/core/ActorLocker.h"
+#include "td/actor/core/ActorMessageAllocator.h"
 #include "td/actor/actor.h"
 
 #include "td/utils/benchmark.h"
@@ -437,6 +438,21 @@ class ActorSignalQuery : public td::Benchmark {
   }
 };
 
+class MessageArenaGuard {
+ public:
+  explicit MessageArenaGuard(bool use_arena) : old_use_arena_(td::actor::core::ActorMessageAllocator::get_use_arena()) {
+    td::actor::core::ActorMessageAllocator::set_use_arena(use_arena);
+  }
+  MessageArenaGuard(const MessageArenaGuard &) = delete;
+  MessageArenaGuard &operator=(const MessageArenaGuard &) = delete;
+  ~MessageArenaGuard() {
+    td::actor::core::ActorMessageAllocator::set_use_arena(old_use_arena_);
+  }
+
+ private:
+  bool old_use_arena_;
+};
+
 namespace actor_query_test {
 using namespace td::actor;
 class Master;
@@ -501,14 +517,18 @@ class Worker : public td::actor::Actor {
  public:
   Worker(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
   }
-  void query(int x, int *y) {
-    *y = x + x;
+  void query(int x) {
+    sum_ += x + x;
+  }
+  void check(td::int64 expected) {
+    CHECK(sum_ == expected);
   }
   void start_up() override {
   }
 
  private:
   std::shared_ptr<td::Destructor> watcher_;
+  td::int64 sum_{0};
 };
 class Master : public td::actor::Actor {
  public:
@@ -517,11 +537,11 @@ class Master : public td::actor::Actor {
 
   void start_up() override {
     worker_ = create_actor<Worker>(ActorOptions().with_name("Worker"), watcher_);
-    int res;
+    // the worker hasn't started yet, so the queries are queued rather than executed in place
     for (int i = 0; i < n_; i++) {
-      send_closure(worker_, &Worker::query, i, &res);
-      CHECK(res == i + i);
+      send_closure(worker_, &Worker::query, i);
     }
+    send_closure(worker_, &Worker::check, static_cast<td::int64>(n_) * (n_ - 1));
     stop();
   }
 
@@ -533,11 +553,14 @@ class Master : public td::actor::Actor {
 }  // namespace actor_dummy_query_test
 class ActorDummyQuery : public td::Benchmark {
  public:
+  explicit ActorDummyQuery(bool use_arena = true) : use_arena_(use_arena) {
+  }
   std::string get_description() const override {
-    return "ActorDummyQuery";
+    return PSTRING() << "ActorDummyQuery use_arena(" << use_arena_ << ")";
   }
   void run(int n) override {
     using namespace actor_dummy_query_test;
+    MessageArenaGuard arena_guard(use_arena_);
     size_t threads_count = 1;
     Scheduler scheduler({threads_count});
 
@@ -549,6 +572,9 @@ class ActorDummyQuery : public td::Benchmark {
 
     scheduler.run();
   }
+
+ private:
+  bool use_arena_{true};
 };
 
 namespace actor_task_query_test {
@@ -1172,13 +1198,14 @@ struct Sem {
 
 class ChainedSpawn : public td::Benchmark {
  public:
-  ChainedSpawn(bool use_io) : use_io_(use_io) {
+  ChainedSpawn(bool use_io, bool use_arena = true) : use_io_(use_io), use_arena_(use_arena) {
   }
   std::string get_description() const {
-    return PSTRING() << "Chained create_actor use_io(" << use_io_ << ")";
+    return PSTRING() << "Chained create_actor use_io(" << use_io_ << ") use_arena(" << use_arena_ << ")";
   }
 
   void run(int n) {
+    MessageArenaGuard arena_guard(use_arena_);
     class Task : public td::actor::Actor {
      public:
       Task(int n, Sem *sem) : n_(n), sem_(sem) {
@@ -1214,6 +1241,7 @@ class ChainedSpawn : public td::Benchmark {
 
  private:
   bool use_io_{false};
+  bool use_arena_{true};
 };
 
 class ChainedSpawnInplace : public td::Benchmark {
@@ -1265,10 +1293,10 @@ class ChainedSpawnInplace : public td::Benchmark {
 
 class PingPong : public td::Benchmark {
  public:
-  PingPong(bool use_io) : use_io_(use_io) {
+  PingPong(bool use_io, bool work_stealing = false) : use_io_(use_io), work_stealing_(work_stealing) {
   }
   std::string get_description() const {
-    return PSTRING() << "PingPong use_io(" << use_io_ << ")";
+    return PSTRING() << "PingPong use_io(" << use_io_ << ") work_stealing(" << work_stealing_ << ")";
   }
 
   void run(int n) {
@@ -1294,7 +1322,7 @@ class PingPong : public td::Benchmark {
       td::actor::ActorId<Task> peer_;
       Sem *sem_;
     };
-    td::actor::Scheduler scheduler{{8}};
+    td::actor::Scheduler scheduler{{8}, td::actor::Scheduler::Paused, cpu_queue_mode()};
     auto sch = td::thread([&] { scheduler.run(); });
 
     Sem sem;
@@ -1317,14 +1345,20 @@ class PingPong : public td::Benchmark {
 
  private:
   bool use_io_{false};
+  bool work_stealing_{false};
+
+  td::actor::Scheduler::CpuQueueMode cpu_queue_mode() const {
+    return work_stealing_ ? td::actor::Scheduler::CpuQueueMode::WorkStealing
+                          : td::actor::Scheduler::CpuQueueMode::Shared;
+  }
 };
 
 class SpawnMany : public td::Benchmark {
  public:
-  SpawnMany(bool use_io) : use_io_(use_io) {
+  SpawnMany(bool use_io, bool work_stealing = false) : use_io_(use_io), work_stealing_(work_stealing) {
   }
   std::string get_description() const {
-    return PSTRING() << "Spawn many use_io(" << use_io_ << ")";
+    return PSTRING() << "Spawn many use_io(" << use_io_ << ") work_stealing(" << work_stealing_ << ")";
   }
 
   void run(int n) {
@@ -1340,7 +1374,7 @@ class SpawnMany : public td::Benchmark {
      private:
       Sem *sem_;
     };
-    td::actor::Scheduler scheduler{{8}};
+    td::actor::Scheduler scheduler{{8}, td::actor::Scheduler::Paused, cpu_queue_mode()};
     Sem sem;
     auto sch = td::thread([&] { scheduler.run(); });
     scheduler.run_in_context_external([&] {
@@ -1358,14 +1392,20 @@ class SpawnMany : public td::Benchmark {
 
  private:
   bool use_io_{false};
+  bool work_stealing_{false};
+
+  td::actor::Scheduler::CpuQueueMode cpu_queue_mode() const {
+    return work_stealing_ ? td::actor::Scheduler::CpuQueueMode::WorkStealing
+                          : td::actor::Scheduler::CpuQueueMode::Shared;
+  }
 };
 
 class YieldMany : public td::Benchmark {
  public:
-  YieldMany(bool use_io) : use_io_(use_io) {
+  YieldMany(bool use_io, bool work_stealing = false) : use_io_(use_io), work_stealing_(work_stealing) {
   }
   std::string get_description() const {
-    return PSTRING() << "Yield many use_io(" << use_io_ << ")";
+    return PSTRING() << "Yield many use_io(" << use_io_ << ") work_stealing(" << work_stealing_ << ")";
   }
 
   void run(int n) {
@@ -1390,7 +1430,7 @@ class YieldMany : public td::Benchmark {
       int n_;
       Sem *sem_;
     };
-    td::actor::Scheduler scheduler{{cpu_n}};
+    td::actor::Scheduler scheduler{{cpu_n}, td::actor::Scheduler::Paused, cpu_queue_mode()};
     auto sch = td::thread([&] { scheduler.run(); });
     unsigned tasks = tasks_per_cpu * cpu_n;
     Sem sem;
@@ -1410,6 +1450,12 @@ class YieldMany : public td::Benchmark {
 
  private:
   bool use_io_{false};
+  bool work_stealing_{false};
+
+  td::actor::Scheduler::CpuQueueMode cpu_queue_mode() const {
+    return work_stealing_ ? td::actor::Scheduler::CpuQueueMode::WorkStealing
+                          : td::actor::Scheduler::CpuQueueMode::Shared;
+  }
 };
 
 int main(int argc, char **argv) {
@@ -1426,19 +1472,23 @@ int main(int argc, char **argv) {
     return 0;
   }
 
-  bench(YieldMany(false));
-  bench(YieldMany(true));
-  bench(SpawnMany(false));
-  bench(SpawnMany(true));
-  bench(PingPong(false));
-  bench(PingPong(true));
+  for (bool work_stealing : {false, true}) {
+    bench(YieldMany(false, work_stealing));
+    bench(YieldMany(true, work_stealing));
+    bench(SpawnMany(false, work_stealing));
+    bench(SpawnMany(true, work_stealing));
+    bench(PingPong(false, work_stealing));
+    bench(PingPong(true, work_stealing));
+  }
   bench(ChainedSpawnInplace(false));
   bench(ChainedSpawnInplace(true));
-  bench(ChainedSpawn(false));
-  bench(ChainedSpawn(true));
+  for (bool use_arena : {false, true}) {
+    bench(ChainedSpawn(false, use_arena));
+    bench(ChainedSpawn(true, use_arena));
+    bench(ActorDummyQuery(use_arena));
+  }
   return 0;
 
-  bench(ActorDummyQuery());
   bench(ActorExecutorBenchmark());
   bench(ActorSignalQuery());
   bench(ActorQuery());
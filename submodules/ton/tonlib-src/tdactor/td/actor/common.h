@@ -76,7 +76,9 @@ class Scheduler {
   };
 
   enum Mode { Running, Paused };
-  Scheduler(std::vector<NodeInfo> infos, Mode mode = Paused) : infos_(std::move(infos)) {
+  using CpuQueueMode = core::SchedulerGroupInfo::CpuQueueMode;
+  Scheduler(std::vector<NodeInfo> infos, Mode mode = Paused, CpuQueueMode cpu_queue_mode = CpuQueueMode::Shared)
+      : infos_(std::move(infos)), cpu_queue_mode_(cpu_queue_mode) {
     init();
     if (mode == Running) {
       start();
@@ -147,6 +149,7 @@ class Scheduler {
 
  private:
   std::vector<NodeInfo> infos_{td::thread::hardware_concurrency()};
+  CpuQueueMode cpu_queue_mode_{CpuQueueMode::Shared};
   std::shared_ptr<core::SchedulerGroupInfo> group_info_;
   std::vector<td::unique_ptr<core::Scheduler>> schedulers_;
   bool is_started_{false};
@@ -154,7 +157,7 @@ class Scheduler {
   void init() {
     CHECK(infos_.size() < 256);
     CHECK(!group_info_);
-    group_info_ = std::make_shared<core::SchedulerGroupInfo>(infos_.size());
+    group_info_ = std::make_shared<core::SchedulerGroupInfo>(infos_.size(), cpu_queue_mode_);
     td::uint8 id = 0;
     for (const auto &info : infos_) {
       schedulers_.emplace_back(td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_));
@@ -196,8 +199,6 @@ class ActorMessageCreator {
   static auto hangup_shared() {
     return core::ActorMessage(std::make_unique<core::ActorMessageHangupShared>());
   }
-
-  // Use faster allocation?
 };
 struct ActorRef {
   ActorRef(core::ActorInfo &actor_info, uint64 link_token = core::EmptyLinkToken)
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "td/actor/core/ActorExecuteContext.h"
+#include "td/actor/core/ActorMessageAllocator.h"
 
 #include "td/utils/MpscLinkQueue.h"
 
@@ -36,6 +37,14 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
   virtual ~ActorMessageImpl() = default;
   virtual void run() = 0;
 
+  // Messages and the closures stored in them are allocated from a per-thread arena
+  static void *operator new(size_t size) {
+    return ActorMessageAllocator::allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    ActorMessageAllocator::deallocate(ptr);
+  }
+
  private:
   friend class ActorMessage;
 
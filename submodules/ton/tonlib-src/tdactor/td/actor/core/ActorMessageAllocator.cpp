@@ -0,0 +1,262 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#include "td/actor/core/ActorMessageAllocator.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+namespace {
+class Arena;
+
+// 16 bytes, so the payload keeps malloc alignment
+struct BlockHeader {
+  Arena *arena;  // nullptr if the block was allocated with plain malloc
+  size_t size_class;
+};
+static_assert(sizeof(BlockHeader) == 16, "");
+
+// stored in the payload of a free block
+struct FreeBlock {
+  BlockHeader header;
+  FreeBlock *next;
+};
+
+constexpr size_t BLOCK_ALIGNMENT = 16;
+constexpr size_t SIZE_CLASS_COUNT = 32;
+constexpr size_t MAX_BLOCK_SIZE = BLOCK_ALIGNMENT * SIZE_CLASS_COUNT;
+constexpr size_t CHUNK_SIZE = 1 << 16;
+
+void *malloc_or_throw(size_t size) {
+  auto *ptr = std::malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+size_t get_size_class(size_t block_size) {
+  return (block_size - 1) / BLOCK_ALIGNMENT;
+}
+
+size_t get_block_size(size_t size_class) {
+  return (size_class + 1) * BLOCK_ALIGNMENT;
+}
+
+// Blocks are carved from big chunks and never returned to malloc one by one.
+// All chunks are freed together, when the owner thread has exited and the last block is freed.
+class Arena {
+ public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+  ~Arena() {
+    for (auto *chunk : chunks_) {
+      std::free(chunk);
+    }
+  }
+
+  void *allocate(size_t size_class) {
+    auto *block = free_[size_class];
+    if (unlikely(block == nullptr)) {
+      drain_remote();
+      block = free_[size_class];
+    }
+    outstanding_++;
+    if (block != nullptr) {
+      free_[size_class] = block->next;
+      return &block->header + 1;
+    }
+
+    auto block_size = get_block_size(size_class);
+    if (unlikely(chunk_end_ - chunk_pos_ < static_cast<std::ptrdiff_t>(block_size))) {
+      chunk_pos_ = static_cast<char *>(malloc_or_throw(CHUNK_SIZE));
+      chunk_end_ = chunk_pos_ + CHUNK_SIZE;
+      chunks_.push_back(chunk_pos_);
+    }
+    auto *header = reinterpret_cast<BlockHeader *>(chunk_pos_);
+    chunk_pos_ += block_size;
+    header->arena = this;
+    header->size_class = size_class;
+    return header + 1;
+  }
+
+  // Must be called by the owner thread
+  void deallocate_local(BlockHeader *header) {
+    outstanding_--;
+    push_free(reinterpret_cast<FreeBlock *>(header));
+  }
+
+  // May be called from any thread, even after the owner thread has exited
+  void deallocate_remote(BlockHeader *header) {
+    auto *block = reinterpret_cast<FreeBlock *>(header);
+    auto *old_head = remote_.load(std::memory_order_relaxed);
+    do {
+      if (old_head == closed_marker()) {
+        release_closed(1);
+        return;
+      }
+      block->next = old_head;
+    } while (!remote_.compare_exchange_weak(old_head, block, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  // Called by the owner thread on exit. The arena deletes itself after its last block is freed
+  void close() {
+    auto *block = remote_.exchange(closed_marker(), std::memory_order_acquire);
+    while (block != nullptr) {
+      outstanding_--;
+      block = block->next;
+    }
+    release_closed(-outstanding_);
+  }
+
+ private:
+  std::array<FreeBlock *, SIZE_CLASS_COUNT> free_{};
+  int64 outstanding_{0};
+  char *chunk_pos_{nullptr};
+  char *chunk_end_{nullptr};
+  std::vector<char *> chunks_;
+
+  std::atomic<FreeBlock *> remote_{nullptr};
+  // Reaches zero when the arena is closed and all its blocks are freed
+  std::atomic<int64> closed_remaining_{0};
+
+  static FreeBlock *closed_marker() {
+    return reinterpret_cast<FreeBlock *>(static_cast<uintptr_t>(1));
+  }
+
+  void push_free(FreeBlock *block) {
+    auto &head = free_[block->header.size_class];
+    block->next = head;
+    head = block;
+  }
+
+  void drain_remote() {
+    if (remote_.load(std::memory_order_relaxed) == nullptr) {
+      return;
+    }
+    auto *block = remote_.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+      auto *next = block->next;
+      outstanding_--;
+      push_free(block);
+      block = next;
+    }
+  }
+
+  // Either the owner thread adds the number of outstanding blocks, or a remote thread subtracts one freed block;
+  // whoever brings the counter to zero deletes the arena
+  void release_closed(int64 count) {
+    if (closed_remaining_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      delete this;
+    }
+  }
+};
+
+class ArenaHolder;
+TD_THREAD_LOCAL Arena *current_arena;
+TD_THREAD_LOCAL ArenaHolder *current_arena_holder;
+TD_THREAD_LOCAL bool is_arena_closed;
+
+class ArenaHolder {
+ public:
+  ArenaHolder() {
+    current_arena = new Arena();
+  }
+  ArenaHolder(const ArenaHolder &) = delete;
+  ArenaHolder &operator=(const ArenaHolder &) = delete;
+  ~ArenaHolder() {
+    auto *arena = current_arena;
+    current_arena = nullptr;
+    is_arena_closed = true;
+    arena->close();
+  }
+};
+
+Arena *get_arena() {
+  if (likely(current_arena != nullptr)) {
+    return current_arena;
+  }
+  // don't register new thread local destructors while thread locals are being destroyed
+  if (is_arena_closed) {
+    return nullptr;
+  }
+  init_thread_local<ArenaHolder>(current_arena_holder);
+  return current_arena;
+}
+}  // namespace
+
+std::atomic<ActorMessageAllocator::Hook> ActorMessageAllocator::hook_{nullptr};
+std::atomic<bool> ActorMessageAllocator::use_arena_{true};
+
+void *ActorMessageAllocator::allocate(size_t size) {
+  auto hook = hook_.load(std::memory_order_relaxed);
+  if (hook != nullptr) {
+    hook(size);
+  }
+
+  auto block_size = td::max(size + sizeof(BlockHeader), sizeof(FreeBlock));
+  if (block_size <= MAX_BLOCK_SIZE && use_arena_.load(std::memory_order_relaxed)) {
+    auto *arena = get_arena();
+    if (arena != nullptr) {
+      return arena->allocate(get_size_class(block_size));
+    }
+  }
+
+  auto *header = static_cast<BlockHeader *>(malloc_or_throw(block_size));
+  header->arena = nullptr;
+  return header + 1;
+}
+
+void ActorMessageAllocator::deallocate(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  auto *header = static_cast<BlockHeader *>(ptr) - 1;
+  auto *arena = header->arena;
+  if (arena == nullptr) {
+    std::free(header);
+  } else if (arena == current_arena) {
+    arena->deallocate_local(header);
+  } else {
+    arena->deallocate_remote(header);
+  }
+}
+
+void ActorMessageAllocator::set_hook(Hook hook) {
+  hook_.store(hook, std::memory_order_relaxed);
+}
+
+void ActorMessageAllocator::set_use_arena(bool use_arena) {
+  use_arena_.store(use_arena, std::memory_order_relaxed);
+}
+
+bool ActorMessageAllocator::get_use_arena() {
+  return use_arena_.load(std::memory_order_relaxed);
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,53 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <atomic>
+
+namespace td {
+namespace actor {
+namespace core {
+// Allocator for actor messages.
+//
+// Small blocks are carved from per-thread chunks and reused through per-size-class free lists.
+// A block freed by another thread is pushed to a lock-free stack of the arena it came from,
+// and is reused by the owner thread once its free list is empty.
+// An arena outlives its thread until every block allocated from it is freed.
+class ActorMessageAllocator {
+ public:
+  static void *allocate(size_t size);
+  static void deallocate(void *ptr);
+
+  // Called on every allocation with the requested size. Used for instrumentation only.
+  using Hook = void (*)(size_t size);
+  static void set_hook(Hook hook);
+
+  // When disabled, new messages are allocated with plain malloc
+  static void set_use_arena(bool use_arena);
+  static bool get_use_arena();
+
+ private:
+  static std::atomic<Hook> hook_;
+  static std::atomic<bool> use_arena_;
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -31,7 +31,7 @@ void CpuWorker::run() {
   int yields = 0;
   while (true) {
     SchedulerMessage message;
-    if (queue_.try_pop(message, thread_id)) {
+    if (try_pop(message, thread_id)) {
       if (!message) {
         return;
       }
@@ -42,6 +42,42 @@ void CpuWorker::run() {
     }
   }
 }
+
+bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
+  if (local_queues_.empty()) {
+    return queue_.try_pop(message, thread_id);
+  }
+  // Check the shared queue first from time to time, so messages from other threads are not starved
+  if (++cnt_ == 61) {
+    cnt_ = 0;
+    if (queue_.try_pop(message, thread_id)) {
+      return true;
+    }
+  }
+  return try_pop_local(message) || queue_.try_pop(message, thread_id) || try_steal(message);
+}
+
+bool CpuWorker::try_pop_local(SchedulerMessage &message) {
+  SchedulerMessage::Raw *raw;
+  if (!local_queues_[id_]->local_pop(raw)) {
+    return false;
+  }
+  message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw);
+  return true;
+}
+
+bool CpuWorker::try_steal(SchedulerMessage &message) {
+  auto &local_queue = *local_queues_[id_];
+  for (size_t i = 1; i < local_queues_.size(); i++) {
+    auto &other_queue = *local_queues_[(id_ + i) % local_queues_.size()];
+    SchedulerMessage::Raw *raw;
+    if (local_queue.steal(raw, other_queue)) {
+      message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw);
+      return true;
+    }
+  }
+  return false;
+}
 }  // namespace core
 }  // namespace actor
 }  // namespace td
@@ -23,18 +23,30 @@
 #include "td/utils/MpmcQueue.h"
 #include "td/utils/MpmcWaiter.h"
 
+#include <memory>
+#include <vector>
+
 namespace td {
 namespace actor {
 namespace core {
 class CpuWorker {
  public:
-  CpuWorker(MpmcQueue<SchedulerMessage> &queue, MpmcWaiter &waiter) : queue_(queue), waiter_(waiter) {
+  CpuWorker(MpmcQueue<SchedulerMessage> &queue, MpmcWaiter &waiter, size_t id,
+            std::vector<std::unique_ptr<LocalSchedulerQueue>> &local_queues)
+      : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues) {
   }
   void run();
 
  private:
   MpmcQueue<SchedulerMessage> &queue_;
   MpmcWaiter &waiter_;
+  size_t id_;
+  std::vector<std::unique_ptr<LocalSchedulerQueue>> &local_queues_;
+  int cnt_{0};
+
+  bool try_pop(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_local(SchedulerMessage &message);
+  bool try_steal(SchedulerMessage &message);
 };
 }  // namespace core
 }  // namespace actor
@@ -33,13 +33,20 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
     info_->cpu_threads_count = cpu_threads_count;
     info_->cpu_queue = std::make_unique<MpmcQueue<SchedulerMessage>>(1024, max_thread_count());
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
+    if (scheduler_group_info_->cpu_queue_mode == SchedulerGroupInfo::CpuQueueMode::WorkStealing) {
+      info_->cpu_local_queues.resize(cpu_threads_count);
+      for (auto &local_queue : info_->cpu_local_queues) {
+        local_queue = std::make_unique<LocalSchedulerQueue>();
+      }
+    }
   }
   info_->io_queue = std::make_unique<MpscPollableQueue<SchedulerMessage>>();
   info_->io_queue->init();
 
   info_->cpu_workers.resize(cpu_threads_count);
-  for (auto &worker : info_->cpu_workers) {
-    worker = std::make_unique<WorkerInfo>(WorkerInfo::Type::Cpu, true);
+  for (size_t i = 0; i < cpu_threads_count; i++) {
+    info_->cpu_workers[i] = std::make_unique<WorkerInfo>(WorkerInfo::Type::Cpu, true);
+    info_->cpu_workers[i]->cpu_worker_id = narrow_cast<int32>(i);
   }
   info_->io_worker = std::make_unique<WorkerInfo>(WorkerInfo::Type::Io, !info_->cpu_workers.empty());
 
@@ -62,8 +69,9 @@ Scheduler::~Scheduler() {
 void Scheduler::start() {
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
-      this->run_in_context_impl(*this->info_->cpu_workers[i],
-                                [this] { CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter).run(); });
+      this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
+        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queues).run();
+      });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
   }
@@ -121,9 +129,14 @@ void Scheduler::do_stop() {
   scheduler_group_info_->active_scheduler_count_condition_variable.notify_all();
 }
 
-Scheduler::ContextImpl::ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id,
+Scheduler::ContextImpl::ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id, int32 cpu_worker_id,
                                     SchedulerGroupInfo *scheduler_group, Poll *poll, KHeap<double> *heap)
-    : creator_(creator), scheduler_id_(scheduler_id), scheduler_group_(scheduler_group), poll_(poll), heap_(heap) {
+    : creator_(creator)
+    , scheduler_id_(scheduler_id)
+    , cpu_worker_id_(cpu_worker_id)
+    , scheduler_group_(scheduler_group)
+    , poll_(poll)
+    , heap_(heap) {
 }
 
 SchedulerId Scheduler::ContextImpl::get_scheduler_id() const {
@@ -137,6 +150,17 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   auto &info = scheduler_group()->schedulers.at(scheduler_id.value());
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
+  } else if (cpu_worker_id_ >= 0 && !info.cpu_local_queues.empty() && scheduler_id == get_scheduler_id()) {
+    // Keep the message on this worker. Other workers are woken up only if it already has some work queued,
+    // otherwise the message will be executed right after the current one
+    bool overflow = false;
+    auto was_empty = info.cpu_local_queues[cpu_worker_id_]->local_push(actor_info_ptr.release(), [&](auto *raw) {
+      info.cpu_queue->push(SchedulerMessage(SchedulerMessage::acquire_t{}, raw), get_thread_id());
+      overflow = true;
+    });
+    if (!was_empty || overflow) {
+      info.cpu_queue_waiter->notify();
+    }
   } else {
     info.cpu_queue->push(std::move(actor_info_ptr), get_thread_id());
     info.cpu_queue_waiter->notify();
@@ -265,6 +289,16 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
+
+      // Drain local cpu queues
+      for (auto &local_queue : scheduler_info.cpu_local_queues) {
+        SchedulerMessage::Raw *raw;
+        while (local_queue->local_pop(raw)) {
+          SchedulerMessage message(SchedulerMessage::acquire_t{}, raw);
+          // message's destructor is called
+          queues_are_empty = false;
+        }
+      }
     }
     if (++it > 100) {
       LOG(FATAL) << "Failed to drain all queues";
@@ -276,6 +310,7 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_local_queues.clear();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
@@ -69,6 +69,8 @@ struct WorkerInfo {
   explicit WorkerInfo(Type type, bool allow_shared) : type(type), actor_info_creator(allow_shared) {
   }
   ActorInfoCreator actor_info_creator;
+  // index in SchedulerInfo::cpu_workers, -1 for other workers
+  int32 cpu_worker_id{-1};
 };
 
 struct SchedulerInfo {
@@ -76,6 +78,8 @@ struct SchedulerInfo {
   // will be read by all workers is any thread
   std::unique_ptr<MpmcQueue<SchedulerMessage>> cpu_queue;
   std::unique_ptr<MpmcWaiter> cpu_queue_waiter;
+  // one queue per cpu worker, only in CpuQueueMode::WorkStealing
+  std::vector<std::unique_ptr<LocalSchedulerQueue>> cpu_local_queues;
   // only scheduler itself may read from io_queue_
   std::unique_ptr<MpscPollableQueue<SchedulerMessage>> io_queue;
   size_t cpu_threads_count{0};
@@ -85,8 +89,14 @@ struct SchedulerInfo {
 };
 
 struct SchedulerGroupInfo {
-  explicit SchedulerGroupInfo(size_t n) : schedulers(n) {
+  // Shared: all cpu workers of a scheduler pop messages from one cpu_queue
+  // WorkStealing: messages sent from a cpu worker are put into its own queue,
+  // idle workers steal from queues of other workers, cpu_queue is used for messages from other threads
+  enum class CpuQueueMode { Shared, WorkStealing };
+  explicit SchedulerGroupInfo(size_t n, CpuQueueMode cpu_queue_mode = CpuQueueMode::Shared)
+      : cpu_queue_mode(cpu_queue_mode), schedulers(n) {
   }
+  const CpuQueueMode cpu_queue_mode;
   std::atomic<bool> is_stop_requested{false};
 
   int active_scheduler_count{0};
@@ -156,8 +166,8 @@ class Scheduler {
 
   class ContextImpl : public SchedulerContext {
    public:
-    ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id, SchedulerGroupInfo *scheduler_group, Poll *poll,
-                KHeap<double> *heap);
+    ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id, int32 cpu_worker_id,
+                SchedulerGroupInfo *scheduler_group, Poll *poll, KHeap<double> *heap);
 
     SchedulerId get_scheduler_id() const override;
     void add_to_queue(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) override;
@@ -181,6 +191,7 @@ class Scheduler {
 
     ActorInfoCreator *creator_;
     SchedulerId scheduler_id_;
+    int32 cpu_worker_id_;
     SchedulerGroupInfo *scheduler_group_;
     Poll *poll_;
 
@@ -193,8 +204,8 @@ class Scheduler {
     td::detail::Iocp::Guard iocp_guard(&scheduler_group_info_->iocp);
 #endif
     bool is_io_worker = worker_info.type == WorkerInfo::Type::Io;
-    ContextImpl context(&worker_info.actor_info_creator, info_->id, scheduler_group_info_.get(),
-                        is_io_worker ? &poll_ : nullptr, is_io_worker ? &heap_ : nullptr);
+    ContextImpl context(&worker_info.actor_info_creator, info_->id, worker_info.cpu_worker_id,
+                        scheduler_group_info_.get(), is_io_worker ? &poll_ : nullptr, is_io_worker ? &heap_ : nullptr);
     SchedulerContext::Guard guard(&context);
     f();
   }
@@ -20,10 +20,13 @@
 
 #include "td/actor/core/ActorInfo.h"
 
+#include "td/utils/StealingQueue.h"
+
 namespace td {
 namespace actor {
 namespace core {
 using SchedulerMessage = ActorInfoPtr;
+using LocalSchedulerQueue = StealingQueue<SchedulerMessage::Raw *>;
 }  // namespace core
 }  // namespace actor
 }  // namespace td
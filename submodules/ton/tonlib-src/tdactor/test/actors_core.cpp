@@ -17,6 +17,7 @@
     Copyright 2017-2019 Telegram Systems LLP
 */
 #include "td/actor/core/ActorLocker.h"
+#include "td/actor/core/ActorMessageAllocator.h"
 #include "td/actor/actor.h"
 #include "td/actor/PromiseFuture.h"
 
@@ -29,6 +30,7 @@
 #include "td/utils/tests.h"
 #include "td/utils/Time.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <deque>
@@ -713,8 +715,8 @@ TEST(Actor2, actor_function_result) {
   sb.clear();
 }
 
-TEST(Actor2, actor_ping_pong) {
-  auto group_info = std::make_shared<core::SchedulerGroupInfo>(1);
+static void run_actor_ping_pong(core::SchedulerGroupInfo::CpuQueueMode cpu_queue_mode) {
+  auto group_info = std::make_shared<core::SchedulerGroupInfo>(1, cpu_queue_mode);
   core::Scheduler scheduler{group_info, SchedulerId{0}, 3};
   sb.clear();
   scheduler.start();
@@ -787,6 +789,14 @@ TEST(Actor2, actor_ping_pong) {
   sb.clear();
 }
 
+TEST(Actor2, actor_ping_pong) {
+  run_actor_ping_pong(core::SchedulerGroupInfo::CpuQueueMode::Shared);
+}
+
+TEST(Actor2, actor_ping_pong_work_stealing) {
+  run_actor_ping_pong(core::SchedulerGroupInfo::CpuQueueMode::WorkStealing);
+}
+
 TEST(Actor2, Schedulers) {
   for (auto mode : {Scheduler::Running, Scheduler::Paused}) {
     for (auto start_count : {0, 1, 2}) {
@@ -846,6 +856,79 @@ TEST(Actor2, SchedulerTwo) {
   });
   scheduler.run();
 }
+TEST(Actor2, MessageAllocator) {
+  using td::actor::core::ActorMessageAllocator;
+  struct Block {
+    char *ptr;
+    size_t size;
+  };
+  auto allocate = [](size_t size) {
+    auto *ptr = static_cast<char *>(ActorMessageAllocator::allocate(size));
+    std::fill(ptr, ptr + size, static_cast<char>(size));
+    return Block{ptr, size};
+  };
+  auto deallocate = [](Block block) {
+    for (size_t i = 0; i < block.size; i++) {
+      CHECK(block.ptr[i] == static_cast<char>(block.size));
+    }
+    ActorMessageAllocator::deallocate(block.ptr);
+  };
+
+  // blocks freed by another thread while the owner is alive, and after it has exited
+  std::vector<Block> blocks;
+  td::thread([&] {
+    std::vector<Block> local;
+    for (int i = 0; i < 10000; i++) {
+      local.push_back(allocate(td::Random::fast(1, 1000)));
+    }
+    auto t = td::thread([&] {
+      for (size_t i = 0; i < local.size(); i += 2) {
+        deallocate(local[i]);
+      }
+    });
+    t.join();
+    for (size_t i = 1; i < local.size(); i += 2) {
+      if (i % 4 == 1) {
+        deallocate(local[i]);
+      } else {
+        blocks.push_back(local[i]);
+      }
+    }
+    for (int i = 0; i < 10000; i++) {
+      local.push_back(allocate(td::Random::fast(1, 1000)));
+      blocks.push_back(local.back());
+    }
+  }).join();
+  for (auto &block : blocks) {
+    deallocate(block);
+  }
+}
+
+static std::atomic<td::uint64> message_allocation_count;
+TEST(Actor2, MessageAllocatorHook) {
+  td::actor::core::ActorMessageAllocator::set_hook([](size_t) { message_allocation_count++; });
+  message_allocation_count = 0;
+  static constexpr int N = 1000;
+  Scheduler scheduler({1});
+  scheduler.run_in_context([] {
+    class A : public Actor {
+     public:
+      void ping(int left) {
+        if (left == 0) {
+          SchedulerContext::get()->stop();
+          return;
+        }
+        send_closure_later(actor_id(this), &A::ping, left - 1);
+      }
+    };
+    auto id = create_actor<A>(ActorOptions().with_name("A").with_poll(false)).release();
+    send_closure_later(id, &A::ping, N);
+  });
+  scheduler.run();
+  td::actor::core::ActorMessageAllocator::set_hook(nullptr);
+  LOG_CHECK(message_allocation_count >= N) << message_allocation_count;
+}
+
 TEST(Actor2, ActorIdDynamicCast) {
   Scheduler scheduler({0});
   scheduler.run_in_context([] {
@@ -17,6 +17,7 @@
     Copyright 2017-2019 Telegram Systems LLP
 */
 #pragma once
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 #include "td/utils/logging.h"
 namespace td {
@@ -27,6 +28,18 @@ class KeyValueReader {
 
   virtual Result<GetStatus> get(Slice key, std::string &value) = 0;
   virtual Result<size_t> count(Slice prefix) = 0;
+
+  // Looks up several keys at once; values are resized to keys.size()
+  // Default implementation just calls get for every key
+  virtual Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> &values) {
+    std::vector<GetStatus> res(keys.size());
+    values.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      TRY_RESULT(status, get(keys[i], values[i]));
+      res[i] = status;
+    }
+    return std::move(res);
+  }
 };
 
 class PrefixedKeyValueReader : public KeyValueReader {
@@ -40,6 +53,15 @@ class PrefixedKeyValueReader : public KeyValueReader {
   Result<size_t> count(Slice prefix) override {
     return reader_->count(PSLICE() << prefix_ << prefix);
   }
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> &values) override {
+    std::vector<std::string> prefixed_keys;
+    prefixed_keys.reserve(keys.size());
+    for (auto &key : keys) {
+      prefixed_keys.push_back(prefix_ + key.str());
+    }
+    std::vector<Slice> slices(prefixed_keys.begin(), prefixed_keys.end());
+    return reader_->get_multi(slices, values);
+  }
 
  private:
   std::shared_ptr<KeyValueReader> reader_;
@@ -79,6 +101,15 @@ class PrefixedKeyValue : public KeyValue {
   Result<size_t> count(Slice prefix) override {
     return kv_->count(PSLICE() << prefix_ << prefix);
   }
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> &values) override {
+    std::vector<std::string> prefixed_keys;
+    prefixed_keys.reserve(keys.size());
+    for (auto &key : keys) {
+      prefixed_keys.push_back(prefix_ + key.str());
+    }
+    std::vector<Slice> slices(prefixed_keys.begin(), prefixed_keys.end());
+    return kv_->get_multi(slices, values);
+  }
   Status set(Slice key, Slice value) override {
     return kv_->set(PSLICE() << prefix_ << key, value);
   }
@@ -106,6 +106,39 @@ Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
   return from_rocksdb(status);
 }
 
+Result<std::vector<RocksDb::GetStatus>> RocksDb::get_multi(Span<Slice> keys, std::vector<std::string> &values) {
+  std::vector<rocksdb::Slice> rocksdb_keys;
+  rocksdb_keys.reserve(keys.size());
+  for (auto &key : keys) {
+    rocksdb_keys.push_back(to_rocksdb(key));
+  }
+  values.clear();
+  std::vector<rocksdb::Status> statuses;
+  if (snapshot_) {
+    rocksdb::ReadOptions options;
+    options.snapshot = snapshot_.get();
+    statuses = db_->MultiGet(options, rocksdb_keys, &values);
+  } else if (transaction_) {
+    statuses = transaction_->MultiGet({}, rocksdb_keys, &values);
+  } else {
+    statuses = db_->MultiGet({}, rocksdb_keys, &values);
+  }
+  values.resize(keys.size());
+
+  std::vector<GetStatus> res(keys.size());
+  for (size_t i = 0; i < statuses.size(); i++) {
+    auto &status = statuses[i];
+    if (status.ok()) {
+      res[i] = GetStatus::Ok;
+    } else if (status.code() == rocksdb::Status::kNotFound) {
+      res[i] = GetStatus::NotFound;
+    } else {
+      return from_rocksdb(status);
+    }
+  }
+  return std::move(res);
+}
+
 Status RocksDb::set(Slice key, Slice value) {
   if (write_batch_) {
     return from_rocksdb(write_batch_->Put(to_rocksdb(key), to_rocksdb(value)));
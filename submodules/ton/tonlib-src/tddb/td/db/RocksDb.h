@@ -44,6 +44,7 @@ class RocksDb : public KeyValue {
   Status set(Slice key, Slice value) override;
   Status erase(Slice key) override;
   Result<size_t> count(Slice prefix) override;
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> &values) override;
 
   Status begin_transaction() override;
   Status commit_transaction() override;
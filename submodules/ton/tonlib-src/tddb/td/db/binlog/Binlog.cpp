@@ -29,12 +29,45 @@
 
 #include "td/actor/actor.h"
 
+#include "td/utils/as.h"
+#include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/VectorQueue.h"
 
+#include <vector>
+
 namespace td {
 namespace {
+constexpr uint32 CHECKPOINT_MAGIC = 0x6b706363;
+constexpr size_t CHECKPOINT_HEADER_SIZE = 24;
+constexpr int64 CHECKPOINT_ID_WINDOW = 4096;
+
+Status pread_exact(const FileFd& fd, MutableSlice dest, int64 offset) {
+  while (!dest.empty()) {
+    TRY_RESULT(read, fd.pread(dest, offset));
+    if (read == 0) {
+      return Status::Error("Unexpected end of file");
+    }
+    dest.remove_prefix(read);
+    offset += static_cast<int64>(read);
+  }
+  return Status::OK();
+}
+
+// Identifies the binlog a checkpoint is made for by the first and the last bytes before the checkpoint,
+// so that the checkpointed part is still not read as a whole
+Result<uint32> get_binlog_prefix_id(const FileFd& fd, int64 binlog_size) {
+  auto window = narrow_cast<size_t>(td::min(binlog_size, CHECKPOINT_ID_WINDOW));
+  string data(window * 2, '\0');
+  TRY_STATUS(pread_exact(fd, MutableSlice(data).substr(0, window), 0));
+  TRY_STATUS(pread_exact(fd, MutableSlice(data).substr(window), binlog_size - static_cast<int64>(window)));
+  return crc32c(data);
+}
+
 class BinlogReplayActor : public actor::Actor {
  public:
   BinlogReplayActor(StreamReader stream_reader, actor::ActorOwn<FileToStreamActor> file_to_stream,
@@ -131,6 +164,9 @@ Status Binlog::replay_sync(BinlogReaderInterface& binlog_reader) {
   auto buf_writer = std::move(reader_writer.second);
 
   TRY_RESULT(fd_size, fd.get_size());
+  auto offset = restore_checkpoint(binlog_reader, fd, fd_size);
+  TRY_STATUS(fd.seek(offset));
+  fd_size -= offset;
 
   BinlogReaderHelper helper;
   while (fd_size != 0) {
@@ -177,9 +213,17 @@ void Binlog::replay_async(std::shared_ptr<BinlogReaderInterface> binlog_reader,
   auto r_fd_size = fd.get_size();
   if (r_fd_size.is_error()) {
     promise.set_error(r_fd_size.move_as_error());
+    return;
+  }
+  auto fd_size = r_fd_size.move_as_ok();
+  auto offset = restore_checkpoint(*binlog_reader, fd, fd_size);
+  auto status = fd.seek(offset);
+  if (status.is_error()) {
+    promise.set_error(std::move(status));
+    return;
   }
   auto options = FileToStreamActor::Options{};
-  options.limit = r_fd_size.move_as_ok();
+  options.limit = fd_size - offset;
   auto file_to_stream =
       actor::create_actor<FileToStreamActor>("FileToStream", std::move(fd), std::move(buf_writer), options);
   auto stream_to_binlog = actor::create_actor<BinlogReplayActor>(
@@ -187,8 +231,172 @@ void Binlog::replay_async(std::shared_ptr<BinlogReaderInterface> binlog_reader,
   stream_to_binlog.release();
 }
 
+Status Binlog::replay_parallel(BinlogReaderInterface& binlog_reader, size_t threads_n) {
+  if (threads_n <= 1 || !binlog_reader.is_parallel_replay_supported()) {
+    return replay_sync(binlog_reader);
+  }
+
+  TRY_RESULT(fd, FileFd::open(path_, FileFd::Flags::Read));
+  TRY_RESULT(fd_size, fd.get_size());
+  auto offset = restore_checkpoint(binlog_reader, fd, fd_size);
+  TRY_STATUS(fd.seek(offset));
+  fd_size -= offset;
+
+  // Batch is checked by its own threads, while events of the previous batch are given to the reader
+  struct Batch {
+    string data;
+    std::vector<Slice> events;
+    std::vector<Status> statuses;
+    std::vector<td::thread> threads;
+  };
+  constexpr size_t BATCH_SIZE = 1 << 22;
+
+  string tail;
+  auto read_batch = [&](Batch& batch) -> Status {
+    auto read_size = narrow_cast<size_t>(td::min(fd_size, static_cast<int64>(BATCH_SIZE)));
+    batch.data = std::move(tail);
+    auto prefix_size = batch.data.size();
+    batch.data.resize(prefix_size + read_size);
+    auto dest = MutableSlice(batch.data).substr(prefix_size);
+    while (!dest.empty()) {
+      TRY_RESULT(read, fd.read(dest));
+      if (read == 0) {
+        return Status::Error("Unexpected end of file");
+      }
+      dest.remove_prefix(read);
+    }
+    fd_size -= read_size;
+
+    Slice data = batch.data;
+    while (!data.empty()) {
+      TRY_RESULT(size, binlog_reader.get_event_size(data));
+      if (size < 0) {
+        break;
+      }
+      if (size == 0) {
+        return Status::Error("BinlogReader parsed nothing and asked for nothing");
+      }
+      if (narrow_cast<size_t>(size) > data.size()) {
+        return Status::Error("BinlogReader parsed more than was given");
+      }
+      batch.events.push_back(data.substr(0, narrow_cast<size_t>(size)));
+      data.remove_prefix(narrow_cast<size_t>(size));
+    }
+    if (fd_size == 0 && !data.empty()) {
+      return Status::Error(PSLICE() << "Got " << data.size() << " unparsed bytes in binlog");
+    }
+    // the last incomplete event goes to the next batch
+    tail = data.str();
+    return Status::OK();
+  };
+
+  auto start_check = [&](Batch& batch) {
+    auto parts_n = td::min(threads_n, batch.events.size());
+    batch.statuses.resize(parts_n);
+    for (size_t i = 0; i < parts_n; i++) {
+      auto begin = batch.events.size() * i / parts_n;
+      auto end = batch.events.size() * (i + 1) / parts_n;
+      batch.threads.emplace_back([&binlog_reader, events = batch.events.data(), status = &batch.statuses[i], begin,
+                                  end] {
+        for (auto j = begin; j < end; j++) {
+          *status = binlog_reader.check_event(events[j]);
+          if (status->is_error()) {
+            return;
+          }
+        }
+      });
+    }
+  };
+
+  auto batch = make_unique<Batch>();
+  TRY_STATUS(read_batch(*batch));
+  start_check(*batch);
+  while (true) {
+    unique_ptr<Batch> next_batch;
+    if (fd_size != 0) {
+      next_batch = make_unique<Batch>();
+      TRY_STATUS(read_batch(*next_batch));
+      start_check(*next_batch);
+    }
+
+    for (auto& thread : batch->threads) {
+      thread.join();
+    }
+    for (auto& status : batch->statuses) {
+      TRY_STATUS(std::move(status));
+    }
+    for (auto event : batch->events) {
+      TRY_RESULT(size, binlog_reader.parse(event));
+      if (size != static_cast<int64>(event.size())) {
+        return Status::Error("BinlogReader changed logevent");
+      }
+    }
+    binlog_reader.flush();
+
+    if (!next_batch) {
+      break;
+    }
+    batch = std::move(next_batch);
+  }
+  return Status::OK();
+}
+
+string Binlog::checkpoint_path() const {
+  return path_ + ".checkpoint";
+}
+
+Status Binlog::write_checkpoint(int64 binlog_size, Slice snapshot) {
+  TRY_RESULT(fd, FileFd::open(path_, FileFd::Flags::Read));
+  TRY_RESULT(fd_size, fd.get_size());
+  if (binlog_size < 0 || binlog_size > fd_size) {
+    return Status::Error(PSLICE() << "Can't make checkpoint at " << binlog_size << ", binlog size is " << fd_size);
+  }
+  TRY_RESULT(prefix_id, get_binlog_prefix_id(fd, binlog_size));
+
+  string data(CHECKPOINT_HEADER_SIZE + snapshot.size(), '\0');
+  MutableSlice dest(data);
+  as<uint32>(dest.data()) = CHECKPOINT_MAGIC;
+  as<int64>(dest.data() + 8) = binlog_size;
+  as<uint32>(dest.data() + 16) = prefix_id;
+  dest.substr(CHECKPOINT_HEADER_SIZE).copy_from(snapshot);
+  as<uint32>(dest.data() + 4) = crc32c(dest.substr(8));
+  return atomic_write_file(checkpoint_path(), data);
+}
+
+int64 Binlog::restore_checkpoint(BinlogReaderInterface& binlog_reader, const FileFd& fd, int64 binlog_size) {
+  auto r_data = read_file_str(checkpoint_path());
+  if (r_data.is_error()) {
+    return 0;
+  }
+  auto data = r_data.move_as_ok();
+  auto r_offset = [&]() -> Result<int64> {
+    if (data.size() < CHECKPOINT_HEADER_SIZE || as<uint32>(data.data()) != CHECKPOINT_MAGIC) {
+      return Status::Error("Wrong checkpoint header");
+    }
+    if (as<uint32>(data.data() + 4) != crc32c(Slice(data).substr(8))) {
+      return Status::Error("Checkpoint crc mismatch");
+    }
+    auto offset = as<int64>(data.data() + 8);
+    if (offset < 0 || offset > binlog_size) {
+      return Status::Error(PSLICE() << "Checkpoint is at " << offset << ", but binlog size is " << binlog_size);
+    }
+    TRY_RESULT(prefix_id, get_binlog_prefix_id(fd, offset));
+    if (prefix_id != as<uint32>(data.data() + 16)) {
+      return Status::Error("Checkpoint is made for another binlog");
+    }
+    TRY_STATUS(binlog_reader.restore_checkpoint(Slice(data).substr(CHECKPOINT_HEADER_SIZE)));
+    return offset;
+  }();
+  if (r_offset.is_error()) {
+    LOG(WARNING) << "Ignore checkpoint of binlog \"" << path_ << "\": " << r_offset.error();
+    return 0;
+  }
+  return r_offset.move_as_ok();
+}
+
 void Binlog::destroy(CSlice path) {
   td::unlink(path).ignore();
+  td::unlink(path.str() + ".checkpoint").ignore();
 }
 
 void Binlog::destroy() {
@@ -200,6 +408,8 @@ BinlogWriter::BinlogWriter(std::string path) : path_(std::move(path)) {
 
 Status BinlogWriter::open() {
   TRY_RESULT(fd, FileFd::open(path_, FileFd::Flags::Write | FileFd::Flags::Append | FileFd::Create));
+  TRY_RESULT(fd_size, fd.get_size());
+  start_position_ = fd_size;
   fd_ = std::move(fd);
   ChainBuffer::Options buf_options;
   buf_options.max_io_slices = 128;
@@ -229,6 +439,10 @@ Status BinlogWriter::sync() {
   return fd_.sync();
 }
 
+int64 BinlogWriter::position() {
+  return start_position_ + static_cast<int64>(buf_writer_.writer_size());
+}
+
 Status BinlogWriter::close() {
   sync();
   fd_.close();
@@ -245,11 +459,21 @@ class FlushHelperActor : public actor::Actor {
     //TODO;
   }
   void sync(size_t position, Promise<Unit> promise) {
-    sync_state_reader_.set_requested_sync_size(position);
+    if (position <= sync_state_reader_.synced_size()) {
+      promise.set_value(Unit());
+      return;
+    }
     if (promise) {
       queries_.emplace(position, std::move(promise));
     }
-    send_signals_later(actor_, actor::ActorSignals::wakeup());
+    // group commit: while some sync is already scheduled, the writer will reschedule itself for the rest of the data,
+    // so there is no need to wake it up on every request
+    bool is_sync_pending = requested_position_ > sync_state_reader_.synced_size();
+    requested_position_ = td::max(requested_position_, position);
+    sync_state_reader_.set_requested_sync_size(requested_position_);
+    if (!is_sync_pending) {
+      send_signals_later(actor_, actor::ActorSignals::wakeup());
+    }
   }
 
   void close(Promise<> promise) {
@@ -261,6 +485,7 @@ class FlushHelperActor : public actor::Actor {
   FileSyncState::Reader sync_state_reader_;
   actor::ActorOwn<StreamToFileActor> actor_;
   Promise<> close_promise_;
+  size_t requested_position_{0};
 
   struct Query {
     Query(size_t position, Promise<Unit> promise) : position(position), promise(std::move(promise)) {
@@ -295,6 +520,11 @@ class FlushHelperActor : public actor::Actor {
       queries_.front().promise.set_value(Unit());
       queries_.pop();
     }
+    // requests that came while the writer was syncing were not passed to it, and the writer may have missed them,
+    // because it checks the requested size before it is updated, so it must be woken up for the rest of the data
+    if (requested_position_ > synced_position && !actor_.empty()) {
+      send_signals_later(actor_, actor::ActorSignals::wakeup());
+    }
   }
 
   void hangup_shared() override {
@@ -307,12 +537,15 @@ class FlushHelperActor : public actor::Actor {
   }
 };
 }  // namespace detail
-BinlogWriterAsync::BinlogWriterAsync(std::string path) : path_(std::move(path)) {
+BinlogWriterAsync::BinlogWriterAsync(std::string path, Options options)
+    : path_(std::move(path)), options_(options) {
 }
 BinlogWriterAsync::~BinlogWriterAsync() = default;
 
 Status BinlogWriterAsync::open() {
   TRY_RESULT(fd, FileFd::open(path_, FileFd::Flags::Write | FileFd::Flags::Append | FileFd::Create));
+  TRY_RESULT(fd_size, fd.get_size());
+  start_position_ = fd_size;
   ChainBuffer::Options buf_options;
   buf_options.max_io_slices = 128;
   buf_options.chunk_size = 256;
@@ -321,7 +554,8 @@ Status BinlogWriterAsync::open() {
 
   auto sync_state_reader_writer = td::FileSyncState::create();
   auto writer_actor = actor::create_actor<StreamToFileActor>("StreamToFile", std::move(reader_writer.first),
-                                                             std::move(fd), std::move(sync_state_reader_writer.second));
+                                                             std::move(fd), std::move(sync_state_reader_writer.second),
+                                                             options_);
   writer_actor_ = writer_actor.get();
   sync_state_reader_ = std::move(sync_state_reader_writer.first);
 
@@ -345,5 +579,11 @@ void BinlogWriterAsync::flush() {
 void BinlogWriterAsync::sync(Promise<Unit> promise) {
   send_closure(flush_helper_actor_, &detail::FlushHelperActor::sync, buf_writer_.writer_size(), std::move(promise));
 }
+size_t BinlogWriterAsync::sync_count() const {
+  return sync_state_reader_.sync_count();
+}
+int64 BinlogWriterAsync::position() {
+  return start_position_ + static_cast<int64>(buf_writer_.writer_size());
+}
 
 }  // namespace td
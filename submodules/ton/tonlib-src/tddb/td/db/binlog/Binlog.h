@@ -22,6 +22,7 @@
 
 #include "td/db/utils/FileSyncState.h"
 #include "td/db/utils/StreamInterface.h"
+#include "td/db/utils/StreamToFileActor.h"
 
 #include "td/actor/actor.h"
 
@@ -30,7 +31,6 @@
 
 namespace td {
 class BinlogReaderInterface;
-class StreamToFileActor;
 namespace detail {
 class FlushHelperActor;
 }  // namespace detail
@@ -40,12 +40,23 @@ class Binlog {
 
   Status replay_sync(BinlogReaderInterface& binlog_reader);
   void replay_async(std::shared_ptr<BinlogReaderInterface> binlog_reader, Promise<Unit> promise);
+  // frames events and checks them with BinlogReaderInterface::check_event using threads_n threads,
+  // while events are still passed to parse in order from the current thread
+  Status replay_parallel(BinlogReaderInterface& binlog_reader, size_t threads_n);
+
+  // Saves reader's state after the first binlog_size bytes of the binlog, so all replays could start from there.
+  // The events must be already synced, e.g. binlog_size is BinlogWriter::position() after sync.
+  // The checkpoint is ignored if the first or the last few kilobytes before binlog_size change.
+  Status write_checkpoint(int64 binlog_size, Slice snapshot);
 
   static void destroy(CSlice path);
   void destroy();
 
  private:
   string path_;
+
+  string checkpoint_path() const;
+  int64 restore_checkpoint(BinlogReaderInterface& binlog_reader, const FileFd& fd, int64 binlog_size);
 };
 
 class BinlogWriter {
@@ -60,11 +71,15 @@ class BinlogWriter {
   Status flush();
   Status sync();
 
+  // size of the binlog with all written events
+  int64 position();
+
   Status close();
 
  private:
   string path_;
   FileFd fd_;
+  int64 start_position_{0};
 
   StreamReader buf_reader_;
   StreamWriter buf_writer_;
@@ -72,7 +87,8 @@ class BinlogWriter {
 
 class BinlogWriterAsync {
  public:
-  BinlogWriterAsync(std::string path);
+  using Options = StreamToFileActor::Options;
+  BinlogWriterAsync(std::string path, Options options = {});
   ~BinlogWriterAsync();
 
   Status open();
@@ -85,10 +101,19 @@ class BinlogWriterAsync {
   void lazy_flush();
 
   void flush();
+  // sync requests made before the writer actually started syncing are completed by the same sync
   void sync(Promise<Unit> promise = {});
 
+  // number of fsync/fdatasync calls made so far
+  size_t sync_count() const;
+
+  // size of the binlog with all written events
+  int64 position();
+
  private:
   std::string path_;
+  Options options_;
+  int64 start_position_{0};
   StreamWriter buf_writer_;
   actor::ActorId<StreamToFileActor> writer_actor_;
   actor::ActorOwn<detail::FlushHelperActor> flush_helper_actor_;
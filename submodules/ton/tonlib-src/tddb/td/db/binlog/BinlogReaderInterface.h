@@ -38,5 +38,25 @@ class BinlogReaderInterface {
   // TODO: maybe we should just process all data that we can at once
   virtual void flush() {
   }
+
+  // Restores state saved with Binlog::write_checkpoint. Replay will continue right after the checkpointed part of
+  // the binlog. On error the reader must leave its state unchanged; then the whole binlog is replayed.
+  virtual td::Status restore_checkpoint(td::Slice snapshot) {
+    return td::Status::Error("Checkpoints are not supported");
+  }
+
+  // Binlog::replay_parallel support.
+  // get_event_size must return the same as parse, but without changing reader's state.
+  // check_event gets exactly one event and is called concurrently from several threads, so it must be thread-safe.
+  // It is the place for expensive checks, like crc. Checked events are passed to parse one by one in binlog order.
+  virtual bool is_parallel_replay_supported() const {
+    return false;
+  }
+  virtual td::Result<td::int64> get_event_size(td::Slice data) const {
+    return td::Status::Error("Parallel replay is not supported");
+  }
+  virtual td::Status check_event(td::Slice event) const {
+    return td::Status::OK();
+  }
 };
 }  // namespace td
@@ -40,6 +40,9 @@ size_t FileSyncState::Reader::synced_size() const {
 size_t FileSyncState::Reader::flushed_size() const {
   return self->flushed_size;
 }
+size_t FileSyncState::Reader::sync_count() const {
+  return self->sync_count.load(std::memory_order_relaxed);
+}
 
 FileSyncState::Writer::Writer(std::shared_ptr<Self> self) : self(std::move(self)) {
 }
@@ -56,6 +59,10 @@ bool FileSyncState::Writer::set_synced_size(size_t size) {
   return true;
 }
 
+void FileSyncState::Writer::inc_sync_count() {
+  self->sync_count.fetch_add(1, std::memory_order_relaxed);
+}
+
 bool FileSyncState::Writer::set_flushed_size(size_t size) {
   if (self->flushed_size.load(std::memory_order_relaxed) == size) {
     return false;
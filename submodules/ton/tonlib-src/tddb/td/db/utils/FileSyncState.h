@@ -35,6 +35,7 @@ class FileSyncState {
     bool set_requested_sync_size(size_t size) const;
     size_t synced_size() const;
     size_t flushed_size() const;
+    size_t sync_count() const;
 
    private:
     std::shared_ptr<Self> self;
@@ -47,6 +48,7 @@ class FileSyncState {
     size_t get_requested_synced_size();
     bool set_synced_size(size_t size);
     bool set_flushed_size(size_t size);
+    void inc_sync_count();
 
    private:
     std::shared_ptr<Self> self;
@@ -60,6 +62,7 @@ class FileSyncState {
 
     std::atomic<size_t> synced_size{0};
     std::atomic<size_t> flushed_size{0};
+    std::atomic<size_t> sync_count{0};
   };
 };
 }  // namespace td
@@ -20,7 +20,7 @@
 
 namespace td {
 StreamToFileActor::StreamToFileActor(StreamReader reader, FileFd fd, FileSyncState::Writer sync_state, Options options)
-    : reader_(std::move(reader)), fd_(std::move(fd)), sync_state_(std::move(sync_state)) {
+    : reader_(std::move(reader)), fd_(std::move(fd)), options_(options), sync_state_(std::move(sync_state)) {
 }
 void StreamToFileActor::set_callback(td::unique_ptr<Callback> callback) {
   callback_ = std::move(callback);
@@ -51,7 +51,18 @@ Status StreamToFileActor::do_sync() {
   if (flushed_size_ == synced_size_) {
     return Status::OK();
   }
-  TRY_STATUS(fd_.sync());
+  switch (options_.durability) {
+    case Durability::Flush:
+      break;
+    case Durability::DataSync:
+      TRY_STATUS(fd_.sync_data());
+      sync_state_.inc_sync_count();
+      break;
+    case Durability::FullSync:
+      TRY_STATUS(fd_.sync());
+      sync_state_.inc_sync_count();
+      break;
+  }
   synced_size_ = flushed_size_;
   return Status::OK();
 }
@@ -61,6 +72,10 @@ void StreamToFileActor::schedule_sync() {
     return;
   }
   if (sync_state_.get_requested_synced_size() > synced_size_) {
+    if (options_.durability == Durability::Flush) {
+      sync_at_ = Timestamp::now();
+      return;
+    }
     sync_at_.relax(Timestamp::in(options_.immediate_sync_delay));
   } else {
     sync_at_.relax(Timestamp::in(options_.lazy_sync_delay));
@@ -28,11 +28,18 @@
 namespace td {
 class StreamToFileActor : public actor::Actor {
  public:
+  enum class Durability {
+    Flush,     // requested syncs are completed as soon as the data is written to the file
+    DataSync,  // fdatasync
+    FullSync   // fsync
+  };
   struct Options {
     Options() {
     }
     double lazy_sync_delay = 10;
+    // all syncs requested within this delay after the first one are completed by a single sync
     double immediate_sync_delay = 0.001;
+    Durability durability = Durability::FullSync;
   };
 
   class Callback {
@@ -31,6 +31,7 @@
 #include "td/utils/optional.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/port/IoSlice.h"
 #include "td/utils/UInt.h"
 #include "td/utils/Variant.h"
@@ -644,6 +645,255 @@ TEST(Binlog, Hands) {
   test_binlog(binlog);
 }
 
+// event is [size:4][crc32c:4][data]
+struct LogEventChecked {
+  std::string data;
+
+  int64 serialize(MutableSlice dest) const {
+    size_t need_size = 8 + data.size();
+    if (dest.size() < need_size) {
+      return -static_cast<int64>(need_size);
+    }
+    td::as<td::uint32>(dest.data()) = td::narrow_cast<td::uint32>(data.size());
+    td::as<td::uint32>(dest.data() + 4) = td::crc32c(data);
+    dest.substr(8).copy_from(data);
+    return static_cast<int64>(need_size);
+  }
+};
+
+class CheckedBinlogReader : public td::BinlogReaderInterface {
+ public:
+  const std::vector<std::string>& events() const {
+    return events_;
+  }
+
+  std::string snapshot() const {
+    std::string res;
+    for (auto& event : events_) {
+      std::string size(4, '\0');
+      td::as<td::uint32>(&size[0]) = td::narrow_cast<td::uint32>(event.size());
+      res += size + event;
+    }
+    return res;
+  }
+
+  td::Result<int64> parse(Slice data) override {
+    TRY_RESULT(size, get_event_size(data));
+    if (size > 0) {
+      TRY_STATUS(check_event(data.substr(0, td::narrow_cast<size_t>(size))));
+      events_.push_back(data.substr(8, td::narrow_cast<size_t>(size) - 8).str());
+    }
+    return size;
+  }
+
+  Status restore_checkpoint(Slice snapshot) override {
+    std::vector<std::string> events;
+    while (!snapshot.empty()) {
+      if (snapshot.size() < 4 || snapshot.size() < 4 + td::as<td::uint32>(snapshot.data())) {
+        return Status::Error("Invalid snapshot");
+      }
+      auto size = td::as<td::uint32>(snapshot.data());
+      events.push_back(snapshot.substr(4, size).str());
+      snapshot.remove_prefix(4 + size);
+    }
+    events_ = std::move(events);
+    return Status::OK();
+  }
+
+  bool is_parallel_replay_supported() const override {
+    return true;
+  }
+  td::Result<int64> get_event_size(Slice data) const override {
+    if (data.size() < 8) {
+      return -8;
+    }
+    auto size = 8 + static_cast<int64>(td::as<td::uint32>(data.data()));
+    if (static_cast<int64>(data.size()) < size) {
+      return -size;
+    }
+    return size;
+  }
+  Status check_event(Slice event) const override {
+    if (td::as<td::uint32>(event.data() + 4) != td::crc32c(event.substr(8))) {
+      return Status::Error("Crc mismatch");
+    }
+    return Status::OK();
+  }
+
+ private:
+  std::vector<std::string> events_;
+};
+
+TEST(Binlog, CheckpointAndParallelReplay) {
+  td::Binlog::destroy(test_binlog_path);
+  td::Binlog binlog(test_binlog_path.str());
+
+  std::vector<std::string> events;
+  CheckedBinlogReader checkpoint_reader;
+  td::int64 checkpoint_position = 0;
+  {
+    td::BinlogWriter binlog_writer(test_binlog_path.str());
+    binlog_writer.open().ensure();
+    for (int i = 0; i < 20000; i++) {
+      LogEventChecked event;
+      event.data = td::rand_string('a', 'z', td::Random::fast(0, 1000));
+      events.push_back(event.data);
+      binlog_writer.write_event(event, &checkpoint_reader).ensure();
+      if (i == 10000) {
+        binlog_writer.sync().ensure();
+        checkpoint_position = binlog_writer.position();
+        binlog.write_checkpoint(checkpoint_position, checkpoint_reader.snapshot()).ensure();
+      }
+    }
+    binlog_writer.close().ensure();
+  }
+
+  auto check_replay = [&](bool expect_ok) {
+    for (size_t threads_n : {1, 4}) {
+      CheckedBinlogReader reader;
+      auto status = binlog.replay_parallel(reader, threads_n);
+      ASSERT_EQ(expect_ok, status.is_ok());
+      if (expect_ok) {
+        ASSERT_TRUE(events == reader.events());
+      }
+    }
+  };
+  check_replay(true);
+
+  // the middle of the checkpointed part is not read at all
+  auto data = read_file_str(test_binlog_path).move_as_ok();
+  auto middle = static_cast<size_t>(checkpoint_position / 2);
+  data[middle] ^= 1;
+  td::write_file(test_binlog_path, data).ensure();
+  check_replay(true);
+
+  td::unlink(test_binlog_path.str() + ".checkpoint").ensure();
+  check_replay(false);
+
+  // damaged event after the checkpoint
+  data[middle] ^= 1;
+  data[data.size() - 100] ^= 1;
+  td::write_file(test_binlog_path, data).ensure();
+  check_replay(false);
+
+  td::Binlog::destroy(test_binlog_path);
+}
+
+TEST(Binlog, CheckpointOfAnotherBinlog) {
+  // events are of the same size, so binlogs with the same number of events are of the same size
+  auto write_binlog = [](int events_n, td::int64* checkpoint_position) {
+    td::Binlog::destroy(test_binlog_path);
+    std::vector<std::string> events;
+    CheckedBinlogReader reader;
+    td::BinlogWriter binlog_writer(test_binlog_path.str());
+    binlog_writer.open().ensure();
+    for (int i = 0; i < events_n; i++) {
+      LogEventChecked event;
+      event.data = td::rand_string('a', 'z', 100);
+      events.push_back(event.data);
+      binlog_writer.write_event(event, &reader).ensure();
+      if (checkpoint_position && i == events_n / 2) {
+        binlog_writer.sync().ensure();
+        *checkpoint_position = binlog_writer.position();
+        td::Binlog(test_binlog_path.str()).write_checkpoint(*checkpoint_position, reader.snapshot()).ensure();
+      }
+    }
+    binlog_writer.close().ensure();
+    return events;
+  };
+
+  td::int64 checkpoint_position = 0;
+  write_binlog(2000, &checkpoint_position);
+  auto old_size = td::stat(test_binlog_path).move_as_ok().size_;
+  auto checkpoint = td::read_file_str(test_binlog_path.str() + ".checkpoint").move_as_ok();
+  for (int events_n : {2000, 3000}) {
+    auto events = write_binlog(events_n, nullptr);
+    ASSERT_TRUE(td::stat(test_binlog_path).move_as_ok().size_ >= old_size);
+    td::write_file(test_binlog_path.str() + ".checkpoint", checkpoint).ensure();
+    for (size_t threads_n : {1, 4}) {
+      CheckedBinlogReader reader;
+      td::Binlog(test_binlog_path.str()).replay_parallel(reader, threads_n).ensure();
+      ASSERT_TRUE(events == reader.events());
+    }
+  }
+  td::Binlog::destroy(test_binlog_path);
+}
+
+TEST(Binlog, AsyncWriterSync) {
+  using Durability = td::StreamToFileActor::Durability;
+  // writes an event and requests a sync every 0.1ms, so many requests are made while a sync is in progress
+  class Writer : public td::actor::Actor {
+   public:
+    Writer(td::BinlogWriterAsync::Options options, std::vector<std::string>& events, size_t& sync_count)
+        : binlog_writer_(test_binlog_path.str(), options), events_(events), sync_count_(sync_count) {
+    }
+
+   private:
+    size_t syncs_n_{500};
+    td::BinlogWriterAsync binlog_writer_;
+    std::vector<std::string>& events_;
+    size_t& sync_count_;
+    CheckedBinlogReader reader_;
+    size_t synced_{0};
+    td::Timestamp deadline_;
+
+    void start_up() override {
+      binlog_writer_.open().ensure();
+      deadline_ = td::Timestamp::in(20);
+      alarm_timestamp() = td::Timestamp::now();
+    }
+    void alarm() override {
+      LOG_IF(FATAL, deadline_.is_in_past()) << "only " << synced_ << " of " << events_.size() << " syncs are done";
+      if (events_.size() < syncs_n_) {
+        LogEventChecked event;
+        event.data = td::rand_string('a', 'z', td::Random::fast(0, 100));
+        events_.push_back(event.data);
+        binlog_writer_.write_event(event, &reader_).ensure();
+        binlog_writer_.sync(td::promise_send_closure(actor_id(this), &Writer::on_synced));
+      }
+      alarm_timestamp() = td::Timestamp::in(0.0001);
+    }
+    void on_synced(td::Result<td::Unit> r_unit) {
+      r_unit.ensure();
+      if (++synced_ < syncs_n_) {
+        return;
+      }
+      sync_count_ = binlog_writer_.sync_count();
+      binlog_writer_.close([](td::Result<td::Unit> res) {
+        res.ensure();
+        td::actor::SchedulerContext::get()->stop();
+      });
+    }
+  };
+
+  for (auto durability : {Durability::Flush, Durability::DataSync, Durability::FullSync}) {
+    td::Binlog::destroy(test_binlog_path);
+    td::BinlogWriterAsync::Options options;
+    options.durability = durability;
+    options.immediate_sync_delay = 0.0001;
+    std::vector<std::string> events;
+    size_t sync_count = 0;
+    {
+      td::actor::Scheduler scheduler({4});
+      scheduler.run_in_context(
+          [&] { td::actor::create_actor<Writer>("Writer", options, events, sync_count).release(); });
+      scheduler.run();
+    }
+
+    if (durability == Durability::Flush) {
+      ASSERT_EQ(0u, sync_count);
+    } else {
+      ASSERT_TRUE(sync_count > 0);
+      ASSERT_TRUE(sync_count <= events.size());
+    }
+    td::Binlog binlog(test_binlog_path.str());
+    CheckedBinlogReader reader;
+    binlog.replay_sync(reader).ensure();
+    ASSERT_TRUE(events == reader.events());
+  }
+  td::Binlog::destroy(test_binlog_path);
+}
+
 TEST(Buffers, CyclicBufferSimple) {
   {
     auto reader_writer = td::CyclicBuffer::create();
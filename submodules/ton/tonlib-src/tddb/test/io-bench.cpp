@@ -28,6 +28,7 @@
 #include "td/utils/OptionsParser.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
 #include "td/utils/Timer.h"
 #include "td/utils/crypto.h"
 #include "td/utils/BufferedReader.h"
@@ -40,7 +41,9 @@
 #include "td/db/utils/FileSyncState.h"
 #include "td/db/utils/StreamToFileActor.h"
 #include "td/db/utils/FileToStreamActor.h"
+#include "td/db/binlog/Binlog.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace td {
@@ -590,11 +593,110 @@ void write_async2(td::CSlice path, size_t buffer_size) {
   scheduler.run();
 }
 
+// Events/sec and sync latency of BinlogWriterAsync for the given durability, group commit window
+// and number of concurrently pending sync requests
+void write_binlog_sync_once(td::CSlice path, size_t event_size, td::BinlogWriterAsync::Options options,
+                            size_t in_flight) {
+  td::unlink(path).ignore();
+  td::actor::Scheduler scheduler({2});
+  scheduler.run_in_context([&] {
+    struct Event {
+      size_t size;
+      td::int64 serialize(td::MutableSlice dest) const {
+        if (dest.size() < size) {
+          return -static_cast<td::int64>(size);
+        }
+        std::memset(dest.data(), 'a', size);
+        return static_cast<td::int64>(size);
+      }
+    };
+    class Writer : public td::actor::Actor {
+     public:
+      Writer(std::string path, size_t event_size, td::BinlogWriterAsync::Options options, size_t in_flight)
+          : binlog_(std::move(path), options), event_size_(event_size), in_flight_(in_flight) {
+      }
+
+     private:
+      td::BinlogWriterAsync binlog_;
+      size_t event_size_;
+      size_t in_flight_;
+      double finish_at_{0};
+      double start_at_{0};
+      size_t pending_{0};
+      std::vector<double> latencies_;
+
+      void start_up() override {
+        binlog_.open().ensure();
+        start_at_ = td::Time::now();
+        finish_at_ = start_at_ + 1;
+        for (size_t i = 0; i < in_flight_; i++) {
+          write_event();
+        }
+      }
+      void write_event() {
+        binlog_.write_event(Event{event_size_}, nullptr).ensure();
+        pending_++;
+        binlog_.sync(td::promise_send_closure(actor_id(this), &Writer::on_synced, td::Time::now()));
+      }
+      void on_synced(double begin_at, td::Result<td::Unit> r_unit) {
+        r_unit.ensure();
+        pending_--;
+        auto now = td::Time::now();
+        latencies_.push_back(now - begin_at);
+        if (now < finish_at_) {
+          return write_event();
+        }
+        if (pending_ == 0) {
+          print_stats(now - start_at_);
+          binlog_.close(td::promise_send_closure(actor_id(this), &Writer::on_closed));
+        }
+      }
+      void on_closed(td::Result<td::Unit>) {
+        td::actor::SchedulerContext::get()->stop();
+        stop();
+      }
+      void print_stats(double passed) {
+        std::sort(latencies_.begin(), latencies_.end());
+        auto percentile = [&](double p) {
+          auto i = td::min(static_cast<size_t>(static_cast<double>(latencies_.size()) * p), latencies_.size() - 1);
+          return latencies_[i] * 1000;
+        };
+        auto syncs = binlog_.sync_count();
+        LOG(ERROR) << "in_flight=" << in_flight_ << "\tevents/s=" << static_cast<size_t>(latencies_.size() / passed)
+                   << "\tevents/sync=" << (syncs == 0 ? 0.0 : static_cast<double>(latencies_.size()) / syncs)
+                   << "\tp50=" << percentile(0.5) << "ms\tp99=" << percentile(0.99) << "ms\tmax=" << percentile(1)
+                   << "ms";
+      }
+    };
+    td::actor::create_actor<Writer>("Writer", path.str(), event_size, options, in_flight).release();
+  });
+  scheduler.run();
+  td::unlink(path).ignore();
+}
+
+void write_binlog_sync(td::CSlice path, size_t event_size) {
+  using Durability = td::StreamToFileActor::Durability;
+  for (auto durability : {Durability::Flush, Durability::DataSync, Durability::FullSync}) {
+    for (auto window : {0.0, 0.001}) {
+      LOG(ERROR) << "BinlogSync durability="
+                 << (durability == Durability::Flush ? "flush"
+                                                     : durability == Durability::DataSync ? "fdatasync" : "fsync")
+                 << " window=" << window * 1000 << "ms";
+      td::BinlogWriterAsync::Options options;
+      options.durability = durability;
+      options.immediate_sync_delay = window;
+      for (size_t in_flight : {1, 16, 256}) {
+        write_binlog_sync_once(path, event_size, options, in_flight);
+      }
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   std::string from;
   enum Type { Read, Write };
   Type type{Write};
-  enum Mode { Baseline, Buffered, Direct, Async, WriteV, Async2 };
+  enum Mode { Baseline, Buffered, Direct, Async, WriteV, Async2, BinlogSync };
   Mode mode = Baseline;
   size_t buffer_size = 1024;
 
@@ -624,6 +726,9 @@ int main(int argc, char **argv) {
       case 5:
         mode = Async2;
         return td::Status::OK();
+      case 6:
+        mode = BinlogSync;
+        return td::Status::OK();
     }
     return td::Status::Error("unknown mode");
   });
@@ -656,6 +761,7 @@ int main(int argc, char **argv) {
           break;
         case Async2:
         case WriteV:
+        case BinlogSync:
           LOG(FATAL) << "Not supported mode for Read test";
       }
       break;
@@ -676,6 +782,9 @@ int main(int argc, char **argv) {
         case Async2:
           write_async2(from, buffer_size);
           break;
+        case BinlogSync:
+          write_binlog_sync(from, buffer_size);
+          break;
         case Direct:
           LOG(FATAL) << "Unimplemented";
       }
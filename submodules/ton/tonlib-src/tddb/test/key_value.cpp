@@ -55,6 +55,17 @@ TEST(KeyValue, simple) {
   set_value(as_slice(x), as_slice(x));
   ensure_value(as_slice(x), as_slice(x));
 
+  std::vector<td::Slice> keys{"A", "B", as_slice(x)};
+  std::vector<std::string> values;
+  auto statuses = kv->get_multi(keys, values).move_as_ok();
+  ASSERT_EQ(3u, statuses.size());
+  ASSERT_EQ(3u, values.size());
+  ASSERT_EQ(td::int32(statuses[0]), td::int32(td::KeyValue::GetStatus::Ok));
+  ASSERT_EQ(values[0], "HELLO");
+  ASSERT_EQ(td::int32(statuses[1]), td::int32(td::KeyValue::GetStatus::NotFound));
+  ASSERT_EQ(td::int32(statuses[2]), td::int32(td::KeyValue::GetStatus::Ok));
+  ASSERT_EQ(values[2], as_slice(x));
+
   kv.reset();
   kv = std::make_unique<td::RocksDb>(td::RocksDb::open(db_name.str()).move_as_ok());
   ensure_value("A", "HELLO");
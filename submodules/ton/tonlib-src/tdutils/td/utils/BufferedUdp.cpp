@@ -24,6 +24,8 @@ namespace td {
 
 #if TD_PORT_POSIX
 TD_THREAD_LOCAL detail::UdpReader *BufferedUdp::udp_reader_;
+TD_THREAD_LOCAL detail::UdpReader *BufferedUdp::udp_gro_reader_;
+TD_THREAD_LOCAL detail::UdpWriter *BufferedUdp::udp_writer_;
 #endif
 
 }  // namespace td
@@ -35,48 +35,118 @@ namespace td {
 
 #if TD_PORT_POSIX
 namespace detail {
+// One for thread is enough
 class UdpWriter {
  public:
-  static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    std::array<UdpSocketFd::OutboundMessage, 16> messages;
+  Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
     auto to_send = queue.as_span();
-    size_t to_send_n = td::min(messages.size(), to_send.size());
-    to_send.truncate(to_send_n);
-    for (size_t i = 0; i < to_send_n; i++) {
-      messages[i].to = &to_send[i].address;
-      messages[i].data = to_send[i].data.as_slice();
+    size_t pos = 0;
+    size_t messages_n = 0;
+    size_t segments_n = 0;
+    while (messages_n < messages_.size() && pos < to_send.size()) {
+      size_t end = pos + 1;
+      if (fd.is_gso_enabled()) {
+        end = gso_batch_end(to_send, pos);
+      }
+
+      auto &message = messages_[messages_n];
+      message.to = &to_send[pos].address;
+      message.data = to_send[pos].data.as_slice();
+      message.segments = {};
+      if (end - pos > 1) {
+        for (size_t i = pos; i < end; i++) {
+          segments_[segments_n + i - pos] = to_send[i].data.as_slice();
+        }
+        message.segments = Span<Slice>(segments_.data() + segments_n, end - pos);
+        segments_n += end - pos;
+      }
+      counts_[messages_n] = end - pos;
+      messages_n++;
+      pos = end;
     }
 
     size_t cnt;
-    auto status = fd.send_messages(::td::Span<UdpSocketFd::OutboundMessage>(messages).truncate(to_send_n), cnt);
-    queue.pop_n(cnt);
+    auto status = fd.send_messages(Span<UdpSocketFd::OutboundMessage>(messages_).truncate(messages_n), cnt);
+    size_t sent_n = 0;
+    for (size_t i = 0; i < cnt; i++) {
+      sent_n += counts_[i];
+    }
+    queue.pop_n(sent_n);
     return status;
   }
+
+ private:
+  // bigger datagrams are sent one by one, because they may not fit into MTU of the route
+  enum : size_t { BUFFER_SIZE = 16, MAX_GSO_SEGMENT_SIZE = 1452 };
+  std::array<UdpSocketFd::OutboundMessage, BUFFER_SIZE> messages_;
+  std::array<size_t, BUFFER_SIZE> counts_;
+  std::array<Slice, BUFFER_SIZE * UdpSocketFd::MAX_GSO_SEGMENTS> segments_;
+
+  // consecutive datagrams to the same address of the same size, except the last one, which may be shorter
+  static size_t gso_batch_end(Span<UdpMessage> to_send, size_t pos) {
+    auto segment_size = to_send[pos].data.size();
+    if (segment_size == 0 || segment_size > MAX_GSO_SEGMENT_SIZE) {
+      return pos + 1;
+    }
+    auto total_size = segment_size;
+    size_t end = pos + 1;
+    while (end < to_send.size() && end - pos < UdpSocketFd::MAX_GSO_SEGMENTS &&
+           to_send[end].address == to_send[pos].address) {
+      auto size = to_send[end].data.size();
+      if (size == 0 || size > segment_size || total_size + size > UdpSocketFd::MAX_GSO_SIZE) {
+        break;
+      }
+      total_size += size;
+      end++;
+      if (size < segment_size) {
+        break;
+      }
+    }
+    return end;
+  }
 };
 
 class UdpReaderHelper {
  public:
+  void init(size_t max_packet_size, size_t reserved_size) {
+    max_packet_size_ = max_packet_size;
+    reserved_size_ = reserved_size;
+  }
+
   void init_inbound_message(UdpSocketFd::InboundMessage &message) {
     message.from = &message_.address;
     message.error = &message_.error;
-    if (buffer_.size() < MAX_PACKET_SIZE) {
-      buffer_ = BufferSlice(RESERVED_SIZE);
+    message.segment_size = 0;
+    if (buffer_.size() < max_packet_size_) {
+      buffer_ = BufferSlice(reserved_size_);
     }
-    CHECK(buffer_.size() >= MAX_PACKET_SIZE);
-    message.data = buffer_.as_slice().truncate(MAX_PACKET_SIZE);
+    CHECK(buffer_.size() >= max_packet_size_);
+    message.data = buffer_.as_slice().truncate(max_packet_size_);
   }
 
-  UdpMessage extract_udp_message(UdpSocketFd::InboundMessage &message) {
-    message_.data = buffer_.from_slice(message.data);
-    auto size = message_.data.size();
+  // datagrams coalesced by GRO share the buffer, so they are split without copying
+  void extract_udp_messages(UdpSocketFd::InboundMessage &message, VectorQueue<UdpMessage> &queue) {
+    if (message.segment_size == 0) {
+      message_.data = buffer_.from_slice(message.data);
+      queue.push(std::move(message_));
+    } else {
+      Slice data = message.data;
+      while (!data.empty()) {
+        auto size = td::min(data.size(), message.segment_size);
+        queue.push(UdpMessage{message_.address, buffer_.from_slice(data.substr(0, size)), Status::OK()});
+        data.remove_prefix(size);
+      }
+      message_ = UdpMessage();
+    }
+    auto size = message.data.size();
     size = (size + 7) & ~7;
-    CHECK(size <= MAX_PACKET_SIZE);
+    CHECK(size <= max_packet_size_);
     buffer_.confirm_read(size);
-    return std::move(message_);
   }
 
  private:
-  enum : size_t { MAX_PACKET_SIZE = 2048, RESERVED_SIZE = MAX_PACKET_SIZE * 8 };
+  size_t max_packet_size_{0};
+  size_t reserved_size_{0};
   UdpMessage message_;
   BufferSlice buffer_;
 };
@@ -84,23 +154,25 @@ class UdpReaderHelper {
 // One for thread is enough
 class UdpReader {
  public:
-  UdpReader() {
+  explicit UdpReader(size_t max_packet_size = MAX_PACKET_SIZE, size_t reserved_size = RESERVED_SIZE)
+      : max_packet_size_(max_packet_size) {
     for (size_t i = 0; i < messages_.size(); i++) {
+      helpers_[i].init(max_packet_size, reserved_size);
       helpers_[i].init_inbound_message(messages_[i]);
     }
   }
   Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
     for (size_t i = 0; i < messages_.size(); i++) {
-      CHECK(messages_[i].data.size() == 2048);
+      CHECK(messages_[i].data.size() == max_packet_size_);
     }
     size_t cnt = 0;
     auto status = fd.receive_messages(messages_, cnt);
     for (size_t i = 0; i < cnt; i++) {
-      queue.push(helpers_[i].extract_udp_message(messages_[i]));
+      helpers_[i].extract_udp_messages(messages_[i], queue);
       helpers_[i].init_inbound_message(messages_[i]);
     }
     for (size_t i = cnt; i < messages_.size(); i++) {
-      LOG_CHECK(messages_[i].data.size() == 2048)
+      LOG_CHECK(messages_[i].data.size() == max_packet_size_)
           << " cnt = " << cnt << " i = " << i << " size = " << messages_[i].data.size() << " status = " << status;
     }
     if (status.is_error() && !UdpSocketFd::is_critical_read_error(status)) {
@@ -109,8 +181,12 @@ class UdpReader {
     return status;
   }
 
+  // GRO may coalesce up to 64KB of datagrams into one message
+  enum : size_t { GRO_MAX_PACKET_SIZE = 1 << 16, GRO_RESERVED_SIZE = GRO_MAX_PACKET_SIZE * 2 };
+
  private:
-  enum : size_t { BUFFER_SIZE = 16 };
+  enum : size_t { BUFFER_SIZE = 16, MAX_PACKET_SIZE = 2048, RESERVED_SIZE = MAX_PACKET_SIZE * 8 };
+  size_t max_packet_size_;
   std::array<UdpSocketFd::InboundMessage, BUFFER_SIZE> messages_;
   std::array<UdpReaderHelper, BUFFER_SIZE> helpers_;
 };
@@ -146,6 +222,17 @@ class BufferedUdp : public UdpSocketFd {
     }
     return status;
   }
+
+  // number of receive_messages/send_messages calls and of datagrams they have transferred
+  struct Stats {
+    uint64 receive_calls{0};
+    uint64 received_messages{0};
+    uint64 send_calls{0};
+    uint64 sent_messages{0};
+  };
+  const Stats &get_stats() const {
+    return stats_;
+  }
 #endif
 
   UdpSocketFd move_as_udp_socket_fd() {
@@ -160,6 +247,7 @@ class BufferedUdp : public UdpSocketFd {
 #if TD_PORT_POSIX
   VectorQueue<UdpMessage> input_;
   VectorQueue<UdpMessage> output_;
+  Stats stats_;
 
   VectorQueue<UdpMessage> &input() {
     return input_;
@@ -169,15 +257,33 @@ class BufferedUdp : public UdpSocketFd {
   }
 
   Status flush_send_once() TD_WARN_UNUSED_RESULT {
-    return detail::UdpWriter::write_once(as_fd(), output_);
+    init_thread_local<detail::UdpWriter>(udp_writer_);
+    auto old_size = output_.size();
+    auto status = udp_writer_->write_once(as_fd(), output_);
+    stats_.send_calls++;
+    stats_.sent_messages += old_size - output_.size();
+    return status;
   }
 
   Status flush_read_once() TD_WARN_UNUSED_RESULT {
-    init_thread_local<detail::UdpReader>(udp_reader_);
-    return udp_reader_->read_once(as_fd(), input_);
+    auto old_size = input_.size();
+    Status status;
+    if (is_gro_enabled()) {
+      init_thread_local<detail::UdpReader>(udp_gro_reader_, detail::UdpReader::GRO_MAX_PACKET_SIZE,
+                                           detail::UdpReader::GRO_RESERVED_SIZE);
+      status = udp_gro_reader_->read_once(as_fd(), input_);
+    } else {
+      init_thread_local<detail::UdpReader>(udp_reader_);
+      status = udp_reader_->read_once(as_fd(), input_);
+    }
+    stats_.receive_calls++;
+    stats_.received_messages += input_.size() - old_size;
+    return status;
   }
 
   static TD_THREAD_LOCAL detail::UdpReader *udp_reader_;
+  static TD_THREAD_LOCAL detail::UdpReader *udp_gro_reader_;
+  static TD_THREAD_LOCAL detail::UdpWriter *udp_writer_;
 #endif
 };
 
@@ -112,6 +112,10 @@ class SharedPtr {
       raw_->inc();
     }
   }
+  // takes ownership of a reference previously given away by release()
+  struct acquire_t {};
+  SharedPtr(acquire_t, Raw *raw) : raw_(raw) {
+  }
   SharedPtr(const SharedPtr &other) : SharedPtr(other.raw_) {
   }
   SharedPtr &operator=(const SharedPtr &other) {
@@ -0,0 +1,125 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/misc.h"
+
+#include <array>
+#include <atomic>
+
+namespace td {
+// Bounded single producer queue for work stealing
+// Only the owner may push and pop, any other thread may steal half of the queue into its own empty queue
+// T must be trivially copyable, usually it is a raw pointer
+template <class T, size_t N = 256>
+class StealingQueue {
+ public:
+  static_assert(N > 1 && (N & (N - 1)) == 0, "N must be a power of two");
+
+  // Returns true if the queue was empty before the push
+  // If the queue is full, half of it and the value are passed to overflow_f
+  template <class F>
+  bool local_push(T value, F &&overflow_f) {
+    while (true) {
+      auto tail = tail_.load(std::memory_order_relaxed);
+      auto head = head_.load(std::memory_order_acquire);
+
+      if (static_cast<size_t>(tail - head) < N) {
+        buf_[tail & Mask].store(value, std::memory_order_relaxed);
+        tail_.store(tail + 1, std::memory_order_release);
+        return tail == head;
+      }
+
+      auto n = N / 2;
+      if (!head_.compare_exchange_strong(head, head + n, std::memory_order_acq_rel)) {
+        continue;
+      }
+      for (size_t i = 0; i < n; i++) {
+        overflow_f(buf_[(head + i) & Mask].load(std::memory_order_relaxed));
+      }
+      overflow_f(value);
+      return false;
+    }
+  }
+
+  // Fails only if the queue is empty
+  bool local_pop(T &value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+    while (head < tail) {
+      value = buf_[head & Mask].load(std::memory_order_relaxed);
+      // on failure head is reloaded, some values were stolen
+      if (head_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Moves half of other queue into this one and pops one value from it
+  // Must be called by the owner of this queue and only when it is empty
+  bool steal(T &value, StealingQueue &other) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+    if (head != tail) {
+      return false;
+    }
+
+    while (true) {
+      auto other_head = other.head_.load(std::memory_order_acquire);
+      auto other_tail = other.tail_.load(std::memory_order_acquire);
+      if (other_tail <= other_head) {
+        return false;
+      }
+      auto n = static_cast<size_t>(other_tail - other_head);
+      if (n > N) {
+        // inconsistent snapshot, head has moved after it was read
+        continue;
+      }
+      n -= n / 2;
+
+      for (size_t i = 0; i < n; i++) {
+        buf_[(tail + i) & Mask].store(other.buf_[(other_head + i) & Mask].load(std::memory_order_relaxed),
+                                      std::memory_order_relaxed);
+      }
+      if (!other.head_.compare_exchange_strong(other_head, other_head + n, std::memory_order_acq_rel)) {
+        continue;
+      }
+
+      n--;
+      value = buf_[(tail + n) & Mask].load(std::memory_order_relaxed);
+      tail_.store(tail + n, std::memory_order_release);
+      return true;
+    }
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t Mask = N - 1;
+  std::atomic<int64> head_{0};
+  char pad_[TD_CONCURRENCY_PAD - sizeof(std::atomic<int64>)];
+  std::atomic<int64> tail_{0};
+  std::array<std::atomic<T>, N> buf_;
+};
+
+}  // namespace td
@@ -39,6 +39,13 @@ class StringBuilder {
     error_flag_ = false;
   }
 
+  void pop_back() {
+    if (current_ptr_ == begin_ptr_) {
+      std::abort();  // shouldn't happen
+    }
+    current_ptr_--;
+  }
+
   MutableCSlice as_cslice() {
     if (current_ptr_ >= end_ptr_ + reserved_size) {
       std::abort();  // shouldn't happen
@@ -311,41 +311,40 @@ void AesCbcState::decrypt(Slice from, MutableSlice to) {
   ::td::aes_cbc_decrypt(key_.as_slice(), iv_.as_mutable_slice(), from, to);
 }
 
+// EVP uses AES-NI when it is available
 class AesCtrState::Impl {
  public:
   Impl(Slice key, Slice iv) {
     CHECK(key.size() == 32);
     CHECK(iv.size() == 16);
-    static_assert(AES_BLOCK_SIZE == 16, "");
-    if (AES_set_encrypt_key(key.ubegin(), 256, &aes_key) < 0) {
+    ctx_ = EVP_CIPHER_CTX_new();
+    LOG_IF(FATAL, ctx_ == nullptr) << "Failed to create EVP_CIPHER_CTX";
+    if (EVP_EncryptInit_ex(ctx_, EVP_aes_256_ctr(), nullptr, key.ubegin(), iv.ubegin()) != 1) {
       LOG(FATAL) << "Failed to set encrypt key";
     }
-    counter.as_mutable_slice().copy_from(as_slice(iv));
-    current_pos = 0;
+  }
+  Impl(const Impl &from) = delete;
+  Impl &operator=(const Impl &from) = delete;
+  ~Impl() {
+    EVP_CIPHER_CTX_free(ctx_);
   }
 
   void encrypt(Slice from, MutableSlice to) {
     CHECK(to.size() >= from.size());
-    for (size_t i = 0; i < from.size(); i++) {
-      if (current_pos == 0) {
-        AES_encrypt(counter.as_slice().ubegin(), encrypted_counter.as_mutable_slice().ubegin(), &aes_key);
-        uint8 *ptr = counter.as_mutable_slice().ubegin();
-        for (int j = 15; j >= 0; j--) {
-          if (++ptr[j] != 0) {
-            break;
-          }
-        }
+    while (!from.empty()) {
+      int size = static_cast<int>(min(from.size(), static_cast<size_t>(1 << 30)));
+      int out_size = 0;
+      if (EVP_EncryptUpdate(ctx_, to.ubegin(), &out_size, from.ubegin(), size) != 1) {
+        LOG(FATAL) << "Failed to encrypt";
       }
-      to[i] = static_cast<char>(from[i] ^ encrypted_counter[current_pos]);
-      current_pos = (current_pos + 1) & 15;
+      CHECK(out_size == size);
+      from.remove_prefix(size);
+      to.remove_prefix(size);
     }
   }
 
  private:
-  AES_KEY aes_key;
-  SecureString counter{AES_BLOCK_SIZE};
-  SecureString encrypted_counter{AES_BLOCK_SIZE};
-  uint8 current_pos;
+  EVP_CIPHER_CTX *ctx_;
 };
 
 AesCtrState::AesCtrState() = default;
@@ -50,6 +50,7 @@ class AesCtrState {
 
   void init(Slice key, Slice iv);
 
+  // from and to may be the same slice
   void encrypt(Slice from, MutableSlice to);
 
   void decrypt(Slice from, MutableSlice to);
@@ -71,6 +71,9 @@ class FileFd {
 
   Status sync() TD_WARN_UNUSED_RESULT;
 
+  // like sync, but doesn't flush metadata, which isn't needed to read the data back, e.g. modification time
+  Status sync_data() TD_WARN_UNUSED_RESULT;
+
   Status seek(int64 position) TD_WARN_UNUSED_RESULT;
 
   Status truncate_to_current_position(int64 current_position) TD_WARN_UNUSED_RESULT;
@@ -36,12 +36,24 @@
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #if TD_LINUX
 #include <linux/errqueue.h>
+
+// may be missing in old libc headers, the kernel will reject them if they aren't supported
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
 #endif
 #endif  // TD_PORT_POSIX
 
@@ -396,6 +408,7 @@ class UdpSocketReceiveHelper {
   }
 
   void from_native(struct msghdr &message_header, size_t message_size, UdpSocketFd::InboundMessage &message) {
+    message.segment_size = 0;
 #if TD_LINUX
     struct cmsghdr *cmsg;
     struct sock_extended_err *ee = nullptr;
@@ -407,6 +420,12 @@ class UdpSocketReceiveHelper {
       } else if ((cmsg->cmsg_type == IP_RECVERR && cmsg->cmsg_level == IPPROTO_IP) ||
                  (cmsg->cmsg_type == IPV6_RECVERR && cmsg->cmsg_level == IPPROTO_IPV6)) {
         ee = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+      } else if (cmsg->cmsg_type == UDP_GRO && cmsg->cmsg_level == SOL_UDP) {
+        int segment_size;
+        std::memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+        message.segment_size = segment_size > 0 && static_cast<size_t>(segment_size) < message_size
+                                   ? static_cast<size_t>(segment_size)
+                                   : 0;
       }
     }
     if (ee != nullptr) {
@@ -437,6 +456,7 @@ class UdpSocketReceiveHelper {
         *message.error = Status::Error(501, "message too long");
       }
       message.data.truncate(0);
+      message.segment_size = 0;
       return;
     }
     CHECK(message_size <= message.data.size());
@@ -456,18 +476,44 @@ class UdpSocketSendHelper {
     CHECK(message.to != nullptr && message.to->is_valid());
     message_header.msg_name = const_cast<struct sockaddr *>(message.to->get_sockaddr());
     message_header.msg_namelen = narrow_cast<socklen_t>(message.to->get_sockaddr_len());
-    io_vec_.iov_base = const_cast<char *>(message.data.begin());
-    io_vec_.iov_len = message.data.size();
-    message_header.msg_iov = &io_vec_;
-    message_header.msg_iovlen = 1;
-    //TODO
-    message_header.msg_control = nullptr;
-    message_header.msg_controllen = 0;
     message_header.msg_flags = 0;
+    if (message.segments.empty()) {
+      io_vec_[0].iov_base = const_cast<char *>(message.data.begin());
+      io_vec_[0].iov_len = message.data.size();
+      message_header.msg_iov = io_vec_.data();
+      message_header.msg_iovlen = 1;
+      //TODO
+      message_header.msg_control = nullptr;
+      message_header.msg_controllen = 0;
+      return;
+    }
+
+#if TD_LINUX
+    CHECK(message.segments.size() <= io_vec_.size());
+    for (size_t i = 0; i < message.segments.size(); i++) {
+      io_vec_[i].iov_base = const_cast<char *>(message.segments[i].begin());
+      io_vec_[i].iov_len = message.segments[i].size();
+    }
+    message_header.msg_iov = io_vec_.data();
+    message_header.msg_iovlen = message.segments.size();
+
+    std::memset(control_buf_.data(), 0, control_buf_.size());
+    message_header.msg_control = control_buf_.data();
+    message_header.msg_controllen = narrow_cast<decltype(message_header.msg_controllen)>(control_buf_.size());
+    auto *cmsg = CMSG_FIRSTHDR(&message_header);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16));
+    auto segment_size = narrow_cast<uint16>(message.segments[0].size());
+    std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+#else
+    UNREACHABLE();
+#endif
   }
 
  private:
-  struct iovec io_vec_;
+  std::array<struct iovec, UdpSocketFd::MAX_GSO_SEGMENTS> io_vec_;
+  alignas(struct cmsghdr) std::array<char, CMSG_SPACE(sizeof(uint16))> control_buf_;
 };
 
 class UdpSocketFdImpl {
@@ -484,6 +530,37 @@ class UdpSocketFdImpl {
   const NativeFd &get_native_fd() const {
     return info_.native_fd();
   }
+  Status enable_gso() {
+#if TD_LINUX
+    int segment_size = 0;  // the size is passed with each message
+    if (setsockopt(get_native_fd().socket(), SOL_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) != 0) {
+      return OS_SOCKET_ERROR("Failed to enable UDP GSO");
+    }
+    is_gso_enabled_ = true;
+    return Status::OK();
+#else
+    return Status::Error("UDP GSO is not supported");
+#endif
+  }
+  Status enable_gro() {
+#if TD_LINUX
+    int flag = 1;
+    if (setsockopt(get_native_fd().socket(), SOL_UDP, UDP_GRO, &flag, sizeof(flag)) != 0) {
+      return OS_SOCKET_ERROR("Failed to enable UDP GRO");
+    }
+    is_gro_enabled_ = true;
+    return Status::OK();
+#else
+    return Status::Error("UDP GRO is not supported");
+#endif
+  }
+  bool is_gso_enabled() const {
+    return is_gso_enabled_;
+  }
+  bool is_gro_enabled() const {
+    return is_gro_enabled_;
+  }
+
   Status get_pending_error() {
     if (!get_poll_info().get_flags().has_pending_error()) {
       return Status::OK();
@@ -568,8 +645,21 @@ class UdpSocketFdImpl {
       is_sent = true;
       return Status::OK();
     }
+    if (disable_gso_on_error(sendmsg_errno, message)) {
+      return Status::OK();
+    }
     return process_sendmsg_error(sendmsg_errno, is_sent);
   }
+  // The route may not support GSO even if the socket does (EIO), or have MTU less than the segment size (EINVAL).
+  // The message is left unsent to be split by the caller
+  bool disable_gso_on_error(int sendmsg_errno, const UdpSocketFd::OutboundMessage &message) {
+    if ((sendmsg_errno != EIO && sendmsg_errno != EINVAL) || message.segments.empty()) {
+      return false;
+    }
+    LOG(WARNING) << "Disable UDP GSO for " << get_native_fd() << " after " << Status::PosixError(sendmsg_errno, "");
+    is_gso_enabled_ = false;
+    return true;
+  }
   Status process_sendmsg_error(int sendmsg_errno, bool &is_sent) {
     if (sendmsg_errno == EAGAIN
 #if EAGAIN != EWOULDBLOCK
@@ -643,15 +733,20 @@ class UdpSocketFdImpl {
 
  private:
   PollableFdInfo info_;
+  bool is_gso_enabled_{false};
+  bool is_gro_enabled_{false};
 
   Status send_messages_slow(Span<UdpSocketFd::OutboundMessage> messages, size_t &cnt) {
     cnt = 0;
     for (auto &message : messages) {
-      CHECK(!message.data.empty());
+      CHECK(!message.data.empty() || !message.segments.empty());
       bool is_sent;
       auto error = send_message(message, is_sent);
       cnt += is_sent;
       TRY_STATUS(std::move(error));
+      if (!is_sent) {
+        break;
+      }
     }
     return Status::OK();
   }
@@ -678,6 +773,10 @@ class UdpSocketFdImpl {
       cnt = sendmmsg_res;
       return Status::OK();
     }
+    if (disable_gso_on_error(sendmmsg_errno, messages[0])) {
+      cnt = 0;
+      return Status::OK();
+    }
 
     bool is_sent = false;
     auto status = process_sendmsg_error(sendmmsg_errno, is_sent);
@@ -845,6 +944,19 @@ Status UdpSocketFd::receive_message(InboundMessage &message, bool &is_received)
   return impl_->receive_message(message, is_received);
 }
 
+Status UdpSocketFd::enable_gso() {
+  return impl_->enable_gso();
+}
+Status UdpSocketFd::enable_gro() {
+  return impl_->enable_gro();
+}
+bool UdpSocketFd::is_gso_enabled() const {
+  return impl_->is_gso_enabled();
+}
+bool UdpSocketFd::is_gro_enabled() const {
+  return impl_->is_gro_enabled();
+}
+
 Status UdpSocketFd::send_messages(Span<OutboundMessage> messages, size_t &count) {
   return impl_->send_messages(messages, count);
 }
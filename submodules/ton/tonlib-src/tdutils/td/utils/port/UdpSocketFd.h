@@ -72,14 +72,27 @@ class UdpSocketFd {
   static bool is_critical_read_error(const Status &status);
 
 #if TD_PORT_POSIX
+  // Linux UDP segmentation offload. With GSO enabled a single OutboundMessage may carry several datagrams,
+  // with GRO enabled the kernel may return several coalesced datagrams in a single InboundMessage
+  enum : size_t { MAX_GSO_SEGMENTS = 64, MAX_GSO_SIZE = 65000 };
+  Status enable_gso() TD_WARN_UNUSED_RESULT;
+  Status enable_gro() TD_WARN_UNUSED_RESULT;
+  bool is_gso_enabled() const;
+  bool is_gro_enabled() const;
+
   struct OutboundMessage {
     const IPAddress *to;
     Slice data;
+    // if not empty, the datagrams to be sent with GSO instead of data; all of them except the last one
+    // must have the same size
+    Span<Slice> segments;
   };
   struct InboundMessage {
     IPAddress *from;
     MutableSlice data;
     Status *error;
+    // size of each of the datagrams coalesced by GRO into data, or 0 if data is a single datagram
+    size_t segment_size;
   };
 
   Status send_message(const OutboundMessage &message, bool &is_sent) TD_WARN_UNUSED_RESULT;
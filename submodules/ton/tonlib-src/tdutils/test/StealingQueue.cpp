@@ -0,0 +1,119 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#include "td/utils/common.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/StealingQueue.h"
+#include "td/utils/tests.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+TEST(StealingQueue, simple) {
+  td::StealingQueue<int, 8> q;
+  std::vector<int> overflow;
+  auto to_overflow = [&](int x) { overflow.push_back(x); };
+  for (int i = 0; i < 8; i++) {
+    CHECK(q.local_push(i, to_overflow) == (i == 0));
+  }
+  CHECK(overflow.empty());
+  CHECK(!q.local_push(8, to_overflow));
+  CHECK(overflow == std::vector<int>({0, 1, 2, 3, 8}));
+  for (int i = 4; i < 8; i++) {
+    int x;
+    CHECK(q.local_pop(x));
+    CHECK(x == i);
+  }
+  int x;
+  CHECK(!q.local_pop(x));
+  CHECK(q.empty());
+
+  td::StealingQueue<int, 8> other;
+  for (int i = 0; i < 6; i++) {
+    q.local_push(i, to_overflow);
+  }
+  CHECK(other.steal(x, q));
+  CHECK(x == 2);
+  for (int i : {0, 1}) {
+    CHECK(other.local_pop(x));
+    CHECK(x == i);
+  }
+  CHECK(!other.local_pop(x));
+  CHECK(!q.steal(x, other));
+  for (int i : {3, 4, 5}) {
+    CHECK(q.local_pop(x));
+    CHECK(x == i);
+  }
+}
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(StealingQueue, stress) {
+  constexpr size_t threads_n = 4;
+  int values_n = 1 << 20;
+  std::array<td::StealingQueue<int>, threads_n> queues;
+  std::array<td::int64, threads_n> sums{};
+  std::atomic<int> left{values_n};
+
+  std::mutex overflow_mutex;
+  td::int64 overflow_sum = 0;
+  auto to_overflow = [&](int value) {
+    std::lock_guard<std::mutex> guard(overflow_mutex);
+    overflow_sum += value;
+    left--;
+  };
+
+  std::vector<td::thread> threads;
+  for (size_t id = 0; id < threads_n; id++) {
+    threads.push_back(td::thread([&, id] {
+      auto &queue = queues[id];
+      auto consume = [&] {
+        int value;
+        bool ok = queue.local_pop(value);
+        for (size_t i = 1; !ok && i < threads_n; i++) {
+          ok = queue.steal(value, queues[(id + i) % threads_n]);
+        }
+        if (ok) {
+          sums[id] += value;
+          left--;
+        }
+      };
+      if (id == 0) {
+        for (int value = 1; value <= values_n; value++) {
+          queue.local_push(value, to_overflow);
+          if (value % 4 == 0) {
+            consume();
+          }
+        }
+      }
+      while (left.load() > 0) {
+        consume();
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  td::int64 sum = overflow_sum;
+  for (auto thread_sum : sums) {
+    sum += thread_sum;
+  }
+  ASSERT_EQ(static_cast<td::int64>(values_n) * (values_n + 1) / 2, sum);
+}
+#endif  //!TD_THREAD_UNSUPPORTED
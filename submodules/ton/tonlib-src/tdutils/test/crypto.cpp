@@ -21,6 +21,7 @@
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/logging.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/tests.h"
 #include "td/utils/UInt.h"
@@ -76,6 +77,57 @@ TEST(Crypto, AesCtrState) {
   }
 }
 
+TEST(Crypto, AesCtrStateStream) {
+  td::UInt256 key;
+  td::Random::secure_bytes(as_slice(key));
+  td::UInt128 iv;
+  td::Random::secure_bytes(as_slice(iv));
+  for (auto &s : strings) {
+    td::AesCtrState state;
+    state.init(as_slice(key), as_slice(iv));
+    td::string baseline(s.size(), '\0');
+    state.encrypt(s, baseline);
+
+    // the state must continue from the middle of a block, and encryption in place must give the same result
+    state.init(as_slice(key), as_slice(iv));
+    td::string result;
+    for (auto &x : td::rand_split(s)) {
+      state.encrypt(x, x);
+      result += x;
+    }
+    ASSERT_EQ(baseline, result);
+  }
+}
+
+class AesCtrBench : public td::Benchmark {
+ public:
+  explicit AesCtrBench(size_t size) : data_(size, 'a') {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "AES-CTR in place, " << data_.size() << " bytes";
+  }
+  void start_up() override {
+    td::UInt256 key{};
+    td::UInt128 iv{};
+    state_.init(as_slice(key), as_slice(iv));
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      state_.encrypt(data_, data_);
+    }
+  }
+
+ private:
+  td::string data_;
+  td::AesCtrState state_;
+};
+
+TEST(Crypto, AesCtrStateBench) {
+  for (size_t size : {64, 1024, 65536}) {
+    td::bench(AesCtrBench(size));
+  }
+}
+
 TEST(Crypto, Sha256State) {
   for (auto length : {0, 1, 31, 32, 33, 9999, 10000, 10001, 999999, 1000001}) {
     auto s = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
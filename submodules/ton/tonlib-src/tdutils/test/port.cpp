@@ -16,16 +16,20 @@
 
     Copyright 2017-2019 Telegram Systems LLP
 */
+#include "td/utils/benchmark.h"
+#include "td/utils/BufferedUdp.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
+#include "td/utils/port/IPAddress.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Time.h"
 #include "td/utils/tests.h"
 
 using namespace td;
@@ -134,6 +138,228 @@ TEST(Port, Writev) {
   ASSERT_EQ(expected_content, content);
 }
 
+#if TD_PORT_POSIX
+namespace {
+enum class UdpMode { Single, Batch, Gso, GsoGro };
+
+Slice udp_mode_name(UdpMode mode) {
+  switch (mode) {
+    case UdpMode::Single:
+      return "single";
+    case UdpMode::Batch:
+      return "mmsg";
+    case UdpMode::Gso:
+      return "mmsg+gso";
+    case UdpMode::GsoGro:
+      return "mmsg+gso+gro";
+  }
+  UNREACHABLE();
+  return "";
+}
+
+class UdpLoopback {
+ public:
+  static Result<UdpLoopback> create(UdpMode mode, int port) {
+    UdpLoopback res;
+    res.mode_ = mode;
+    TRY_STATUS(res.to_.init_ipv4_port("127.0.0.1", port + 1));
+    IPAddress from;
+    TRY_STATUS(from.init_ipv4_port("127.0.0.1", port));
+    TRY_RESULT(from_fd, UdpSocketFd::open(from));
+    TRY_RESULT(to_fd, UdpSocketFd::open(res.to_));
+    to_fd.maximize_rcv_buffer().ignore();
+    if (mode == UdpMode::Gso || mode == UdpMode::GsoGro) {
+      TRY_STATUS(from_fd.enable_gso());
+    }
+    if (mode == UdpMode::GsoGro) {
+      TRY_STATUS(to_fd.enable_gro());
+    }
+    res.sender_ = std::make_unique<BufferedUdp>(std::move(from_fd));
+    res.receiver_ = std::make_unique<BufferedUdp>(std::move(to_fd));
+    return std::move(res);
+  }
+
+  void send(BufferSlice data) {
+    if (mode_ == UdpMode::Single) {
+      UdpSocketFd::OutboundMessage message;
+      message.to = &to_;
+      message.data = data.as_slice();
+      bool is_sent = false;
+      while (!is_sent) {
+        sender_->send_message(message, is_sent).ensure();
+      }
+      single_send_calls_++;
+      return;
+    }
+    sender_->send(UdpMessage{to_, std::move(data), Status::OK()});
+  }
+
+  void flush_send() {
+    while (true) {
+      sender_->get_poll_info().add_flags(PollFlags::Write());
+      sender_->flush_send().ensure();
+      if (sender_->get_stats().sent_messages == sent_n_) {
+        break;
+      }
+    }
+  }
+
+  std::vector<BufferSlice> receive(size_t n) {
+    std::vector<BufferSlice> res;
+    auto timeout = Timestamp::in(10);
+    std::array<char, 2048> buf;
+    while (res.size() < n && !timeout.is_in_past()) {
+      receiver_->get_poll_info().add_flags(PollFlags::Read());
+      if (mode_ == UdpMode::Single) {
+        UdpSocketFd::InboundMessage message;
+        IPAddress from;
+        Status error;
+        message.from = &from;
+        message.error = &error;
+        message.data = MutableSlice(buf.data(), buf.size());
+        bool is_received = false;
+        receiver_->receive_message(message, is_received).ensure();
+        single_receive_calls_++;
+        if (is_received) {
+          error.ensure();
+          res.emplace_back(message.data);
+        }
+        continue;
+      }
+      auto r_message = receiver_->receive();
+      r_message.ensure();
+      if (r_message.ok()) {
+        auto message = r_message.move_as_ok().unwrap();
+        message.error.ensure();
+        res.push_back(std::move(message.data));
+      }
+    }
+    return res;
+  }
+
+  void count_sent(size_t n) {
+    sent_n_ += n;
+  }
+
+  // syscalls per datagram on the sending and on the receiving side
+  std::pair<double, double> syscalls_per_packet() const {
+    if (mode_ == UdpMode::Single) {
+      return {1.0, static_cast<double>(single_receive_calls_) / static_cast<double>(single_send_calls_)};
+    }
+    auto &send_stats = sender_->get_stats();
+    auto &receive_stats = receiver_->get_stats();
+    return {static_cast<double>(send_stats.send_calls) / static_cast<double>(send_stats.sent_messages),
+            static_cast<double>(receive_stats.receive_calls) / static_cast<double>(receive_stats.received_messages)};
+  }
+
+ private:
+  UdpMode mode_{UdpMode::Batch};
+  IPAddress to_;
+  std::unique_ptr<BufferedUdp> sender_;
+  std::unique_ptr<BufferedUdp> receiver_;
+  uint64 sent_n_{0};
+  uint64 single_send_calls_{0};
+  uint64 single_receive_calls_{0};
+};
+
+BufferSlice udp_test_datagram(size_t i, size_t size) {
+  BufferSlice res(size);
+  for (size_t j = 0; j < size; j++) {
+    res.as_slice()[j] = static_cast<char>('a' + (i + j) % 26);
+  }
+  return res;
+}
+}  // namespace
+
+TEST(Port, BufferedUdp) {
+  int port = 35000;
+  for (auto mode : {UdpMode::Single, UdpMode::Batch, UdpMode::Gso, UdpMode::GsoGro}) {
+    port += 2;
+    auto r_loopback = UdpLoopback::create(mode, port);
+    if (r_loopback.is_error()) {
+      LOG(ERROR) << "Skip " << udp_mode_name(mode) << ": " << r_loopback.error();
+      continue;
+    }
+    auto loopback = r_loopback.move_as_ok();
+    size_t sent = 0;
+    for (int round = 0; round < 20; round++) {
+      // datagrams of the same size, with a shorter one at the end, so that GSO can batch them
+      const size_t n = 50;
+      for (size_t i = 0; i < n; i++) {
+        loopback.send(udp_test_datagram(sent + i, i + 1 == n ? 100 : 1000));
+      }
+      loopback.count_sent(n);
+      if (mode != UdpMode::Single) {
+        loopback.flush_send();
+      }
+      auto received = loopback.receive(n);
+      ASSERT_EQ(n, received.size());
+      for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(udp_test_datagram(sent + i, i + 1 == n ? 100 : 1000).as_slice(), received[i].as_slice());
+      }
+      sent += n;
+    }
+    auto syscalls = loopback.syscalls_per_packet();
+    LOG(INFO) << udp_mode_name(mode) << ": syscalls per packet " << syscalls.first << " (send) " << syscalls.second
+              << " (receive)";
+  }
+}
+
+class BufferedUdpBench : public Benchmark {
+ public:
+  BufferedUdpBench(UdpMode mode, int port) : mode_(mode), port_(port) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "UDP loopback " << udp_mode_name(mode_);
+  }
+  void start_up() override {
+    loopback_ = std::make_unique<UdpLoopback>(UdpLoopback::create(mode_, port_).move_as_ok());
+  }
+  void tear_down() override {
+    syscalls_ = loopback_->syscalls_per_packet();
+    loopback_.reset();
+  }
+  std::pair<double, double> syscalls_per_packet() const {
+    return syscalls_;
+  }
+  void run(int n) override {
+    const int batch = 64;
+    for (int i = 0; i < n; i += batch) {
+      auto to_send = td::min(batch, n - i);
+      for (int j = 0; j < to_send; j++) {
+        loopback_->send(BufferSlice(1000));
+      }
+      loopback_->count_sent(to_send);
+      if (mode_ != UdpMode::Single) {
+        loopback_->flush_send();
+      }
+      CHECK(loopback_->receive(to_send).size() == static_cast<size_t>(to_send));
+    }
+  }
+
+ private:
+  UdpMode mode_;
+  int port_;
+  std::unique_ptr<UdpLoopback> loopback_;
+  std::pair<double, double> syscalls_;
+};
+
+TEST(Port, BenchBufferedUdp) {
+  int port = 35100;
+  for (auto mode : {UdpMode::Single, UdpMode::Batch, UdpMode::Gso, UdpMode::GsoGro}) {
+    port += 2;
+    if (UdpLoopback::create(mode, port).is_error()) {
+      continue;
+    }
+    BufferedUdpBench benchmark(mode, port);
+    bench(benchmark);
+    auto syscalls = benchmark.syscalls_per_packet();
+    LOG(ERROR) << benchmark.get_description() << ": syscalls per packet " << syscalls.first << " (send) "
+               << syscalls.second << " (receive)";
+  }
+}
+#endif
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 #include <signal.h>
 #include <sys/syscall.h>
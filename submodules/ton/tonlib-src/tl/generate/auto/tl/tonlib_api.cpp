@@ -523,6 +523,27 @@ void updateSyncState::store(td::TlStorerToString &s, const char *field_name) con
   }
 }
 
+updateRawTransactions::updateRawTransactions()
+  : account_address_()
+  , transactions_()
+{}
+
+updateRawTransactions::updateRawTransactions(object_ptr<accountAddress> &&account_address_, object_ptr<raw_transactions> &&transactions_)
+  : account_address_(std::move(account_address_))
+  , transactions_(std::move(transactions_))
+{}
+
+const std::int32_t updateRawTransactions::ID;
+
+void updateRawTransactions::store(td::TlStorerToString &s, const char *field_name) const {
+  if (!LOG_IS_STRIPPED(ERROR)) {
+    s.store_class_begin(field_name, "updateRawTransactions");
+    if (account_address_ == nullptr) { s.store_field("account_address", "null"); } else { account_address_->store(s, "account_address"); }
+    if (transactions_ == nullptr) { s.store_field("transactions", "null"); } else { transactions_->store(s, "transactions"); }
+    s.store_class_end();
+  }
+}
+
 generic_accountStateRaw::generic_accountStateRaw()
   : account_state_()
 {}
@@ -2041,6 +2062,30 @@ void raw_getAccountState::store(td::TlStorerToString &s, const char *field_name)
   }
 }
 
+raw_getTransactionHistory::raw_getTransactionHistory()
+  : account_address_()
+  , from_transaction_id_()
+  , limit_()
+{}
+
+raw_getTransactionHistory::raw_getTransactionHistory(object_ptr<accountAddress> &&account_address_, object_ptr<internal_transactionId> &&from_transaction_id_, std::int32_t limit_)
+  : account_address_(std::move(account_address_))
+  , from_transaction_id_(std::move(from_transaction_id_))
+  , limit_(limit_)
+{}
+
+const std::int32_t raw_getTransactionHistory::ID;
+
+void raw_getTransactionHistory::store(td::TlStorerToString &s, const char *field_name) const {
+  if (!LOG_IS_STRIPPED(ERROR)) {
+    s.store_class_begin(field_name, "raw_getTransactionHistory");
+    if (account_address_ == nullptr) { s.store_field("account_address", "null"); } else { account_address_->store(s, "account_address"); }
+    if (from_transaction_id_ == nullptr) { s.store_field("from_transaction_id", "null"); } else { from_transaction_id_->store(s, "from_transaction_id"); }
+    s.store_field("limit", limit_);
+    s.store_class_end();
+  }
+}
+
 raw_getTransactions::raw_getTransactions()
   : account_address_()
   , from_transaction_id_()
@@ -600,6 +600,23 @@ class updateSyncState final : public Update {
   void store(td::TlStorerToString &s, const char *field_name) const final;
 };
 
+class updateRawTransactions final : public Update {
+ public:
+  object_ptr<accountAddress> account_address_;
+  object_ptr<raw_transactions> transactions_;
+
+  updateRawTransactions();
+
+  updateRawTransactions(object_ptr<accountAddress> &&account_address_, object_ptr<raw_transactions> &&transactions_);
+
+  static const std::int32_t ID = 166624739;
+  std::int32_t get_id() const final {
+    return ID;
+  }
+
+  void store(td::TlStorerToString &s, const char *field_name) const final;
+};
+
 class generic_AccountState: public Object {
  public:
 };
@@ -1917,6 +1934,26 @@ class raw_getAccountState final : public Function {
   void store(td::TlStorerToString &s, const char *field_name) const final;
 };
 
+class raw_getTransactionHistory final : public Function {
+ public:
+  object_ptr<accountAddress> account_address_;
+  object_ptr<internal_transactionId> from_transaction_id_;
+  std::int32_t limit_;
+
+  raw_getTransactionHistory();
+
+  raw_getTransactionHistory(object_ptr<accountAddress> &&account_address_, object_ptr<internal_transactionId> &&from_transaction_id_, std::int32_t limit_);
+
+  static const std::int32_t ID = 1689504891;
+  std::int32_t get_id() const final {
+    return ID;
+  }
+
+  using ReturnType = object_ptr<internal_transactionId>;
+
+  void store(td::TlStorerToString &s, const char *field_name) const final;
+};
+
 class raw_getTransactions final : public Function {
  public:
   object_ptr<accountAddress> account_address_;
@@ -95,6 +95,9 @@ bool downcast_call(Object &obj, const T &func) {
     case updateSyncState::ID:
       func(static_cast<updateSyncState &>(obj));
       return true;
+    case updateRawTransactions::ID:
+      func(static_cast<updateRawTransactions &>(obj));
+      return true;
     case generic_accountStateRaw::ID:
       func(static_cast<generic_accountStateRaw &>(obj));
       return true;
@@ -328,6 +331,9 @@ bool downcast_call(Function &obj, const T &func) {
     case raw_getAccountState::ID:
       func(static_cast<raw_getAccountState &>(obj));
       return true;
+    case raw_getTransactionHistory::ID:
+      func(static_cast<raw_getTransactionHistory &>(obj));
+      return true;
     case raw_getTransactions::ID:
       func(static_cast<raw_getTransactions &>(obj));
       return true;
@@ -506,6 +512,9 @@ bool downcast_call(Update &obj, const T &func) {
     case updateSyncState::ID:
       func(static_cast<updateSyncState &>(obj));
       return true;
+    case updateRawTransactions::ID:
+      func(static_cast<updateRawTransactions &>(obj));
+      return true;
     default:
       return false;
   }
@@ -62,7 +62,8 @@ Result<int32> tl_constructor_from_string(tonlib_api::SyncState *object, const st
 Result<int32> tl_constructor_from_string(tonlib_api::Update *object, const std::string &str) {
   static const std::unordered_map<Slice, int32, SliceHash> m = {
     {"updateSendLiteServerQuery", -1555130916},
-    {"updateSyncState", 1204298718}
+    {"updateSyncState", 1204298718},
+    {"updateRawTransactions", 166624739}
   };
   auto it = m.find(str);
   if (it == m.end()) {
@@ -138,6 +139,7 @@ Result<int32> tl_constructor_from_string(tonlib_api::Object *object, const std::
     {"unpackedAccountAddress", 1892946998},
     {"updateSendLiteServerQuery", -1555130916},
     {"updateSyncState", 1204298718},
+    {"updateRawTransactions", 166624739},
     {"generic.accountStateRaw", -1387096685},
     {"generic.accountStateTestWallet", -1041955397},
     {"generic.accountStateWallet", 942582925},
@@ -220,6 +222,7 @@ Result<int32> tl_constructor_from_string(tonlib_api::Function *object, const std
     {"raw.createQuery", -1928557909},
     {"raw.getAccountAddress", -521283849},
     {"raw.getAccountState", 663706721},
+    {"raw.getTransactionHistory", 1689504891},
     {"raw.getTransactions", 935377269},
     {"raw.sendMessage", -1789427488},
     {"runTests", -2039925427},
@@ -567,6 +570,21 @@ Status from_json(tonlib_api::updateSyncState &to, JsonObject &from) {
   }
   return Status::OK();
 }
+Status from_json(tonlib_api::updateRawTransactions &to, JsonObject &from) {
+  {
+    TRY_RESULT(value, get_json_object_field(from, "account_address", JsonValue::Type::Null, true));
+    if (value.type() != JsonValue::Type::Null) {
+      TRY_STATUS(from_json(to.account_address_, value));
+    }
+  }
+  {
+    TRY_RESULT(value, get_json_object_field(from, "transactions", JsonValue::Type::Null, true));
+    if (value.type() != JsonValue::Type::Null) {
+      TRY_STATUS(from_json(to.transactions_, value));
+    }
+  }
+  return Status::OK();
+}
 Status from_json(tonlib_api::generic_accountStateRaw &to, JsonObject &from) {
   {
     TRY_RESULT(value, get_json_object_field(from, "account_state", JsonValue::Type::Null, true));
@@ -1674,6 +1692,27 @@ Status from_json(tonlib_api::raw_getAccountState &to, JsonObject &from) {
   }
   return Status::OK();
 }
+Status from_json(tonlib_api::raw_getTransactionHistory &to, JsonObject &from) {
+  {
+    TRY_RESULT(value, get_json_object_field(from, "account_address", JsonValue::Type::Null, true));
+    if (value.type() != JsonValue::Type::Null) {
+      TRY_STATUS(from_json(to.account_address_, value));
+    }
+  }
+  {
+    TRY_RESULT(value, get_json_object_field(from, "from_transaction_id", JsonValue::Type::Null, true));
+    if (value.type() != JsonValue::Type::Null) {
+      TRY_STATUS(from_json(to.from_transaction_id_, value));
+    }
+  }
+  {
+    TRY_RESULT(value, get_json_object_field(from, "limit", JsonValue::Type::Null, true));
+    if (value.type() != JsonValue::Type::Null) {
+      TRY_STATUS(from_json(to.limit_, value));
+    }
+  }
+  return Status::OK();
+}
 Status from_json(tonlib_api::raw_getTransactions &to, JsonObject &from) {
   {
     TRY_RESULT(value, get_json_object_field(from, "account_address", JsonValue::Type::Null, true));
@@ -2147,6 +2186,16 @@ void to_json(JsonValueScope &jv, const tonlib_api::updateSyncState &object) {
     jo << ctie("sync_state", ToJson(object.sync_state_));
   }
 }
+void to_json(JsonValueScope &jv, const tonlib_api::updateRawTransactions &object) {
+  auto jo = jv.enter_object();
+  jo << ctie("@type", "updateRawTransactions");
+  if (object.account_address_) {
+    jo << ctie("account_address", ToJson(object.account_address_));
+  }
+  if (object.transactions_) {
+    jo << ctie("transactions", ToJson(object.transactions_));
+  }
+}
 void to_json(JsonValueScope &jv, const tonlib_api::generic_AccountState &object) {
   tonlib_api::downcast_call(const_cast<tonlib_api::generic_AccountState &>(object), [&jv](const auto &object) { to_json(jv, object); });
 }
@@ -2684,6 +2733,17 @@ void to_json(JsonValueScope &jv, const tonlib_api::raw_getAccountState &object)
     jo << ctie("account_address", ToJson(object.account_address_));
   }
 }
+void to_json(JsonValueScope &jv, const tonlib_api::raw_getTransactionHistory &object) {
+  auto jo = jv.enter_object();
+  jo << ctie("@type", "raw.getTransactionHistory");
+  if (object.account_address_) {
+    jo << ctie("account_address", ToJson(object.account_address_));
+  }
+  if (object.from_transaction_id_) {
+    jo << ctie("from_transaction_id", ToJson(object.from_transaction_id_));
+  }
+  jo << ctie("limit", ToJson(object.limit_));
+}
 void to_json(JsonValueScope &jv, const tonlib_api::raw_getTransactions &object) {
   auto jo = jv.enter_object();
   jo << ctie("@type", "raw.getTransactions");
@@ -48,6 +48,7 @@ Status from_json(tonlib_api::syncStateInProgress &to, JsonObject &from);
 Status from_json(tonlib_api::unpackedAccountAddress &to, JsonObject &from);
 Status from_json(tonlib_api::updateSendLiteServerQuery &to, JsonObject &from);
 Status from_json(tonlib_api::updateSyncState &to, JsonObject &from);
+Status from_json(tonlib_api::updateRawTransactions &to, JsonObject &from);
 Status from_json(tonlib_api::generic_accountStateRaw &to, JsonObject &from);
 Status from_json(tonlib_api::generic_accountStateTestWallet &to, JsonObject &from);
 Status from_json(tonlib_api::generic_accountStateWallet &to, JsonObject &from);
@@ -121,6 +122,7 @@ Status from_json(tonlib_api::raw_createAndSendMessage &to, JsonObject &from);
 Status from_json(tonlib_api::raw_createQuery &to, JsonObject &from);
 Status from_json(tonlib_api::raw_getAccountAddress &to, JsonObject &from);
 Status from_json(tonlib_api::raw_getAccountState &to, JsonObject &from);
+Status from_json(tonlib_api::raw_getTransactionHistory &to, JsonObject &from);
 Status from_json(tonlib_api::raw_getTransactions &to, JsonObject &from);
 Status from_json(tonlib_api::raw_sendMessage &to, JsonObject &from);
 Status from_json(tonlib_api::runTests &to, JsonObject &from);
@@ -178,6 +180,7 @@ void to_json(JsonValueScope &jv, const tonlib_api::unpackedAccountAddress &objec
 void to_json(JsonValueScope &jv, const tonlib_api::Update &object);
 void to_json(JsonValueScope &jv, const tonlib_api::updateSendLiteServerQuery &object);
 void to_json(JsonValueScope &jv, const tonlib_api::updateSyncState &object);
+void to_json(JsonValueScope &jv, const tonlib_api::updateRawTransactions &object);
 void to_json(JsonValueScope &jv, const tonlib_api::generic_AccountState &object);
 void to_json(JsonValueScope &jv, const tonlib_api::generic_accountStateRaw &object);
 void to_json(JsonValueScope &jv, const tonlib_api::generic_accountStateTestWallet &object);
@@ -254,6 +257,7 @@ void to_json(JsonValueScope &jv, const tonlib_api::raw_createAndSendMessage &obj
 void to_json(JsonValueScope &jv, const tonlib_api::raw_createQuery &object);
 void to_json(JsonValueScope &jv, const tonlib_api::raw_getAccountAddress &object);
 void to_json(JsonValueScope &jv, const tonlib_api::raw_getAccountState &object);
+void to_json(JsonValueScope &jv, const tonlib_api::raw_getTransactionHistory &object);
 void to_json(JsonValueScope &jv, const tonlib_api::raw_getTransactions &object);
 void to_json(JsonValueScope &jv, const tonlib_api::raw_sendMessage &object);
 void to_json(JsonValueScope &jv, const tonlib_api::runTests &object);
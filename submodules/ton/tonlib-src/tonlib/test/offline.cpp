@@ -28,6 +28,11 @@
 #include "tonlib/utils.h"
 #include "tonlib/TonlibClient.h"
 #include "tonlib/Client.h"
+#include "tonlib/ClientJson.h"
+#include "tonlib/ExtClientMulti.h"
+
+#include "ton/lite-tl.hpp"
+#include "tl-utils/lite-utils.hpp"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
@@ -46,6 +51,8 @@
 #include "tonlib/keys/Mnemonic.h"
 #include "tonlib/keys/SimpleEncryption.h"
 
+#include <set>
+
 TEST(Tonlib, CellString) {
   for (unsigned size :
        {0, 1, 7, 8, 35, 127, 128, 255, 256, (int)vm::CellString::max_bytes - 1, (int)vm::CellString::max_bytes}) {
@@ -438,3 +445,371 @@ TEST(Tonlib, KeysApi) {
   CHECK(new_imported_key->public_key_ == key->public_key_);
   CHECK(new_imported_key->secret_ != key->secret_);
 }
+
+TEST(Tonlib, AccountStateCache) {
+  AccountStateCache<int> cache(100);
+  auto key = [](int seqno, int addr) {
+    ton::BlockIdExt block_id{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(seqno),
+                             ton::RootHash::zero(), ton::FileHash::zero()};
+    auto addr_bits = td::Bits256::zero();
+    addr_bits.data()[0] = static_cast<unsigned char>(addr);
+    return AccountStateCacheKey{block_id, block::StdAddress(0, addr_bits)};
+  };
+  CHECK(!cache.get(key(1, 1)));
+
+  // identical queries are coalesced
+  std::vector<int> results;
+  auto promise = [&] {
+    return td::PromiseCreator::lambda([&](td::Result<int> r_x) { results.push_back(r_x.is_ok() ? r_x.ok() : -1); });
+  };
+  CHECK(cache.add_query(key(1, 1), promise()));
+  CHECK(!cache.add_query(key(1, 1), promise()));
+  CHECK(cache.add_query(key(2, 1), promise()));
+  cache.finish_query(key(1, 1), 11, 40);
+  CHECK(results == std::vector<int>({11, 11}));
+  cache.finish_query(key(2, 1), td::Status::Error("error"), 0);
+  CHECK(results == std::vector<int>({11, 11, -1}));
+  CHECK(cache.add_query(key(2, 1), promise()));
+  cache.finish_query(key(2, 1), 21, 40);
+
+  CHECK(cache.get(key(1, 1)).value() == 11);
+  CHECK(cache.get(key(2, 1)).value() == 21);
+  CHECK(!cache.get(key(1, 2)));
+
+  // the least recently used state is evicted
+  cache.add(key(1, 2), 12, 40);
+  CHECK(!cache.get(key(1, 1)));
+  CHECK(cache.get(key(2, 1)).value() == 21);
+  cache.add(key(1, 3), 13, 40);
+  CHECK(!cache.get(key(1, 2)));
+  CHECK(cache.get(key(2, 1)).value() == 21);
+  CHECK(cache.get(key(1, 3)).value() == 13);
+  cache.add(key(1, 4), 14, 101);
+  CHECK(!cache.get(key(1, 4)));
+
+  auto &stats = cache.get_stats();
+  CHECK(stats.coalesced == 1);
+  CHECK(stats.evicted == 2);
+  CHECK(stats.count == 2);
+  CHECK(stats.size == 80);
+  CHECK(stats.hits == 5);
+  CHECK(stats.misses == 5);
+}
+
+TEST(Tonlib, ExtClientMulti) {
+  // answers with its name after a delay, or fails
+  class TestLiteServer : public ton::adnl::AdnlExtClient {
+   public:
+    TestLiteServer(std::string name, double delay, bool is_broken, std::map<std::string, int> &received)
+        : name_(std::move(name)), delay_(delay), is_broken_(is_broken), received_(received) {
+    }
+    void check_ready(td::Promise<td::Unit> promise) override {
+      promise.set_value(td::Unit());
+    }
+    void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                    td::Promise<td::BufferSlice> promise) override {
+      received_[name]++;
+      if (is_broken_) {
+        return promise.set_error(td::Status::Error("connection closed"));
+      }
+      auto answer_at = td::Timestamp::in(delay_);
+      if (timeout.at() < answer_at.at()) {
+        answer_at = timeout;
+      }
+      queries_.emplace(answer_at.at(), std::move(promise));
+      alarm_timestamp().relax(answer_at);
+    }
+    void alarm() override {
+      while (!queries_.empty() && td::Timestamp::at(queries_.begin()->first).is_in_past()) {
+        auto &promise = queries_.begin()->second;
+        if (delay_ < 100) {
+          promise.set_value(td::BufferSlice(name_));
+        } else {
+          promise.set_error(td::Status::Error("timeout"));
+        }
+        queries_.erase(queries_.begin());
+      }
+      if (!queries_.empty()) {
+        alarm_timestamp() = td::Timestamp::at(queries_.begin()->first);
+      }
+    }
+
+   private:
+    std::string name_;
+    double delay_;
+    bool is_broken_;
+    std::map<std::string, int> &received_;
+    std::multimap<double, td::Promise<td::BufferSlice>> queries_;
+  };
+
+  class Test : public td::actor::Actor {
+   public:
+    Test(std::map<std::string, int> &answers, std::map<std::string, int> &received)
+        : answers_(answers), received_(received) {
+    }
+    void start_up() override {
+      std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> servers;
+      servers.push_back(td::actor::create_actor<TestLiteServer>("fast", "fast", 0.005, false, received_));
+      servers.push_back(td::actor::create_actor<TestLiteServer>("slow", "slow", 0.2, false, received_));
+      servers.push_back(td::actor::create_actor<TestLiteServer>("broken", "broken", 0, true, received_));
+      servers.push_back(td::actor::create_actor<TestLiteServer>("dead", "dead", 1000, false, received_));
+      ExtClientMulti::Options options;
+      options.hedge_min_delay = 0.05;
+      options.hedge_latency_factor = 2;
+      client_ = ExtClientMulti::create(std::move(servers), options);
+
+      // without send once semantics every message would be either hedged or retried on the other server
+      std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> message_servers;
+      message_servers.push_back(td::actor::create_actor<TestLiteServer>("slower", "slower", 0.5, false, received_));
+      message_servers.push_back(td::actor::create_actor<TestLiteServer>("broken", "broken", 0, true, received_));
+      message_client_ = ExtClientMulti::create(std::move(message_servers), options);
+      send_query();
+    }
+    void send_query() {
+      if (left_queries_ == 0 && left_messages_ == 0) {
+        client_.reset();
+        message_client_.reset();
+        return td::actor::SchedulerContext::get()->stop();
+      }
+      if (left_queries_ != 0) {
+        left_queries_--;
+        send_closure(client_, &ton::adnl::AdnlExtClient::send_query, "query", td::BufferSlice("data"),
+                     td::Timestamp::in(2), td::promise_send_closure(actor_id(this), &Test::on_answer));
+      } else {
+        left_messages_--;
+        send_closure(message_client_, &ton::adnl::AdnlExtClient::send_query, "sendMessage", td::BufferSlice("message"),
+                     td::Timestamp::in(1), td::promise_send_closure(actor_id(this), &Test::on_message_answer));
+      }
+    }
+    void on_answer(td::Result<td::BufferSlice> r_answer) {
+      LOG_IF(FATAL, r_answer.is_error()) << r_answer.error();
+      answers_[r_answer.ok().as_slice().str()]++;
+      send_query();
+    }
+    void on_message_answer(td::Result<td::BufferSlice> r_answer) {
+      send_query();
+    }
+
+   private:
+    std::map<std::string, int> &answers_;
+    std::map<std::string, int> &received_;
+    int left_messages_{4};
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client_;
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> message_client_;
+    int left_queries_{30};
+  };
+
+  std::map<std::string, int> answers;
+  std::map<std::string, int> received;
+  {
+    td::actor::Scheduler scheduler({1});
+    scheduler.run_in_context([&] { td::actor::create_actor<Test>("Test", answers, received).release(); });
+    scheduler.run();
+  }
+  CHECK(received["sendMessage"] == 4);
+  CHECK(answers["broken"] == 0);
+  CHECK(answers["dead"] == 0);
+  CHECK(answers["fast"] + answers["slow"] == 30);
+  CHECK(answers["fast"] >= 25);
+}
+
+TEST(Tonlib, TransactionHistoryShortPages) {
+  using tonlib_api::make_object;
+  auto address = block::StdAddress::parse("-1:538fa7cc24ff8eaa101d84a5f1ab7e832fe1d84b309cdfef4ee94373aac80f7d")
+                     .move_as_ok();
+
+  // a chain of transactions, from the oldest one to the newest one
+  std::vector<td::Ref<vm::Cell>> chain;
+  ton::LogicalTime prev_lt = 0;
+  td::Bits256 prev_hash = td::Bits256::zero();
+  for (int i = 0; i < 30; i++) {
+    vm::CellBuilder descr;
+    descr.store_long(1, 4).store_long(0, 4 + 1 + 1);  // trans_storage$0001 storage_ph:(0 grams, nothing, unchanged)
+    vm::CellBuilder state_update;
+    state_update.store_long(0x72, 8).store_zeroes(256 * 2);
+    vm::CellBuilder msgs;
+    msgs.store_long(0, 2);
+    vm::CellBuilder cb;
+    auto lt = prev_lt + 10;
+    cb.store_long(7, 4)
+        .store_bits(address.addr.cbits(), 256)
+        .store_long(lt, 64)
+        .store_bits(prev_hash.cbits(), 256)
+        .store_long(prev_lt, 64)
+        .store_long(1000 + i, 32)
+        .store_long(0, 15)
+        .store_long(2, 2)
+        .store_long(2, 2)
+        .store_ref(msgs.finalize())
+        .store_long(0, 4 + 1)  // total_fees:CurrencyCollection
+        .store_ref(state_update.finalize())
+        .store_ref(descr.finalize());
+    auto root = cb.finalize();
+    prev_lt = lt;
+    prev_hash = root->get_hash().bits();
+    chain.push_back(std::move(root));
+  }
+
+  // answers with at most 3 transactions per page
+  auto answer = [&](td::Slice data) -> td::Result<td::BufferSlice> {
+    TRY_RESULT(query, ton::fetch_tl_object<ton::lite_api::liteServer_query>(data, true));
+    TRY_RESULT(get, ton::fetch_tl_object<ton::lite_api::liteServer_getTransactions>(query->data_, true));
+    auto it = std::find_if(chain.begin(), chain.end(),
+                           [&](auto &root) { return td::Bits256(root->get_hash().bits()) == get->hash_; });
+    if (it == chain.end()) {
+      return td::Status::Error("unknown transaction");
+    }
+    std::vector<td::Ref<vm::Cell>> roots;
+    std::vector<ton::lite_api::object_ptr<ton::lite_api::tonNode_blockIdExt>> ids;
+    while (roots.size() < static_cast<size_t>(td::min(get->count_, 3))) {
+      roots.push_back(*it);
+      ids.push_back(ton::create_tl_lite_block_id(ton::BlockIdExt(ton::masterchainId, ton::shardIdAll, 1,
+                                                                  ton::RootHash::zero(), ton::FileHash::zero())));
+      if (it == chain.begin()) {
+        break;
+      }
+      --it;
+    }
+    TRY_RESULT(boc, vm::std_boc_serialize_multi(std::move(roots)));
+    return ton::serialize_tl_object(
+        ton::create_tl_object<ton::lite_api::liteServer_transactionList>(std::move(ids), std::move(boc)), true);
+  };
+
+  td::Slice config = R"abc(
+{
+  "liteservers": [ ],
+  "validator": {
+    "@type": "validator.config.global",
+    "zero_state": {
+      "workchain": -1,
+      "shard": -9223372036854775808,
+      "seqno": 0,
+      "root_hash": "F6OpKZKqvqeFp6CQmFomXNMfMj2EnaUSOXN+Mh+wVWk=",
+      "file_hash": "XplPz01CXAps5qeSWUtxcyBfdAo5zVb1N979KLSKD24="
+    }
+  }
+}
+)abc";
+
+  Client client;
+  sync_send(client, make_object<tonlib_api::init>(make_object<tonlib_api::options>(
+                        make_object<tonlib_api::config>(config.str(), "test", true, true),
+                        make_object<tonlib_api::keyStoreTypeInMemory>())))
+      .ensure();
+
+  auto last = chain.back();
+  client.send({2, make_object<tonlib_api::raw_getTransactionHistory>(
+                      make_object<tonlib_api::accountAddress>(address.rserialize()),
+                      make_object<tonlib_api::internal_transactionId>(
+                          chain.size() * 10, last->get_hash().as_slice().str()),
+                      25)});
+  size_t received = 0;
+  tonlib_api::object_ptr<tonlib_api::Object> result;
+  while (!result) {
+    auto response = client.receive(100);
+    if (!response.object) {
+      continue;
+    }
+    if (response.id == 2) {
+      result = std::move(response.object);
+    } else if (response.object->get_id() == tonlib_api::updateSendLiteServerQuery::ID) {
+      auto &update = static_cast<tonlib_api::updateSendLiteServerQuery &>(*response.object);
+      auto r_answer = answer(update.data_);
+      if (r_answer.is_ok()) {
+        client.send({3, make_object<tonlib_api::onLiteServerQueryResult>(update.id_, r_answer.ok().as_slice().str())});
+      } else {
+        client.send({3, make_object<tonlib_api::onLiteServerQueryError>(
+                            update.id_, make_object<tonlib_api::error>(500, r_answer.error().message().str()))});
+      }
+    } else if (response.object->get_id() == tonlib_api::updateRawTransactions::ID) {
+      auto &update = static_cast<tonlib_api::updateRawTransactions &>(*response.object);
+      for (auto &transaction : update.transactions_->transactions_) {
+        auto expected = chain[chain.size() - 1 - received];
+        CHECK(transaction->data_ ==
+              vm::std_boc_serialize(expected, vm::BagOfCells::Mode::WithCRC32C).move_as_ok().as_slice());
+        received++;
+      }
+    }
+  }
+  CHECK(result->get_id() == tonlib_api::internal_transactionId::ID);
+  auto &next = static_cast<tonlib_api::internal_transactionId &>(*result);
+  CHECK(received == 25);
+  CHECK(next.lt_ == (chain.size() - 25) * 10);
+  CHECK(next.hash_ == chain[chain.size() - 26]->get_hash().as_slice().str());
+}
+
+TEST(Tonlib, ClientJson) {
+  ClientJson client;
+  // more requests than there are @extra slots, so some of them are stored in the fallback map
+  const int n = 10000;
+  for (int i = 1; i <= n; i++) {
+    if (i % 3 == 0) {
+      client.send(PSLICE() << "{\"@type\":\"getLogVerbosityLevel\"}");
+    } else if (i % 3 == 1) {
+      client.send(PSLICE() << "{\"@type\":\"getLogVerbosityLevel\",\"@extra\":" << i << "}");
+    } else {
+      client.send(PSLICE() << "{\"@extra\":{\"id\":\"" << i << "\"},\"@type\":\"getLogVerbosityLevel\"}");
+    }
+  }
+  client.send("{\"@type\":\"getLogVerbosityLevel\",\"@extra\":\"\\u0000\"}");
+
+  std::set<std::string> expected;
+  for (int i = 1; i <= n; i++) {
+    if (i % 3 == 1) {
+      expected.insert(PSTRING() << i);
+    } else if (i % 3 == 2) {
+      expected.insert(PSTRING() << "{\"id\":\"" << i << "\"}");
+    }
+  }
+  expected.insert("\"\\u0000\"");
+
+  std::set<std::string> extras;
+  for (int i = 0; i <= n; i++) {
+    auto response = client.receive(10).str();
+    CHECK(td::begins_with(response, "{\"@type\":\"logVerbosityLevel\",\"verbosity_level\":"));
+    auto pos = response.find(",\"@extra\":");
+    if (pos != std::string::npos) {
+      CHECK(response.back() == '}');
+      auto extra = response.substr(pos + 10, response.size() - pos - 11);
+      CHECK(extras.insert(extra).second);
+    }
+  }
+  CHECK(extras == expected);
+
+  auto response = ClientJson::execute("{\"@type\":\"getLogVerbosityLevel\",\"@extra\":[1,2]}").str();
+  CHECK(td::ends_with(response, ",\"@extra\":[1,2]}"));
+}
+
+class ClientJsonBench : public td::Benchmark {
+ public:
+  std::string get_description() const override {
+    return "tonlib_client_json send/receive";
+  }
+  void start_up() override {
+    client_ = std::make_unique<ClientJson>();
+  }
+  void tear_down() override {
+    client_.reset();
+  }
+  void run(int n) override {
+    const int max_in_flight = 1000;
+    int sent = 0;
+    int received = 0;
+    while (received < n) {
+      while (sent < n && sent - received < max_in_flight) {
+        sent++;
+        client_->send(PSLICE() << "{\"@type\":\"getLogVerbosityLevel\",\"@extra\":" << sent << "}");
+      }
+      auto response = client_->receive(10);
+      CHECK(!response.empty());
+      received++;
+    }
+  }
+
+ private:
+  std::unique_ptr<ClientJson> client_;
+};
+
+TEST(Tonlib, BenchClientJson) {
+  td::bench(ClientJsonBench());
+}
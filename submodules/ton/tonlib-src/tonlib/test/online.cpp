@@ -397,6 +397,55 @@ void dump_transaction_history(Client& client, std::string address) {
   LOG(ERROR) << cnt;
 }
 
+void test_transaction_history(Client& client, std::string address) {
+  LOG(ERROR) << "TEST: transaction history";
+  using tonlib_api::make_object;
+  auto state = sync_send(client, make_object<tonlib_api::raw_getAccountState>(
+                                     make_object<tonlib_api::accountAddress>(address)))
+                   .move_as_ok();
+  auto from = TransactionId{state->last_transaction_id_->lt_, state->last_transaction_id_->hash_};
+  const int limit = 25;
+
+  // page by page
+  std::vector<std::string> expected;
+  auto tid = make_object<tonlib_api::internal_transactionId>(from.lt, from.hash);
+  while (tid->lt_ != 0 && expected.size() < static_cast<size_t>(limit)) {
+    auto got_transactions = sync_send(client, make_object<tonlib_api::raw_getTransactions>(
+                                                  make_object<tonlib_api::accountAddress>(address), std::move(tid)))
+                                .move_as_ok();
+    for (auto& txn : got_transactions->transactions_) {
+      expected.push_back(txn->data_);
+    }
+    tid = std::move(got_transactions->previous_transaction_id_);
+  }
+  expected.resize(td::min(expected.size(), static_cast<size_t>(limit)));
+
+  // streamed
+  std::vector<std::string> got;
+  client.send({1, make_object<tonlib_api::raw_getTransactionHistory>(
+                      make_object<tonlib_api::accountAddress>(address),
+                      make_object<tonlib_api::internal_transactionId>(from.lt, from.hash), limit)});
+  while (true) {
+    auto response = client.receive(100);
+    if (!response.object) {
+      continue;
+    }
+    if (response.id == 0) {
+      if (response.object->get_id() == tonlib_api::updateRawTransactions::ID) {
+        auto update = tonlib_api::move_object_as<tonlib_api::updateRawTransactions>(response.object);
+        for (auto& txn : update->transactions_->transactions_) {
+          got.push_back(txn->data_);
+        }
+      }
+      continue;
+    }
+    CHECK(response.id == 1);
+    CHECK(response.object->get_id() == tonlib_api::internal_transactionId::ID);
+    break;
+  }
+  CHECK(got == expected);
+}
+
 void test_estimate_fees_without_key(Client& client, const Wallet& wallet_a, const Wallet& wallet_b) {
   LOG(ERROR) << " SUBTEST: estimate fees without key";
   {
@@ -553,6 +602,7 @@ int main(int argc, char* argv[]) {
   test_back_and_forth_transfer(client, giver_wallet, false);
   test_back_and_forth_transfer(client, giver_wallet, true);
   test_multisig(client, giver_wallet);
+  test_transaction_history(client, giver_wallet.address);
 
   return 0;
 }
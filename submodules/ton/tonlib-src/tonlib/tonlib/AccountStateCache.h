@@ -0,0 +1,159 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+
+#include "block/block.h"
+#include "ton/ton-types.h"
+
+#include "td/actor/PromiseFuture.h"
+#include "td/utils/common.h"
+#include "td/utils/optional.h"
+#include "td/utils/StringBuilder.h"
+
+#include <list>
+#include <map>
+#include <tuple>
+
+namespace tonlib {
+struct AccountStateCacheKey {
+  ton::BlockIdExt block_id;
+  block::StdAddress address;
+
+  bool operator<(const AccountStateCacheKey &other) const {
+    return std::tie(block_id, address.workchain, address.addr) <
+           std::tie(other.block_id, other.address.workchain, other.address.addr);
+  }
+};
+
+struct AccountStateCacheStats {
+  td::uint64 hits{0};
+  td::uint64 misses{0};
+  td::uint64 coalesced{0};
+  td::uint64 evicted{0};
+  size_t size{0};
+  size_t count{0};
+};
+
+inline td::StringBuilder &operator<<(td::StringBuilder &sb, const AccountStateCacheStats &stats) {
+  return sb << "hits=" << stats.hits << " misses=" << stats.misses << " coalesced=" << stats.coalesced
+            << " evicted=" << stats.evicted << " size=" << stats.size << " count=" << stats.count;
+}
+
+// Account states that are already validated against the masterchain block they were requested for.
+// The least recently used states are evicted when their total size exceeds the budget.
+// Identical queries are coalesced: only the first one is sent, the others wait for its result.
+template <class ValueT>
+class AccountStateCache {
+ public:
+  explicit AccountStateCache(size_t max_size) : max_size_(max_size) {
+  }
+
+  td::optional<ValueT> get(const AccountStateCacheKey &key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      stats_.misses++;
+      return {};
+    }
+    stats_.hits++;
+    lru_.splice(lru_.end(), lru_, it->second.lru_it);
+    return it->second.value;
+  }
+
+  // Returns true if the caller must send the query and call finish_query with its result
+  bool add_query(const AccountStateCacheKey &key, td::Promise<ValueT> promise) {
+    auto &waiting = queries_[key];
+    waiting.push_back(std::move(promise));
+    if (waiting.size() > 1) {
+      stats_.coalesced++;
+      return false;
+    }
+    return true;
+  }
+
+  void finish_query(const AccountStateCacheKey &key, td::Result<ValueT> r_value, size_t size) {
+    auto it = queries_.find(key);
+    CHECK(it != queries_.end());
+    auto waiting = std::move(it->second);
+    queries_.erase(it);
+
+    if (r_value.is_error()) {
+      for (auto &promise : waiting) {
+        promise.set_error(r_value.error().clone());
+      }
+      return;
+    }
+    auto value = r_value.move_as_ok();
+    for (auto &promise : waiting) {
+      promise.set_value(ValueT(value));
+    }
+    add(key, std::move(value), size);
+  }
+
+  void add(const AccountStateCacheKey &key, ValueT value, size_t size) {
+    if (size > max_size_) {
+      return;
+    }
+    erase(key);
+    lru_.push_back(key);
+    entries_.emplace(key, Entry{std::move(value), size, std::prev(lru_.end())});
+    stats_.size += size;
+    stats_.count++;
+    while (stats_.size > max_size_) {
+      auto oldest_key = lru_.front();
+      erase(oldest_key);
+      stats_.evicted++;
+    }
+  }
+
+  void clear() {
+    entries_.clear();
+    lru_.clear();
+    stats_.size = 0;
+    stats_.count = 0;
+  }
+
+  const AccountStateCacheStats &get_stats() const {
+    return stats_;
+  }
+
+ private:
+  struct Entry {
+    ValueT value;
+    size_t size;
+    typename std::list<AccountStateCacheKey>::iterator lru_it;
+  };
+
+  size_t max_size_;
+  std::map<AccountStateCacheKey, Entry> entries_;
+  std::list<AccountStateCacheKey> lru_;
+  std::map<AccountStateCacheKey, std::vector<td::Promise<ValueT>>> queries_;
+  AccountStateCacheStats stats_;
+
+  void erase(const AccountStateCacheKey &key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return;
+    }
+    stats_.size -= it->second.size;
+    stats_.count--;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+};
+}  // namespace tonlib
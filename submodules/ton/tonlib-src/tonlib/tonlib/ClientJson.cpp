@@ -33,8 +33,23 @@
 
 namespace tonlib {
 
+// Buffers reused by all requests and responses of a thread
+struct JsonBuffers {
+  std::string request;
+  td::JsonBuilder response{td::StringBuilder({}, true), -1};
+};
+
+static TD_THREAD_LOCAL JsonBuffers *json_buffers;
+
+static JsonBuffers &get_json_buffers() {
+  td::init_thread_local<JsonBuffers>(json_buffers);
+  return *json_buffers;
+}
+
 static td::Result<std::pair<tonlib_api::object_ptr<tonlib_api::Function>, std::string>> to_request(td::Slice request) {
-  auto request_str = request.str();
+  // the request is decoded in place, so it is copied to a reused buffer first
+  auto &request_str = get_json_buffers().request;
+  request_str.assign(request.data(), request.size());
   TRY_RESULT(json_value, td::json_decode(request_str));
   if (json_value.type() != td::JsonValue::Type::Object) {
     return td::Status::Error("Expected an Object");
@@ -51,25 +66,57 @@ static td::Result<std::pair<tonlib_api::object_ptr<tonlib_api::Function>, std::s
   return std::make_pair(std::move(func), extra);
 }
 
-static std::string from_response(const tonlib_api::Object &object, const td::string &extra) {
-  auto str = td::json_encode<td::string>(td::ToJson(object));
-  CHECK(!str.empty() && str.back() == '}');
+static td::CSlice from_response(const tonlib_api::Object &object, td::Slice extra) {
+  auto &jb = get_json_buffers().response;
+  auto &sb = jb.string_builder();
+  sb.clear();
+  jb.enter_value() << td::ToJson(object);
   if (!extra.empty()) {
-    str.pop_back();
-    str.reserve(str.size() + 11 + extra.size());
-    str += ",\"@extra\":";
-    str += extra;
-    str += '}';
+    CHECK(sb.as_cslice().back() == '}');
+    sb.pop_back();
+    sb << ",\"@extra\":" << extra << '}';
+  }
+  LOG_IF(ERROR, sb.is_error()) << "JSON buffer overflow";
+  return sb.as_cslice();
+}
+
+void ClientJson::add_extra(std::uint64_t id, std::string extra) {
+  auto &slot = extra_slots_[id % EXTRA_SLOT_COUNT];
+  std::uint64_t expected_id = 0;
+  if (slot.id.compare_exchange_strong(expected_id, LOCKED_SLOT_ID, std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+    slot.extra = std::move(extra);
+    slot.id.store(id, std::memory_order_release);
+    return;
   }
-  return str;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  extra_[id] = std::move(extra);
+  extra_size_.fetch_add(1, std::memory_order_relaxed);
 }
 
-static TD_THREAD_LOCAL std::string *current_output;
+std::string ClientJson::get_extra(std::uint64_t id) {
+  // the response is received after add_extra for its request has returned
+  auto &slot = extra_slots_[id % EXTRA_SLOT_COUNT];
+  if (slot.id.load(std::memory_order_acquire) == id) {
+    auto extra = std::move(slot.extra);
+    slot.extra.clear();
+    slot.id.store(0, std::memory_order_release);
+    return extra;
+  }
 
-static td::CSlice store_string(std::string str) {
-  td::init_thread_local<std::string>(current_output);
-  *current_output = std::move(str);
-  return *current_output;
+  if (extra_size_.load(std::memory_order_relaxed) == 0) {
+    return {};
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = extra_.find(id);
+  if (it == extra_.end()) {
+    return {};
+  }
+  auto extra = std::move(it->second);
+  extra_.erase(it);
+  extra_size_.fetch_sub(1, std::memory_order_relaxed);
+  return extra;
 }
 
 void ClientJson::send(td::Slice request) {
@@ -81,8 +128,7 @@ void ClientJson::send(td::Slice request) {
 
   std::uint64_t extra_id = extra_id_.fetch_add(1, std::memory_order_relaxed);
   if (!r_request.ok_ref().second.empty()) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    extra_[extra_id] = std::move(r_request.ok_ref().second);
+    add_extra(extra_id, std::move(r_request.ok_ref().second));
   }
   client_.send(Client::Request{extra_id, std::move(r_request.ok_ref().first)});
 }
@@ -95,14 +141,9 @@ td::CSlice ClientJson::receive(double timeout) {
 
   std::string extra;
   if (response.id != 0) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    auto it = extra_.find(response.id);
-    if (it != extra_.end()) {
-      extra = std::move(it->second);
-      extra_.erase(it);
-    }
+    extra = get_extra(response.id);
   }
-  return store_string(from_response(*response.object, extra));
+  return from_response(*response.object, extra);
 }
 
 td::CSlice ClientJson::execute(td::Slice request) {
@@ -112,8 +153,8 @@ td::CSlice ClientJson::execute(td::Slice request) {
     return {};
   }
 
-  return store_string(from_response(*Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)}).object,
-                                    r_request.ok().second));
+  return from_response(*Client::execute(Client::Request{0, std::move(r_request.ok_ref().first)}).object,
+                       r_request.ok().second);
 }
 
 }  // namespace tonlib
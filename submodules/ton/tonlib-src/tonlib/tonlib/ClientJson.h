@@ -22,6 +22,7 @@
 
 #include "td/utils/Slice.h"
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <mutex>
@@ -30,6 +31,8 @@
 
 namespace tonlib {
 
+// send may be called concurrently from several threads, receive is called from one thread at a time.
+// The returned slices are valid until the next call to receive or execute from the same thread.
 class ClientJson final {
  public:
   void send(td::Slice request);
@@ -40,9 +43,24 @@ class ClientJson final {
 
  private:
   Client client_;
-  std::mutex mutex_;  // for extra_
-  std::unordered_map<std::int64_t, std::string> extra_;
   std::atomic<std::uint64_t> extra_id_{1};
+
+  // @extra of a request is stored in the slot chosen by its id, unless the slot is occupied by another request.
+  // The slot is locked by its sender only while the @extra is being written, and freed by the receiver
+  struct ExtraSlot {
+    std::atomic<std::uint64_t> id{0};
+    std::string extra;
+  };
+  static constexpr std::size_t EXTRA_SLOT_COUNT = 1 << 12;
+  static constexpr std::uint64_t LOCKED_SLOT_ID = static_cast<std::uint64_t>(-1);
+  std::array<ExtraSlot, EXTRA_SLOT_COUNT> extra_slots_;
+
+  std::atomic<std::size_t> extra_size_{0};  // number of elements in extra_
+  std::mutex mutex_;                        // for extra_
+  std::unordered_map<std::uint64_t, std::string> extra_;
+
+  void add_extra(std::uint64_t id, std::string extra);
+  std::string get_extra(std::uint64_t id);
 };
 
 }  // namespace tonlib
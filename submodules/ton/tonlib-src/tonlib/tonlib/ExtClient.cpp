@@ -54,7 +54,7 @@ void ExtClient::with_last_block(td::Promise<LastBlockState> promise) {
   td::actor::send_closure(client_.last_block_actor_, &LastBlock::get_last_block, std::move(P));
 }
 
-void ExtClient::send_raw_query(td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
+void ExtClient::send_raw_query(td::Slice name, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
   auto query_id = queries_.create(std::move(promise));
   td::Promise<td::BufferSlice> P = [query_id, self = this,
                                     actor_id = td::actor::actor_id()](td::Result<td::BufferSlice> result) {
@@ -65,7 +65,7 @@ void ExtClient::send_raw_query(td::BufferSlice query, td::Promise<td::BufferSlic
   if (client_.andl_ext_client_.empty()) {
     return P.set_error(TonlibError::NoLiteServers());
   }
-  td::actor::send_closure(client_.andl_ext_client_, &ton::adnl::AdnlExtClient::send_query, "query", std::move(query),
+  td::actor::send_closure(client_.andl_ext_client_, &ton::adnl::AdnlExtClient::send_query, name.str(), std::move(query),
                           td::Timestamp::in(10.0), std::move(P));
 }
 }  // namespace tonlib
@@ -31,6 +31,8 @@
 #include "TonlibError.h"
 #include "utils.h"
 
+#include <type_traits>
+
 namespace tonlib {
 class LastBlock;
 class LastConfig;
@@ -75,8 +77,12 @@ class ExtClient {
     td::BufferSlice liteserver_query =
         ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_query>(std::move(raw_query)), true);
 
+    // sending a message twice is not harmless, so such queries must not be hedged or retried
+    td::Slice name = std::is_same<QueryT, ton::lite_api::liteServer_sendMessage>::value ? td::Slice("sendMessage")
+                                                                                      : td::Slice("query");
     send_raw_query(
-        std::move(liteserver_query), [promise = std::move(promise), tag](td::Result<td::BufferSlice> R) mutable {
+        name, std::move(liteserver_query),
+        [promise = std::move(promise), tag](td::Result<td::BufferSlice> R) mutable {
           auto res = [&]() -> td::Result<typename QueryT::ReturnType> {
             TRY_RESULT_PREFIX(data, std::move(R), TonlibError::LiteServerNetwork());
             auto r_error = ton::fetch_tl_object<ton::lite_api::liteServer_error>(data.clone(), true);
@@ -100,6 +106,6 @@ class ExtClient {
   td::Container<td::Promise<LastBlockState>> last_block_queries_;
   td::Container<td::Promise<LastConfigState>> last_config_queries_;
 
-  void send_raw_query(td::BufferSlice query, td::Promise<td::BufferSlice> promise);
+  void send_raw_query(td::Slice name, td::BufferSlice query, td::Promise<td::BufferSlice> promise);
 };
 }  // namespace tonlib
@@ -0,0 +1,204 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#include "ExtClientMulti.h"
+#include "TonlibError.h"
+#include "utils.h"
+
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace tonlib {
+
+class ExtClientMultiImp : public ton::adnl::AdnlExtClient {
+ public:
+  ExtClientMultiImp(std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients,
+                    ExtClientMulti::Options options)
+      : options_(options) {
+    CHECK(!clients.empty());
+    for (auto &client : clients) {
+      Server server;
+      server.client = std::move(client);
+      servers_.push_back(std::move(server));
+    }
+  }
+
+  void check_ready(td::Promise<td::Unit> promise) override {
+    auto server_id = choose_server({});
+    send_closure(servers_[server_id].client, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
+  }
+
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    auto query_id = ++last_query_id_;
+    auto &query = queries_[query_id];
+    query.name = std::move(name);
+    query.data = std::move(data);
+    query.timeout = timeout;
+    query.promise = std::move(promise);
+    query.send_once = options_.send_once_query_names.count(query.name) != 0;
+    send_to_server(query_id, query);
+  }
+
+ private:
+  struct Server {
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client;
+    double latency{0};  // zero until the first answer
+    td::uint32 in_flight{0};
+    td::Timestamp failed_until;
+  };
+  struct Query {
+    std::string name;
+    td::BufferSlice data;
+    td::Timestamp timeout;
+    td::Promise<td::BufferSlice> promise;
+    std::vector<size_t> servers;
+    td::uint32 in_flight{0};
+    td::Timestamp hedge_at;
+    bool send_once{false};
+  };
+
+  static constexpr double DEFAULT_LATENCY = 0.1;
+  static constexpr double LATENCY_EWMA_ALPHA = 0.2;
+
+  ExtClientMulti::Options options_;
+  std::vector<Server> servers_;
+  std::map<td::uint64, Query> queries_;
+  td::uint64 last_query_id_{0};
+
+  static double get_latency(const Server &server) {
+    return server.latency == 0 ? DEFAULT_LATENCY : server.latency;
+  }
+
+  static bool is_expired(const Query &query) {
+    return query.timeout && query.timeout.is_in_past();
+  }
+
+  // Returns servers_.size() if the query was already sent to all servers
+  size_t choose_server(const std::vector<size_t> &used_servers) const {
+    auto best_server_id = servers_.size();
+    auto best_key = std::make_tuple(true, 0.0);
+    // start from a random server, so that ties are broken randomly
+    auto offset = static_cast<size_t>(td::Random::fast(0, td::narrow_cast<int>(servers_.size()) - 1));
+    for (size_t i = 0; i < servers_.size(); i++) {
+      auto server_id = (i + offset) % servers_.size();
+      if (std::find(used_servers.begin(), used_servers.end(), server_id) != used_servers.end()) {
+        continue;
+      }
+      auto &server = servers_[server_id];
+      bool is_failed = server.failed_until && !server.failed_until.is_in_past();
+      auto key = std::make_tuple(is_failed, get_latency(server) * (server.in_flight + 1));
+      if (best_server_id == servers_.size() || key < best_key) {
+        best_server_id = server_id;
+        best_key = key;
+      }
+    }
+    return best_server_id;
+  }
+
+  bool send_to_server(td::uint64 query_id, Query &query) {
+    auto server_id = choose_server(query.servers);
+    if (server_id == servers_.size()) {
+      return false;
+    }
+    auto &server = servers_[server_id];
+    server.in_flight++;
+    query.servers.push_back(server_id);
+    query.in_flight++;
+    if (query.servers.size() == 1 && servers_.size() > 1 && !query.send_once) {
+      query.hedge_at = td::Timestamp::in(
+          td::max(options_.hedge_min_delay, options_.hedge_latency_factor * get_latency(server)));
+      alarm_timestamp().relax(query.hedge_at);
+    }
+    send_closure(server.client, &ton::adnl::AdnlExtClient::send_query, query.name, query.data.clone(), query.timeout,
+                 td::promise_send_closure(actor_id(this), &ExtClientMultiImp::on_query_result, query_id, server_id,
+                                          td::Time::now()));
+    return true;
+  }
+
+  void on_query_result(td::uint64 query_id, size_t server_id, double sent_at, td::Result<td::BufferSlice> r_data) {
+    auto &server = servers_[server_id];
+    server.in_flight--;
+    if (r_data.is_ok()) {
+      auto latency = td::Time::now() - sent_at;
+      server.latency = server.latency == 0 ? latency : server.latency + LATENCY_EWMA_ALPHA * (latency - server.latency);
+      server.failed_until = {};
+    } else {
+      VLOG(lite_server) << "query to lite server " << server_id << " failed: " << r_data.error();
+      server.failed_until = td::Timestamp::in(options_.failure_backoff);
+    }
+
+    auto it = queries_.find(query_id);
+    if (it == queries_.end()) {
+      // the query was already answered by another server
+      return;
+    }
+    auto &query = it->second;
+    query.in_flight--;
+    if (r_data.is_error()) {
+      // replace the failed attempt even if other ones are still in flight, because they may never be answered
+      if (!query.send_once && !is_expired(query) && send_to_server(query_id, query)) {
+        VLOG(lite_server) << "retry query " << query_id << " on lite server " << query.servers.back();
+        return;
+      }
+      if (query.in_flight != 0) {
+        return;
+      }
+    }
+    query.promise.set_result(std::move(r_data));
+    queries_.erase(it);
+  }
+
+  void alarm() override {
+    for (auto &it : queries_) {
+      auto &query = it.second;
+      if (!query.hedge_at) {
+        continue;
+      }
+      if (!query.hedge_at.is_in_past()) {
+        alarm_timestamp().relax(query.hedge_at);
+        continue;
+      }
+      query.hedge_at = {};
+      if (!is_expired(query) && send_to_server(it.first, query)) {
+        VLOG(lite_server) << "hedge query " << it.first << " to lite server " << query.servers.back();
+      }
+    }
+  }
+
+  void hangup() override {
+    stop();
+  }
+
+  void tear_down() override {
+    for (auto &it : queries_) {
+      it.second.promise.set_error(TonlibError::Cancelled());
+    }
+    queries_.clear();
+  }
+};
+
+td::actor::ActorOwn<ton::adnl::AdnlExtClient> ExtClientMulti::create(
+    std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients, Options options) {
+  return td::actor::create_actor<ExtClientMultiImp>("ExtClientMulti", std::move(clients), options);
+}
+}  // namespace tonlib
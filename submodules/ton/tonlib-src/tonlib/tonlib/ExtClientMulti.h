@@ -0,0 +1,51 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2019 Telegram Systems LLP
+*/
+#pragma once
+#include "td/actor/actor.h"
+
+#include "adnl/adnl-ext-client.h"
+
+#include <set>
+#include <string>
+
+namespace tonlib {
+// Sends queries to a pool of lite servers.
+//
+// Each query goes to the server with the lowest expected latency, i.e. its average latency multiplied
+// by the number of its queries in flight plus one. A query that is not answered in time is hedged to
+// a second server and the first answer wins. A failed server is avoided for a while and its queries
+// are retried on other servers.
+class ExtClientMulti {
+ public:
+  struct Options {
+    // a query is hedged after max(hedge_min_delay, hedge_latency_factor * average latency of its server)
+    double hedge_min_delay{0.5};
+    double hedge_latency_factor{4};
+    // a server isn't used for this time after a failed query, unless all other servers have failed too
+    double failure_backoff{10};
+    // queries with these names may be not idempotent, so they are sent to one server only,
+    // and neither hedged nor retried on another server after a failure
+    std::set<std::string> send_once_query_names{"sendMessage"};
+  };
+
+  static td::actor::ActorOwn<ton::adnl::AdnlExtClient> create(
+      std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients, Options options);
+};
+
+}  // namespace tonlib
@@ -47,7 +47,7 @@ auto &log_data() {
 #define ADD_TAG(tag) \
   { #tag, &VERBOSITY_NAME(tag) }
 static const std::map<td::Slice, int *> log_tags{ADD_TAG(tonlib_query), ADD_TAG(last_block), ADD_TAG(last_config),
-                                                 ADD_TAG(lite_server)};
+                                                 ADD_TAG(lite_server), ADD_TAG(vm_profile)};
 #undef ADD_TAG
 
 td::Status Logging::set_current_stream(tonlib_api::object_ptr<tonlib_api::LogStream> stream) {
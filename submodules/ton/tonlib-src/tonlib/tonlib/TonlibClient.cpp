@@ -19,6 +19,7 @@
 #include "TonlibClient.h"
 
 #include "tonlib/ExtClientLazy.h"
+#include "tonlib/ExtClientMulti.h"
 #include "tonlib/ExtClientOutbound.h"
 #include "tonlib/LastBlock.h"
 #include "tonlib/LastConfig.h"
@@ -41,6 +42,7 @@
 #include "ton/ton-shard.h"
 
 #include "vm/boc.h"
+#include "vm/profiler.h"
 
 #include "td/utils/as.h"
 #include "td/utils/Random.h"
@@ -106,6 +108,9 @@ struct RawAccountState {
   td::Ref<vm::Cell> state;
   std::string frozen_hash;
   block::AccountState::Info info;
+
+  // size of the serialized proofs and state, used as the size of the cache entry
+  size_t size{0};
 };
 
 tonlib_api::object_ptr<tonlib_api::internal_transactionId> empty_transaction_id() {
@@ -646,9 +651,12 @@ class GetTransactionHistory : public td::actor::Actor {
 
 class GetRawAccountState : public td::actor::Actor {
  public:
-  GetRawAccountState(ExtClientRef ext_client_ref, block::StdAddress address, td::actor::ActorShared<> parent,
-                     td::Promise<RawAccountState>&& promise)
-      : address_(std::move(address)), promise_(std::move(promise)), parent_(std::move(parent)) {
+  GetRawAccountState(ExtClientRef ext_client_ref, block::StdAddress address, LastBlockState last_block,
+                     td::actor::ActorShared<> parent, td::Promise<RawAccountState>&& promise)
+      : address_(std::move(address))
+      , promise_(std::move(promise))
+      , parent_(std::move(parent))
+      , last_block_(std::move(last_block)) {
     client_.set_client(ext_client_ref);
   }
 
@@ -656,8 +664,8 @@ class GetRawAccountState : public td::actor::Actor {
   block::StdAddress address_;
   td::Promise<RawAccountState> promise_;
   td::actor::ActorShared<> parent_;
-  ExtClient client_;
   LastBlockState last_block_;
+  ExtClient client_;
 
   void with_account_state(td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountState>> r_account_state) {
     check(do_with_account_state(std::move(r_account_state)));
@@ -675,11 +683,14 @@ class GetRawAccountState : public td::actor::Actor {
 
   td::Result<RawAccountState> do_with_account_state(
       ton::tl_object_ptr<ton::lite_api::liteServer_accountState> raw_account_state) {
+    auto size = raw_account_state->shard_proof_.size() + raw_account_state->proof_.size() +
+                raw_account_state->state_.size();
     auto account_state = create_account_state(std::move(raw_account_state));
     TRY_RESULT(info, account_state.validate(last_block_.last_block_id, address_));
     auto serialized_state = account_state.state.clone();
     RawAccountState res;
     res.info = std::move(info);
+    res.size = size;
     LOG_IF(ERROR, res.info.gen_utime > last_block_.utime) << res.info.gen_utime << " " << last_block_.utime;
     auto cell = res.info.root;
     std::ostringstream outp;
@@ -762,24 +773,13 @@ class GetRawAccountState : public td::actor::Actor {
     return res;
   }
 
-  void with_last_block(td::Result<LastBlockState> r_last_block) {
-    check(do_with_last_block(std::move(r_last_block)));
-  }
-
-  td::Status do_with_last_block(td::Result<LastBlockState> r_last_block) {
-    TRY_RESULT_ASSIGN(last_block_, std::move(r_last_block));
+  void start_up() override {
     client_.send_query(
         ton::lite_api::liteServer_getAccountState(
             ton::create_tl_lite_block_id(last_block_.last_block_id),
             ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
         [self = this](auto r_state) { self->with_account_state(std::move(r_state)); },
         last_block_.last_block_id.id.seqno);
-    return td::Status::OK();
-  }
-
-  void start_up() override {
-    client_.with_last_block(
-        [self = this](td::Result<LastBlockState> r_last_block) { self->with_last_block(std::move(r_last_block)); });
   }
 
   void check(td::Status status) {
@@ -793,7 +793,11 @@ class GetRawAccountState : public td::actor::Actor {
   }
 };
 
-TonlibClient::TonlibClient(td::unique_ptr<TonlibCallback> callback) : callback_(std::move(callback)) {
+constexpr size_t TonlibClient::ACCOUNT_STATE_CACHE_SIZE;
+
+TonlibClient::TonlibClient(td::unique_ptr<TonlibCallback> callback)
+    : callback_(std::move(callback))
+    , account_state_cache_(td::make_unique<AccountStateCache<RawAccountState>>(ACCOUNT_STATE_CACHE_SIZE)) {
 }
 TonlibClient::~TonlibClient() = default;
 
@@ -845,8 +849,15 @@ void TonlibClient::init_ext_client() {
   } else {
     auto lite_clients_size = config_.lite_clients.size();
     CHECK(lite_clients_size != 0);
-    auto lite_client_id = td::Random::fast(0, td::narrow_cast<int>(lite_clients_size) - 1);
-    auto& lite_client = config_.lite_clients[lite_client_id];
+    // use a random subset of lite servers
+    std::vector<size_t> lite_client_ids(lite_clients_size);
+    for (size_t i = 0; i < lite_clients_size; i++) {
+      auto j = static_cast<size_t>(td::Random::fast(0, td::narrow_cast<int>(i)));
+      lite_client_ids[i] = lite_client_ids[j];
+      lite_client_ids[j] = i;
+    }
+    lite_client_ids.resize(td::min(lite_clients_size, MAX_LITE_SERVERS));
+
     class Callback : public ExtClientLazy::Callback {
      public:
       explicit Callback(td::actor::ActorShared<> parent) : parent_(std::move(parent)) {
@@ -855,10 +866,15 @@ void TonlibClient::init_ext_client() {
      private:
       td::actor::ActorShared<> parent_;
     };
+    std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients;
+    for (auto lite_client_id : lite_client_ids) {
+      auto& lite_client = config_.lite_clients[lite_client_id];
+      ref_cnt_++;
+      clients.push_back(ExtClientLazy::create(lite_client.adnl_id, lite_client.address,
+                                              td::make_unique<Callback>(td::actor::actor_shared())));
+    }
     ext_client_outbound_ = {};
-    ref_cnt_++;
-    raw_client_ = ExtClientLazy::create(lite_client.adnl_id, lite_client.address,
-                                        td::make_unique<Callback>(td::actor::actor_shared()));
+    raw_client_ = ExtClientMulti::create(std::move(clients), ExtClientMulti::Options());
   }
 }
 
@@ -1321,6 +1337,7 @@ void TonlibClient::set_config(FullConfig full_config) {
   init_last_block(std::move(full_config.o_master_config));
   init_last_config();
   client_.set_client(get_client_ref());
+  account_state_cache_->clear();
 }
 
 td::Status TonlibClient::do_request(const tonlib_api::close& request,
@@ -1523,6 +1540,172 @@ td::Result<tonlib_api::object_ptr<tonlib_api::raw_transactions>> to_raw_transact
   return tonlib_api::make_object<tonlib_api::raw_transactions>(std::move(transactions), std::move(transaction_id));
 }
 
+class ValidateTransactions : public td::actor::Actor {
+ public:
+  ValidateTransactions(block::TransactionList list, std::vector<td::Ref<vm::Cell>> roots,
+                       td::Promise<tonlib_api::object_ptr<tonlib_api::raw_transactions>> promise)
+      : list_(std::move(list)), roots_(std::move(roots)), promise_(std::move(promise)) {
+  }
+
+ private:
+  block::TransactionList list_;
+  std::vector<td::Ref<vm::Cell>> roots_;
+  td::Promise<tonlib_api::object_ptr<tonlib_api::raw_transactions>> promise_;
+
+  td::Result<tonlib_api::object_ptr<tonlib_api::raw_transactions>> do_validate() {
+    TRY_RESULT_PREFIX(info, TRY_VM(list_.validate(std::move(roots_))), TonlibError::ValidateTransactions());
+    return to_raw_transactions(std::move(info));
+  }
+
+  void start_up() override {
+    promise_.set_result(do_validate());
+    stop();
+  }
+};
+
+// Fetches the transaction history of an account page by page.
+// The next page is requested as soon as the previous one is received, before the received page is validated
+// and converted by a separate actor. Only one page is in flight at a time, and the validation runs on the same
+// scheduler, so it overlaps only with the wait for the next page. Pages are passed to the callback in order.
+class GetTransactionHistoryStream : public td::actor::Actor {
+ public:
+  class Callback {
+   public:
+    virtual ~Callback() {
+    }
+    virtual void on_transactions(tonlib_api::object_ptr<tonlib_api::raw_transactions> transactions) = 0;
+  };
+
+  GetTransactionHistoryStream(ExtClientRef ext_client_ref, block::StdAddress address, ton::LogicalTime lt,
+                              ton::Bits256 hash, td::int32 limit, td::unique_ptr<Callback> callback,
+                              td::actor::ActorShared<> parent,
+                              td::Promise<tonlib_api::object_ptr<tonlib_api::internal_transactionId>> promise)
+      : address_(std::move(address))
+      , lt_(lt)
+      , hash_(hash)
+      , left_(limit)
+      , callback_(std::move(callback))
+      , parent_(std::move(parent))
+      , promise_(std::move(promise)) {
+    client_.set_client(ext_client_ref);
+  }
+
+ private:
+  static constexpr td::int32 MAX_PAGE_SIZE = 10;
+
+  block::StdAddress address_;
+  // the next transaction to request
+  ton::LogicalTime lt_;
+  ton::Bits256 hash_;
+  td::int32 left_;
+  td::unique_ptr<Callback> callback_;
+  ExtClient client_;
+  td::actor::ActorShared<> parent_;
+  td::Promise<tonlib_api::object_ptr<tonlib_api::internal_transactionId>> promise_;
+
+  bool has_query_{false};
+  td::uint32 next_page_id_{0};
+  td::uint32 next_ready_page_id_{0};
+  std::map<td::uint32, tonlib_api::object_ptr<tonlib_api::raw_transactions>> ready_pages_;
+
+  void check(td::Status status) {
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      stop();
+    }
+  }
+
+  void start_up() override {
+    request_page();
+    try_finish();
+  }
+
+  void request_page() {
+    if (lt_ == 0 || left_ <= 0) {
+      return;
+    }
+    auto count = td::min(left_, MAX_PAGE_SIZE);
+    has_query_ = true;
+    client_.send_query(
+        ton::lite_api::liteServer_getTransactions(
+            count, ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr), lt_,
+            hash_),
+        [self = this, page_id = next_page_id_++, lt = lt_, hash = hash_](auto r_transactions) {
+          self->on_page(page_id, lt, hash, std::move(r_transactions));
+        });
+  }
+
+  void on_page(td::uint32 page_id, ton::LogicalTime lt, ton::Bits256 hash,
+               td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions) {
+    has_query_ = false;
+    check(do_on_page(page_id, lt, hash, std::move(r_transactions)));
+  }
+
+  td::Status do_on_page(td::uint32 page_id, ton::LogicalTime lt, ton::Bits256 hash,
+                        td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions) {
+    TRY_RESULT(transactions, std::move(r_transactions));
+    block::TransactionList list;
+    list.lt = lt;
+    list.hash = hash;
+    for (auto& id : transactions->ids_) {
+      list.blkids.push_back(ton::create_block_id(std::move(id)));
+    }
+    TRY_RESULT_PREFIX(roots, vm::std_boc_deserialize_multi(std::move(transactions->transactions_)),
+                      TonlibError::ValidateTransactions());
+    if (roots.empty()) {
+      return TonlibError::ValidateTransactions();
+    }
+    // a lite server may return less transactions than requested
+    left_ -= static_cast<td::int32>(roots.size());
+
+    // the previous transaction id is taken from the page before it is validated,
+    // the next page is validated against it anyway
+    TRY_STATUS_PREFIX(TRY_VM(set_prev_transaction(roots.back())), TonlibError::ValidateTransactions());
+    request_page();
+
+    td::actor::create_actor<ValidateTransactions>(
+        "ValidateTransactions", std::move(list), std::move(roots),
+        td::promise_send_closure(actor_id(this), &GetTransactionHistoryStream::on_page_validated, page_id))
+        .release();
+    return td::Status::OK();
+  }
+
+  td::Status set_prev_transaction(const td::Ref<vm::Cell>& root) {
+    block::gen::Transaction::Record trans;
+    if (!tlb::unpack_cell(root, trans)) {
+      return td::Status::Error("Failed to unpack Transaction");
+    }
+    lt_ = trans.prev_trans_lt;
+    hash_ = trans.prev_trans_hash;
+    return td::Status::OK();
+  }
+
+  void on_page_validated(td::uint32 page_id, td::Result<tonlib_api::object_ptr<tonlib_api::raw_transactions>> r_page) {
+    if (r_page.is_error()) {
+      return check(r_page.move_as_error());
+    }
+    ready_pages_[page_id] = r_page.move_as_ok();
+    while (!ready_pages_.empty() && ready_pages_.begin()->first == next_ready_page_id_) {
+      callback_->on_transactions(std::move(ready_pages_.begin()->second));
+      ready_pages_.erase(ready_pages_.begin());
+      next_ready_page_id_++;
+    }
+    try_finish();
+  }
+
+  void try_finish() {
+    if (has_query_ || next_ready_page_id_ != next_page_id_) {
+      return;
+    }
+    promise_.set_value(tonlib_api::make_object<tonlib_api::internal_transactionId>(lt_, hash_.as_slice().str()));
+    stop();
+  }
+
+  void hangup() override {
+    check(TonlibError::Cancelled());
+  }
+};
+
 // Raw
 
 auto to_any_promise(td::Promise<tonlib_api::object_ptr<tonlib_api::ok>>&& promise) {
@@ -1592,6 +1775,50 @@ td::Status TonlibClient::do_request(tonlib_api::raw_getTransactions& request,
       promise.wrap(to_raw_transactions));
   return td::Status::OK();
 }
+td::Status TonlibClient::do_request(tonlib_api::raw_getTransactionHistory& request,
+                                    td::Promise<object_ptr<tonlib_api::internal_transactionId>>&& promise) {
+  if (!request.account_address_) {
+    return TonlibError::EmptyField("account_address");
+  }
+  if (!request.from_transaction_id_) {
+    return TonlibError::EmptyField("from_transaction_id");
+  }
+  if (request.limit_ <= 0) {
+    return TonlibError::InvalidField("limit", "must be positive");
+  }
+  TRY_RESULT(account_address, get_account_address(request.account_address_->account_address_));
+  auto lt = request.from_transaction_id_->lt_;
+  auto hash_str = request.from_transaction_id_->hash_;
+  if (hash_str.size() != 32) {
+    return td::Status::Error(400, "Invalid transaction id hash size");
+  }
+  td::Bits256 hash;
+  hash.as_slice().copy_from(hash_str);
+
+  class Callback : public GetTransactionHistoryStream::Callback {
+   public:
+    Callback(td::actor::ActorId<TonlibClient> parent, std::string account_address)
+        : parent_(std::move(parent)), account_address_(std::move(account_address)) {
+    }
+    void on_transactions(object_ptr<tonlib_api::raw_transactions> transactions) override {
+      object_ptr<tonlib_api::Object> update = tonlib_api::make_object<tonlib_api::updateRawTransactions>(
+          tonlib_api::make_object<tonlib_api::accountAddress>(account_address_), std::move(transactions));
+      send_closure(parent_, &TonlibClient::on_update, std::move(update));
+    }
+
+   private:
+    td::actor::ActorId<TonlibClient> parent_;
+    std::string account_address_;
+  };
+
+  auto callback = td::make_unique<Callback>(actor_id(this), request.account_address_->account_address_);
+  auto actor_id = actor_id_++;
+  actors_[actor_id] = td::actor::create_actor<GetTransactionHistoryStream>(
+      "GetTransactionHistoryStream", client_.get_client(), account_address, lt, hash, request.limit_,
+      std::move(callback), actor_shared(this, actor_id), std::move(promise));
+  return td::Status::OK();
+}
+
 td::Result<KeyStorage::InputKey> from_tonlib(tonlib_api::inputKeyRegular& input_key) {
   if (!input_key.key_) {
     return TonlibError::EmptyField("key");
@@ -2245,7 +2472,17 @@ td::Status TonlibClient::do_request(const tonlib_api::smc_runGetMethod& request,
   }
   TRY_STATUS(std::move(status));
   args.set_stack(std::move(stack));
+  vm::VmProfiler profiler;
+  bool need_profile = GET_VERBOSITY_LEVEL() >= VERBOSITY_NAME(vm_profile);
+  if (need_profile) {
+    args.set_profiler(&profiler);
+  }
   auto res = smc->run_get_method(std::move(args));
+  if (need_profile) {
+    VLOG(vm_profile) << "get method profile of smc " << request.id_ << ":\n"
+                     << profiler.to_string() << "folded stacks:\n"
+                     << profiler.to_folded_stacks();
+  }
 
   // smc.runResult gas_used:int53 stack:vector<tvm.StackEntry> exit_code:int32 = smc.RunResult;
   std::vector<object_ptr<tonlib_api::tvm_StackEntry>> res_stack;
@@ -2505,15 +2742,42 @@ tonlib_api::object_ptr<tonlib_api::Object> TonlibClient::do_static_request(const
 
 td::Status TonlibClient::do_request(int_api::GetAccountState request,
                                     td::Promise<td::unique_ptr<AccountState>>&& promise) {
-  auto actor_id = actor_id_++;
-  actors_[actor_id] = td::actor::create_actor<GetRawAccountState>(
-      "GetAccountState", client_.get_client(), request.address, actor_shared(this, actor_id),
+  td::Promise<RawAccountState> P =
       promise.wrap([address = request.address, wallet_id = wallet_id_](auto&& state) mutable {
         return td::make_unique<AccountState>(std::move(address), std::move(state), wallet_id);
-      }));
+      });
+  client_.with_last_block([self = this, address = request.address,
+                           promise = std::move(P)](td::Result<LastBlockState> r_last_block) mutable {
+    TRY_RESULT_PROMISE(promise, last_block, std::move(r_last_block));
+    self->get_raw_account_state(std::move(address), std::move(last_block), std::move(promise));
+  });
   return td::Status::OK();
 }
 
+void TonlibClient::get_raw_account_state(block::StdAddress address, LastBlockState last_block,
+                                         td::Promise<RawAccountState> promise) {
+  AccountStateCacheKey key{last_block.last_block_id, address};
+  auto o_state = account_state_cache_->get(key);
+  if (o_state) {
+    VLOG(tonlib_query) << "account state cache hit: " << account_state_cache_->get_stats();
+    return promise.set_value(o_state.unwrap());
+  }
+  if (!account_state_cache_->add_query(key, std::move(promise))) {
+    return;
+  }
+  auto P = promise_send_closure(actor_id(this), &TonlibClient::finish_get_raw_account_state, key);
+  auto actor_id = actor_id_++;
+  actors_[actor_id] =
+      td::actor::create_actor<GetRawAccountState>("GetAccountState", client_.get_client(), std::move(address),
+                                                  std::move(last_block), actor_shared(this, actor_id), std::move(P));
+}
+
+void TonlibClient::finish_get_raw_account_state(AccountStateCacheKey key, td::Result<RawAccountState> r_state) {
+  size_t size = r_state.is_ok() ? r_state.ok().size : 0;
+  account_state_cache_->finish_query(key, std::move(r_state), size);
+  VLOG(tonlib_query) << "account state cache miss: " << account_state_cache_->get_stats();
+}
+
 td::Status TonlibClient::do_request(int_api::GetPrivateKey request, td::Promise<KeyStorage::PrivateKey>&& promise) {
   TRY_RESULT(pk, key_storage_.load_private_key(std::move(request.input_key)));
   promise.set_value(std::move(pk));
@@ -20,6 +20,7 @@
 
 #include "TonlibCallback.h"
 
+#include "tonlib/AccountStateCache.h"
 #include "tonlib/Config.h"
 #include "tonlib/ExtClient.h"
 #include "tonlib/ExtClientOutbound.h"
@@ -44,6 +45,7 @@ inline std::string to_string(const int_api::SendMessage&) {
 }
 }  // namespace int_api
 class AccountState;
+struct RawAccountState;
 class Query;
 
 class TonlibClient : public td::actor::Actor {
@@ -76,6 +78,7 @@ class TonlibClient : public td::actor::Actor {
   LastBlockStorage last_block_storage_;
 
   // network
+  static constexpr size_t MAX_LITE_SERVERS = 4;
   td::actor::ActorOwn<ton::adnl::AdnlExtClient> raw_client_;
   td::actor::ActorId<ExtClientOutbound> ext_client_outbound_;
   td::actor::ActorOwn<LastBlock> raw_last_block_;
@@ -84,6 +87,10 @@ class TonlibClient : public td::actor::Actor {
 
   td::CancellationTokenSource source_;
 
+  // Account states validated against known masterchain blocks
+  static constexpr size_t ACCOUNT_STATE_CACHE_SIZE = 64 << 20;
+  td::unique_ptr<AccountStateCache<RawAccountState>> account_state_cache_;
+
   std::map<td::int64, td::actor::ActorOwn<>> actors_;
   td::int64 actor_id_{1};
 
@@ -220,6 +227,8 @@ class TonlibClient : public td::actor::Actor {
                         td::Promise<object_ptr<tonlib_api::raw_accountState>>&& promise);
   td::Status do_request(tonlib_api::raw_getTransactions& request,
                         td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise);
+  td::Status do_request(tonlib_api::raw_getTransactionHistory& request,
+                        td::Promise<object_ptr<tonlib_api::internal_transactionId>>&& promise);
 
   td::Status do_request(const tonlib_api::testWallet_init& request, td::Promise<object_ptr<tonlib_api::ok>>&& promise);
   td::Status do_request(const tonlib_api::testWallet_sendGrams& request,
@@ -308,6 +317,9 @@ class TonlibClient : public td::actor::Actor {
                         td::Promise<object_ptr<tonlib_api::smc_runResult>>&& promise);
 
   td::Status do_request(int_api::GetAccountState request, td::Promise<td::unique_ptr<AccountState>>&&);
+  void get_raw_account_state(block::StdAddress address, LastBlockState last_block,
+                             td::Promise<RawAccountState> promise);
+  void finish_get_raw_account_state(AccountStateCacheKey key, td::Result<RawAccountState> r_state);
   td::Status do_request(int_api::GetPrivateKey request, td::Promise<KeyStorage::PrivateKey>&&);
   td::Status do_request(int_api::SendMessage request, td::Promise<td::Unit>&& promise);
 
@@ -1261,6 +1261,13 @@ int main(int argc, char* argv[]) {
     SET_VERBOSITY_LEVEL(VERBOSITY_NAME(FATAL) + verbosity);
     return (verbosity >= 0 && verbosity <= 20) ? td::Status::OK() : td::Status::Error("verbosity must be 0..20");
   });
+  p.add_option('P', "profile-vm", "log per-instruction and per-code-cell gas profiles of runmethod", [&]() {
+    auto res = tonlib::TonlibClient::static_request(make_object<tonlib_api::setLogTagVerbosityLevel>("vm_profile", 1));
+    if (res->get_id() == tonlib_api::error::ID) {
+      return td::Status::Error(to_string(res));
+    }
+    return td::Status::OK();
+  });
   p.add_option('C', "config-force", "set lite server config, drop config related blockchain cache", [&](td::Slice arg) {
     TRY_RESULT(data, td::read_file_str(arg.str()));
     options.config = std::move(data);
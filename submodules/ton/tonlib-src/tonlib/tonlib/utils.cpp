@@ -24,5 +24,6 @@ int VERBOSITY_NAME(tonlib_query) = VERBOSITY_NAME(DEBUG);
 int VERBOSITY_NAME(last_block) = VERBOSITY_NAME(DEBUG);
 int VERBOSITY_NAME(last_config) = VERBOSITY_NAME(DEBUG);
 int VERBOSITY_NAME(lite_server) = VERBOSITY_NAME(DEBUG);
+int VERBOSITY_NAME(vm_profile) = VERBOSITY_NAME(DEBUG);
 
 }  // namespace tonlib
@@ -27,4 +27,5 @@ extern int VERBOSITY_NAME(tonlib_query);
 extern int VERBOSITY_NAME(last_block);
 extern int VERBOSITY_NAME(last_config);
 extern int VERBOSITY_NAME(lite_server);
+extern int VERBOSITY_NAME(vm_profile);
 }  // namespace tonlib